@@ -109,6 +109,28 @@ struct SpatialSelectRect {
     bool select_add;
 };
 
+//! Action types of ActionFeatureLayerInterface::EncodeActions. An action is SpatialActionWidth integers: the type, an
+//! argument and two points, x0, y0, x1, y1.
+enum class SpatialActionType {
+    //! Skipped.
+    NoOp = 0,
+    //! Self targeted command, the argument is the ability id.
+    UnitCommand = 1,
+    //! Command targeting screen point 0, the argument is the ability id.
+    UnitCommandScreen = 2,
+    //! Command targeting minimap point 0, the argument is the ability id.
+    UnitCommandMinimap = 3,
+    //! Camera move centered on minimap point 0.
+    CameraMove = 4,
+    //! Selection of screen point 0, the argument is the PointSelectionType.
+    SelectPoint = 5,
+    //! Selection of the screen rectangle from point 0 to point 1, an argument other than 0 adds to the selection.
+    SelectRect = 6
+};
+
+//! Number of integers per action of ActionFeatureLayerInterface::EncodeActions.
+const int SpatialActionWidth = 6;
+
 //! Possible actions for feature layers.
 struct SpatialActions {
     //! Commands to selected units.
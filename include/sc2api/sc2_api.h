@@ -2,12 +2,18 @@
 
 #include "sc2_interfaces.h"
 #include "sc2_agent.h"
+#include "sc2_batch_coordinator.h"
 #include "sc2_common.h"
 #include "sc2_control_interfaces.h"
 #include "sc2_coordinator.h"
 #include "sc2_game_settings.h"
 #include "sc2_map_info.h"
+#include "sc2_process_pool.h"
+#include "sc2_replay_farm.h"
+#include "sc2_replay_index.h"
+#include "sc2_replay_journal.h"
 #include "sc2_replay_observer.h"
+#include "sc2_step_profiler.h"
 #include "sc2_typeenums.h"
 #include "sc2_unit.h"
 
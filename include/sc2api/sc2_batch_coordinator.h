@@ -0,0 +1,75 @@
+/*! \file sc2_batch_coordinator.h
+    \brief Runs several independent games in one process.
+
+    Each game is an ordinary Coordinator with its own clients and StarCraft II processes. The batch steps all of them
+    on one worker pool and shares one GameDataCache between them. A game is only given a worker once its StarCraft II
+    processes have finished the step, so games that are still simulating don't hold workers that games with a ready
+    observation could use.
+*/
+
+#pragma once
+
+#include "sc2api/sc2_game_data_cache.h"
+#include "sc2utils/sc2_thread_pool.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sc2 {
+
+class Coordinator;
+
+//! Coordinator of several independent games.
+class BatchCoordinator {
+public:
+    //! \param thread_count Number of worker threads shared by all games, 0 uses one per hardware core.
+    //! \param pin_threads Pins each worker to its own core, on platforms that support it.
+    explicit BatchCoordinator(size_t thread_count = 0, bool pin_threads = false);
+    //! Waits for the games that are still being updated.
+    ~BatchCoordinator();
+
+    BatchCoordinator(const BatchCoordinator&) = delete;
+    BatchCoordinator& operator=(const BatchCoordinator&) = delete;
+
+    //! Adds a game. Set the coordinator up as usual first, i.e. launch StarCraft and start the game or set the
+    //! replays to run. From then on only the batch may update it. Must not be called during Update.
+    //! \param game The game, isn't owned and must outlive the batch.
+    void AddGame(Coordinator* game);
+
+    //! \return The number of games added.
+    size_t GetGameCount() const;
+    //! \return The game at index.
+    Coordinator* GetGame(size_t index) const;
+    //! \return False once Coordinator::Update of the game has returned false.
+    bool IsRunning(size_t index) const;
+
+    //! Updates every game whose StarCraft II processes are ready, on the worker pool. Games don't step in lockstep:
+    //! a game is updated again as soon as its previous update finished and SC2 has responded, no matter how far the
+    //! other games are. Returns once at least one game has finished an update.
+    //! \return False once no game is running.
+    bool Update();
+
+    ThreadPool& GetThreadPool() { return thread_pool_; }
+    GameDataCache& GetGameDataCache() { return game_data_cache_; }
+
+private:
+    struct Game {
+        Coordinator* coordinator;
+        bool running;
+        bool updating;
+    };
+
+    void UpdateGame(size_t index, Coordinator* game);
+
+    std::vector<Game> games_;
+    ThreadPool thread_pool_;
+    GameDataCache game_data_cache_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable update_finished_;
+    size_t updates_finished_;
+};
+
+}
@@ -40,6 +40,43 @@ enum class ClientError {
     WrongGameVersion,    /*! A replay was attempted to be loaded in the wrong game version. */
 };
 
+//! The events a client consumes. Each family that's off is neither computed nor dispatched, e.g. a bot that never
+//! overrides OnUnitIdle can turn unit_idle off. All are on by default.
+struct EventSubscriptions {
+    EventSubscriptions();
+
+    bool unit_destroyed;
+    bool unit_created;
+    bool unit_enter_vision;
+    bool unit_idle;
+    bool building_construction_complete;
+    bool upgrade_completed;
+    //! OnNydusDetected and OnNuclearLaunchDetected.
+    bool alerts;
+    //! Also collects the events of each step in a list, see Client::GetEvents.
+    bool event_list;
+};
+
+enum class ClientEventType {
+    UnitDestroyed,
+    UnitCreated,
+    UnitEnterVision,
+    UnitIdle,
+    BuildingConstructionComplete,
+    UpgradeCompleted,
+    NydusDetected,
+    NuclearLaunchDetected
+};
+
+//! An event in the list of a step.
+struct ClientEvent {
+    ClientEventType type;
+    //! The unit of unit events, nullptr otherwise.
+    const Unit* unit;
+    //! The upgrade of UpgradeCompleted.
+    UpgradeID upgrade;
+};
+
 //! A set of common events a user can override in their derived bot or replay observer class.
 class ClientEvents {
 public:
@@ -113,6 +150,15 @@ public:
     ControlInterface* Control();
     const ControlInterface* Control() const;
 
+    //! Chooses the events that are computed and dispatched every step. May be changed during a game, events turned on
+    //! then are about what changes from the units there are at that point.
+    void SetEventSubscriptions(const EventSubscriptions& subscriptions);
+    const EventSubscriptions& GetEventSubscriptions() const;
+
+    //! The events of the last step in the order they were dispatched, if EventSubscriptions::event_list is set. Valid
+    //! from the OnStep the events were dispatched before until the next step.
+    const std::vector<ClientEvent>& GetEvents() const;
+
     void Reset();
 
 private:
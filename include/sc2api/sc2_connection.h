@@ -10,6 +10,7 @@
 #include <deque>
 #include <functional>
 #include <atomic>
+#include <vector>
 
 struct mg_connection;
 
@@ -59,6 +60,11 @@ public:
 
     void SetConnectionClosedCallback(std::function<void()> callback);
 
+    //! Sets a function that is called off the civetweb thread each time a response is queued, e.g. to wake up a thread
+    //! that waits on several connections at once. It must not call back into this connection.
+    //! \param callback A functor or lambda that represents the callback, or nullptr to remove it.
+    void SetResponseCallback(std::function<void()> callback);
+
     //! Whether or not the connection is valid.
     //!< \return true if the connection is valid, false otherwise.
     bool HasConnection() const;
@@ -85,11 +91,13 @@ public:
 private:
     bool verbose_;                                   //!< Will print extra information to console if enabled.
 
+    std::vector<char> send_buffer_;                  //!< Serialized request, kept between sends.
     std::deque<SC2APIProtocol::Response*> queue_; //!< A queue that contains responses received off the socket.
     std::mutex mutex_;                               //!< Mutex used in conjunction with the condition.
     std::condition_variable condition_;              //!< A condition that is signaled when a message has been received off the socket.
 
     std::atomic_bool has_response_;                  //!< Thread safe bool to check whether the queue is not empty.
+    std::function<void()> response_callback_;        //!< Called after a response is queued, guarded by mutex_.
 };
 
 }
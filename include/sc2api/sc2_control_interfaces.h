@@ -12,6 +12,23 @@ namespace sc2 {
 
 struct ProcessInfo;
 struct InterfaceSettings;
+class GameDataCache;
+class ReplayIndex;
+class StepProfiler;
+
+// Outcome of each request of a combined step, see ControlInterface::RequestStepObservation.
+struct StepRequestStatus {
+    StepRequestStatus() :
+        actions(true),
+        step(true),
+        observation(true) {
+    }
+
+    // The deferred actions sent before the step got a response without errors.
+    bool actions;
+    bool step;
+    bool observation;
+};
 
 class ControlInterface {
 public:
@@ -31,6 +48,13 @@ public:
     virtual bool Step(int count = 1) = 0;
     virtual bool WaitStep() = 0;
 
+    // Sends the step and the observation request together, the game answers the observation as soon as the step has
+    // been simulated. With actions sent deferred before, a step is a single round trip.
+    virtual bool RequestStepObservation(int count = 1) = 0;
+    // Waits for the requests of RequestStepObservation and updates the observation, as WaitStep.
+    virtual bool WaitStepObservation() = 0;
+    virtual const StepRequestStatus& GetStepRequestStatus() const = 0;
+
     virtual bool SaveReplay(const std::string& path) = 0;
 
     virtual bool Ping() = 0;
@@ -68,6 +92,14 @@ public:
     virtual void ClearProtocolErrors() = 0;
 
     virtual void UseGeneralizedAbility(bool value) = 0;
+    // Ability and unit type data are looked up in and added to cache, which isn't owned. nullptr queries every game.
+    virtual void SetGameDataCache(GameDataCache* cache) = 0;
+    // Phases of the step are recorded in profiler, which isn't owned, under client_id. nullptr records nothing.
+    virtual void SetStepProfiler(StepProfiler* profiler, int client_id) = 0;
+    virtual StepProfiler* GetStepProfiler() const = 0;
+    virtual int GetStepProfilerClient() const = 0;
+    // Takes the camera move of DebugInterface::DebugMoveCamera, the action interfaces send it with their actions.
+    virtual bool TakeCameraMove(Point2D& pos) = 0;
 
     // Save/Load.
     virtual void Save() = 0;
@@ -100,6 +132,11 @@ public:
     virtual void UseGeneralizedAbility(bool value) = 0;
 
     virtual const ReplayInfo& GetReplayInfo() const = 0;
+    //! Sets the info of the next replay when it was gathered on another client, instead of calling GatherReplayInfo.
+    virtual void SetReplayInfo(const ReplayInfo& replay_info) = 0;
+    //! Makes GatherReplayInfo take the info of replays in the index from it instead of SC2, and add the others to it.
+    //! Indexed replays skip the request and with it the data download. nullptr stops using the index.
+    virtual void SetReplayIndex(ReplayIndex* replay_index) = 0;
 };
 
 }
@@ -18,6 +18,12 @@ namespace sc2 {
 class Agent;
 class ReplayObserver;
 class CoordinatorImp;
+class ThreadPool;
+class GameDataCache;
+class ProcessPool;
+class ReplayIndex;
+class ReplayJournal;
+class StepProfiler;
 
 //! Coordinator of one or more clients. Used to start, step and stop games and replays.
 class Coordinator {
@@ -41,6 +47,73 @@ public:
     //! \param value True to multithread, false otherwise.
     void SetMultithreaded(bool value);
 
+    //! Overlaps each bot's OnStep with the simulation of the next game loops, for throughput bound non realtime games
+    //! such as data collection. Off by default, replay observers and realtime games aren't affected. Each Update then:
+    //!     1. Waits for the step in flight and sends the actions issued in the previous OnStep.
+    //!     2. Steps the remaining step size - action_delay game loops, if any, and gets the observation.
+    //!     3. Requests a step of action_delay game loops and calls OnStep while the game simulates it.
+    //! Bots still get an observation every step size game loops, but actions issued in OnStep for game loop L are
+    //! applied at game loop L + action_delay instead of L. Requests a bot makes in OnStep, e.g. queries or debug draws,
+    //! still work but first wait for the step in flight.
+    //! \param action_delay Game loops simulated while OnStep runs, at most the step size. 0 turns pipelining off.
+    void SetStepPipelining(int action_delay);
+
+    //! Steps each bot on its own as soon as its responses arrive, instead of stepping all bots, waiting for all of them
+    //! and then running their OnStep. Off by default, only affects non realtime games. Each bot's update waits for its
+    //! step, gets the observation, calls OnStep, sends the actions and immediately requests its next step, so a slow
+    //! bot no longer delays the OnStep of the others. The only synchronization left is the one SC2 requires: in a
+    //! multiplayer game a step finishes once every player has requested it. Update still returns after every bot has
+    //! had one OnStep. Works with SetMultithreaded, where bots run in parallel as they become ready, and with
+    //! SetStepPipelining.
+    //! \param value True to step bots asynchronously, false otherwise.
+    void SetAsyncAgents(bool value);
+
+    //! Doesn't wait for the game's response to the actions bots send each step, see ActionInterface::SetDeferredResponses.
+    //! The response is read before the step's, which removes a round trip from every step. The action results are then
+    //! available to bots one step later. Off by default.
+    //! \param value True to defer action responses, false otherwise.
+    void SetDeferredActionResponses(bool value);
+
+    //! Sends the actions, the step and the observation request of a bot or replay observer back to back and waits once,
+    //! see ControlInterface::RequestStepObservation, instead of a round trip for each. Turns on deferred action responses
+    //! for bots. Bots see the same observations and events. Only affects the default stepping, not SetStepPipelining or
+    //! SetAsyncAgents. Off by default.
+    //! \param value True to combine the requests, false otherwise.
+    void SetCombinedStepRequests(bool value);
+
+    //! Sets the persistent worker threads used to step bots or replays in parallel. The threads are created once and
+    //! reused every step.
+    //! \param thread_count Number of worker threads, 0 uses one per bot or replay observer.
+    //! \param pin_threads Pins each worker to its own core, on platforms that support it.
+    void SetWorkerThreads(size_t thread_count, bool pin_threads = false);
+
+    //! Steps bots or replays on a pool owned by the caller instead of the coordinator's own, e.g. to share workers
+    //! between coordinators.
+    //! \param thread_pool The pool to use, must outlive the coordinator. nullptr goes back to the coordinator's own pool.
+    void SetThreadPool(ThreadPool* thread_pool);
+
+    //! Shares the ability and unit type data of bots and replay observers through cache, so it's only queried once
+    //! per game version and map.
+    //! \param cache The cache to use, must outlive the coordinator. nullptr queries it in every game.
+    void SetGameDataCache(GameDataCache* cache);
+
+    //! Takes the StarCraft II processes of bots and replay observers from a pool of spare processes launched ahead of
+    //! time, instead of launching them when needed. This mostly speeds up relaunching a replay observer after a crash
+    //! or into another game version, and starting coordinators after the first. The processes taken use the pool's
+    //! settings, except for the executable and data version.
+    //! \param process_pool The pool, must outlive the coordinator. nullptr launches processes as needed.
+    void SetProcessPool(ProcessPool* process_pool);
+
+    //! Times the phases of every step, per bot and replay observer, see StepProfiler. The coordinator records its
+    //! Update as client 0, bots are clients 1 to n in the order they were added and replay observers follow. Off by
+    //! default, a disabled profiler costs a pointer check per phase.
+    //! \param value True to profile, false to stop and drop the samples.
+    //! \param trace Also keeps every sample for StepProfiler::WriteChromeTrace.
+    void SetStepProfiling(bool value, bool trace = false);
+
+    //! \return The step profiler, nullptr if profiling is off.
+    StepProfiler* GetStepProfiler() const;
+
     //! Specifies whether the game should run in realtime or not. If the game is running in real time that means the coordinator is
     //! not stepping it forward. The game is running and your bot reaches into it asynchronously to read state.
     //! \param value True to be realtime, false otherwise.
@@ -106,6 +179,29 @@ public:
     // \sa ReplayObserver
     void AddReplayObserver(ReplayObserver* replay_observer);
 
+    //! Runs replays as a farm: dedicated StarCraft II processes gather the info of upcoming replays while the replay
+    //! observers play the current ones, and every idle observer immediately takes the next replay from a shared work
+    //! stealing queue, see ReplayFarm. Without it an idle observer gathers the info and filters the replays itself,
+    //! one observer after the other. Off by default.
+    //! \param info_processes Number of extra processes gathering replay info, 0 turns the farm off.
+    //! \param prefetch_depth Replays with gathered info kept ready per replay observer.
+    void SetReplayFarm(size_t info_processes, size_t prefetch_depth = 2);
+
+    //! Takes replay info from the index instead of asking SC2 for it, and adds the info of new replays to it. The
+    //! replay list is also ordered by the base build of the indexed replays, so replay observers run all replays of a
+    //! version before relaunching into the next. Loading and saving the index is up to the caller.
+    //! \param replay_index The index, must outlive the coordinator. nullptr stops using it.
+    void SetReplayIndex(ReplayIndex* replay_index);
+
+    //! Records the outcome of every replay in the journal, and skips the replays it reports as finished, ignored or
+    //! failed too often. With the same journal a run stopped by a crash resumes where it left off. Opening it is up to
+    //! the caller.
+    //! \param replay_journal The journal, must outlive the coordinator. nullptr stops using it.
+    void SetReplayJournal(ReplayJournal* replay_journal);
+
+    //! Counters of the replays run so far, including the relaunches of replay observers and the time they took.
+    ReplayStats GetReplayStats() const;
+
     // Start-up.
 
     //! Uses settings gathered from LoadSettings, specifically the path to the executable, to run StarCraft II.
@@ -202,6 +298,14 @@ public:
     std::string GetExePath() const;
 
 private:
+    friend class BatchCoordinator;
+
+    //! Sends the step requests of a non realtime update without waiting for them. Update does this itself if it
+    //! hasn't been done.
+    void RequestSteps();
+    //! Returns true if Update wouldn't have to wait for SC2 to finish a step.
+    bool IsReadyToUpdate();
+
     CoordinatorImp* imp_;
 };
 
@@ -0,0 +1,45 @@
+/*! \file sc2_game_data_cache.h
+    \brief Game data shared between the clients of several games in one process.
+*/
+
+#pragma once
+
+#include "sc2api/sc2_data.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sc2 {
+
+//! Thread safe store of the ability and unit type data SC2 reports for a game. The data only depends on the game version
+//! and the map, so clients sharing a cache query and parse it once per version and map instead of once per game.
+//! Set it with Coordinator::SetGameDataCache, a BatchCoordinator shares one between all of its games.
+class GameDataCache {
+public:
+    //! Key of the data for a game.
+    //!< \param base_build The base build of the SC2 process.
+    //!< \param data_version The data version of the SC2 process.
+    //!< \param map_path GameInfo::local_map_path of the game.
+    static std::string MakeKey(uint32_t base_build, const std::string& data_version, const std::string& map_path);
+
+    //! Copies the cached abilities for key into abilities.
+    //!< \return False if there are none.
+    bool GetAbilities(const std::string& key, Abilities& abilities) const;
+    void SetAbilities(const std::string& key, const Abilities& abilities);
+
+    //! Copies the cached unit types for key into unit_types.
+    //!< \return False if there are none.
+    bool GetUnitTypes(const std::string& key, UnitTypes& unit_types) const;
+    void SetUnitTypes(const std::string& key, const UnitTypes& unit_types);
+
+    void Clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Abilities> abilities_;
+    std::unordered_map<std::string, UnitTypes> unit_types_;
+};
+
+}
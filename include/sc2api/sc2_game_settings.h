@@ -108,6 +108,22 @@ struct ReplaySettings {
     uint32_t player_id;
 };
 
+//! Counters of a replay run, see Coordinator::GetReplayStats.
+struct ReplayStats {
+    ReplayStats();
+
+    //! Replays sent to an observer to load.
+    uint32_t replays_loaded;
+    //! Replays rejected by ReplayObserver::IgnoreReplay or whose info couldn't be read.
+    uint32_t replays_ignored;
+    //! Replay observer processes relaunched, for any reason.
+    uint32_t relaunches;
+    //! Of those, relaunches into the game version of a replay.
+    uint32_t version_relaunches;
+    //! Wall time spent relaunching, during which the observers couldn't run replays.
+    double relaunch_seconds;
+};
+
 //! Game status.
 enum class AppState {
     normal,         // The game application has behaved normally.
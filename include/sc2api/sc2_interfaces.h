@@ -358,12 +358,27 @@ public:
     //! This function sends out all batched unit commands. You DO NOT need to call this function in non real time simulations since
     //! it is automatically called when stepping the simulation forward. You only need to call this function in a real time simulation.
     //! For example, if you wanted to move 20 marines to some position on the map you'd want to batch all of those unit commands and
-    //! send them at once.
+    //! send them at once. Move, attack, patrol, hold position, stop and harvest commands giving the same order are merged
+    //! into one with all their units, and such a command is dropped if its unit gets the same ability again later in the
+    //! batch without queueing it. All other commands, e.g. spells or training, are sent as issued.
     virtual void SendActions() = 0;
+
+    //! Makes SendActions return without waiting for the game's response, saving a round trip every step. The response is
+    //! read right before the one of the next request, usually the step. Off by default.
+    //!< \param value True to defer the response, false to wait for it in SendActions.
+    virtual void SetDeferredResponses(bool value) = 0;
+
+    //! Results the game reported for the actions of the last SendActions whose response has been read, one per action sent
+    //! after merging. The values are those of SC2APIProtocol::ActionResult, 1 meaning success. With deferred responses these
+    //! are the results of the previous step's actions from the next OnStep on.
+    //!< \return Array of action results.
+    virtual const std::vector<uint32_t>& GetActionResults() const = 0;
 };
 
 //! The ActionFeatureLayerInterface emulates UI actions in feature layer. Not available in replays.
 //! Guaranteed to be valid when the OnStep event is called.
+//! Points outside the feature layer resolution are dropped. A camera move replaces the one before it if no action on
+//! the screen came in between, and a selection repeating the one right before it is dropped.
 class ActionFeatureLayerInterface {
 public:
     virtual ~ActionFeatureLayerInterface() = default;
@@ -392,9 +407,24 @@ public:
     //!< \param add_to_selection Will add newly selected units to an existing selection.
     virtual void Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection = false) = 0;
 
+    //! Adds a batch of actions from a flat array of integers, e.g. the output of a policy, SpatialActionWidth integers
+    //! per action as described by SpatialActionType.
+    //!< \param data The actions, action_count * SpatialActionWidth integers.
+    //!< \param action_count The number of actions.
+    //!< \return The number of actions accepted, the others were of an unknown type or outside the feature layers.
+    //! The default implementation passes the actions on to the functions above and only rejects those of an unknown
+    //! type or with an invalid argument.
+    virtual size_t EncodeActions(const int32_t* data, size_t action_count);
+
     //! This function sends out all batched selection and unit commands. You DO NOT need to call this function in non real time simulations since
     //! it is automatically called when stepping the simulation forward. You only need to call this function in a real time simulation.
     virtual void SendActions() = 0;
+
+    //! Same as ActionInterface::SetDeferredResponses.
+    virtual void SetDeferredResponses(bool value) = 0;
+
+    //! Same as ActionInterface::GetActionResults.
+    virtual const std::vector<uint32_t>& GetActionResults() const = 0;
 };
 
 //! The ObserverActionInterface corresponds to the actions available in the observer UI.
@@ -419,7 +449,9 @@ public:
 //! DebugInterface draws debug text, lines and shapes. Available at any time after the game starts.
 //! Guaranteed to be valid when the OnStep event is called.
 //! All debug actions are queued and dispatched when SendDebug is called. All drawn primitives
-//! continue to draw without resending until another SendDebug is called.
+//! continue to draw without resending until another SendDebug is called. Primitives drawn in a
+//! layer, see DebugBeginLayer, keep drawing over later SendDebug calls until the layer is drawn
+//! again or cleared. SendDebug only talks to the game when the primitives or commands changed.
 class DebugInterface {
 public:
     virtual ~DebugInterface() = default;
@@ -511,7 +543,7 @@ public:
     //!< \param tag The unit.
     virtual void DebugSetShields(float value, const Unit* unit) = 0;
 
-    //! Sets the position of the camera.
+    //! Sets the position of the camera. The camera moves with the next actions sent.
     //!< \param pos The camera position in world space.
     virtual void DebugMoveCamera(const Point2D& pos) = 0;
 
@@ -525,6 +557,18 @@ public:
     //!< \param delay_ms Time to elapse before invoking the game state.
       virtual void DebugTestApp(AppTest app_test, int delay_ms = 0) = 0;
 
+    // Layers.
+
+    //! Primitives drawn from now on replace the contents of the named layer. A layer keeps drawing
+    //! over later SendDebug calls until it is begun again or cleared, and is only sent to the game
+    //! again when its contents change. An empty name goes back to the primitives that draw until
+    //! the next SendDebug, which is also where drawing goes after SendDebug.
+    //!< \param name Name of the layer.
+    virtual void DebugBeginLayer(const std::string& name) = 0;
+    //! Removes a layer and stops drawing its primitives from the next SendDebug on.
+    //!< \param name Name of the layer.
+    virtual void DebugClearLayer(const std::string& name) = 0;
+
     //! Dispatch all queued debug commands. No debug commands will be sent until this is called.
     //! This will also clear or set new debug primitives like text and lines.
     virtual void SendDebug() = 0;
@@ -0,0 +1,102 @@
+/*! \file sc2_process_pool.h
+    \brief Spare StarCraft II processes launched ahead of time.
+
+    Starting StarCraft II takes seconds to tens of seconds. The pool keeps a number of spare processes launched and
+    listening in the background, so a coordinator that needs a process, to start or to recover from a crash, takes one
+    that is ready instead of waiting for a cold start.
+*/
+
+#pragma once
+
+#include "sc2api/sc2_game_settings.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sc2 {
+
+//! Command line LaunchProcess starts StarCraft II with.
+//!< \param port Port the process listens on.
+//!< \param client_num Index of the client, places the window.
+std::vector<std::string> GetProcessCommandLine(const ProcessSettings& process_settings, int port, int window_width, int window_height, int window_start_x, int window_start_y, int client_num = 0);
+
+//! Pool of spare StarCraft II processes, replenished by a background thread. A process is ready once it accepts
+//! connections, so a client connects to it on the first attempt. The spares are launched for the version last asked
+//! for, so a run that moves to another game version gets warm processes of that version after the first. Thread safe,
+//! several coordinators can share a pool, see Coordinator::SetProcessPool.
+class ProcessPool {
+public:
+    //! \param process_settings Path, data version, address, timeout and extra command line of the processes.
+    //! process_settings.port_start is not used, the pool has a range of its own.
+    //! \param spare_count Number of ready processes to keep.
+    //! \param port_start First port of the range the processes listen on.
+    //! \param port_count Number of ports in the range. The pool goes around the range, skipping the ports of its own
+    //! processes that are still running and ports something else listens on.
+    ProcessPool(const ProcessSettings& process_settings, size_t spare_count, int port_start, int port_count);
+    //! Stops replenishing and terminates the spare processes. Processes already taken are left running.
+    ~ProcessPool();
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    //! Window size and position of the processes launched from now on.
+    void SetWindow(int width, int height, int start_x, int start_y);
+
+    //! Takes a ready process, or launches one and waits for it if none of the version is ready. The caller owns the
+    //! process from then on.
+    //!< \param process_info Set to the process.
+    //!< \param process_path Executable of the version wanted, empty for the pool's.
+    //!< \param data_version Data version wanted, empty for the pool's.
+    //!< \return False if no process could be started.
+    bool Acquire(ProcessInfo& process_info, const std::string& process_path = std::string(), const std::string& data_version = std::string());
+
+    //! \return The number of spare processes ready to be taken.
+    size_t GetReadyCount() const;
+
+private:
+    struct Spare {
+        ProcessInfo info;
+        std::string data_version;
+    };
+
+    void ReplenishLoop();
+    //! Launches a process and waits until it accepts connections, or terminates it if it doesn't in time.
+    bool Launch(const ProcessSettings& settings, const std::vector<std::string>& command_line, int port, ProcessInfo& process_info);
+    //! Settings and command line of the next process, mutex_ must be held. Reserves the port until ReleasePort.
+    //!< \return False if no port of the range is free.
+    bool PrepareLaunch(ProcessSettings& settings, int& port, std::vector<std::string>& command_line);
+    //! Frees a port reserved by PrepareLaunch, mutex_ must be held.
+    void ReleasePort(int port);
+    //! \return Whether the port is taken by a process of the pool, mutex_ must be held.
+    bool IsPortUsed(int port);
+
+    ProcessSettings settings_;
+    size_t spare_count_;
+    int port_start_;
+    int port_count_;
+    int next_port_;
+    int window_width_;
+    int window_height_;
+    int window_start_x_;
+    int window_start_y_;
+
+    std::deque<Spare> ready_;
+    //! Ports of processes being launched.
+    std::vector<int> launching_ports_;
+    //! Processes handed out by Acquire, their ports are skipped while they run.
+    std::vector<ProcessInfo> acquired_;
+    size_t launching_;
+    size_t failures_;
+    bool stopping_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+}
@@ -4,6 +4,7 @@
 
 #include "s2clientprotocol/sc2api.pb.h"
 
+#include <deque>
 #include <functional>
 
 namespace sc2 {
@@ -87,7 +88,19 @@ public:
     ProtoInterface();
     bool ConnectToGame(const std::string& address, int port, int timeout_ms);
     GameRequestPtr MakeRequest();
+    // Clears request for reuse, or makes it if there is none. A cleared request keeps the memory of its fields, so a
+    // request rebuilt every step stops allocating once it has reached its usual size.
+    GameRequestPtr& ReuseRequest(GameRequestPtr& request);
     bool SendRequest(GameRequestPtr& request, bool ignore_pending_requests = false);
+    // Sends a request without waiting for its response. SC2 answers in order, so the response is read, and passed to
+    // on_response, right before the response of the next request or by PollResponse or ReceiveDeferredResponses. If a
+    // response is pending the request is sent and waited for as usual.
+    bool SendRequestDeferred(GameRequestPtr& request, std::function<void(const GameResponsePtr& response)> on_response);
+    // Reads the responses of all deferred requests sent so far.
+    bool ReceiveDeferredResponses();
+    bool HasDeferredResponses() const { return !deferred_responses_.empty(); }
+    // Number of deferred requests of a type that got no response or one with errors.
+    uint32_t GetDeferredFailures(SC2APIProtocol::Response::ResponseCase response_case) const;
     GameResponsePtr WaitForResponseInternal();
     bool PingGame();
     void Quit();
@@ -95,16 +108,35 @@ public:
     bool PollResponse();
     SC2APIProtocol::Status GetLastStatus() const { return latest_status_; }
     bool HasResponsePending() const;
-    SC2APIProtocol::Response::ResponseCase GetResponsePending() const { return response_pending_; }
+    SC2APIProtocol::Response::ResponseCase GetResponsePending() const;
     int GetAssignedPort() const { return port_; }
 
     const std::vector<uint32_t>& GetStats() const { return count_uses_; }
     void SetControl(ControlInterface* control) { control_ = control; }
 
+    // Normally sending a request while a response is pending is an error. With this set a request sent while a step
+    // is pending first waits for the step to finish, and the step response is kept for the next wait. This lets a
+    // bot make requests from OnStep while the coordinator overlaps it with the next step. Only applies to the step
+    // in flight or requested next, it's reset once that step's response has been read.
+    void SetAllowRequestsDuringStep(bool value) { allow_requests_during_step_ = value; }
+
+    // See Connection::SetResponseCallback.
+    void SetResponseCallback(std::function<void()> callback) { connection_.SetResponseCallback(callback); }
+
     uint32_t GetBaseBuild() const { return base_build_; }
     const std::string& GetDataVersion() const { return data_version_; }
 
 protected:
+    struct DeferredResponse {
+        SC2APIProtocol::Response::ResponseCase response_case;
+        std::function<void(const GameResponsePtr& response)> on_response;
+    };
+
+    // Receives the next response, which should be of the type expected. False on a timeout.
+    bool ReceiveResponse(SC2APIProtocol::Response::ResponseCase expected, GameResponsePtr& response);
+    bool ReceiveDeferredResponse();
+    void OnDeferredResponse(const DeferredResponse& deferred, const GameResponsePtr& response);
+
     Connection connection_;
     std::string address_;
     int port_;
@@ -117,6 +149,15 @@ protected:
 
     uint32_t base_build_;
     std::string data_version_;
+
+    bool allow_requests_during_step_;
+    // Set while a step response that a later request had to wait for hasn't been consumed yet.
+    bool step_response_held_;
+    GameResponsePtr held_step_response_;
+    // Requests sent with SendRequestDeferred whose responses haven't been read, in the order they were sent. They are
+    // all answered before the request in response_pending_.
+    std::deque<DeferredResponse> deferred_responses_;
+    std::vector<uint32_t> deferred_failures_;
 };
 
 // Helper to produce a string for the proto type.
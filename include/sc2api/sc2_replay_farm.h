@@ -0,0 +1,99 @@
+/*! \file sc2_replay_farm.h
+    \brief Work queue that feeds replays to a pool of replay observers.
+
+    The farm gathers the ReplayInfo of upcoming replays on dedicated clients, ahead of the observers that will run
+    them, so an observer that finishes a replay can filter and load the next one right away. Used by the Coordinator,
+    see Coordinator::SetReplayFarm.
+*/
+
+#pragma once
+
+#include "sc2api/sc2_gametypes.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sc2 {
+
+class ReplayObserver;
+
+//! A replay waiting to be run.
+struct ReplayJob {
+    std::string path;
+    ReplayInfo info;
+    //! False if no info client was left to gather the info, the observer has to gather it itself.
+    bool has_info;
+
+    ReplayJob() :
+        has_info(false) {
+    }
+};
+
+//! Work stealing queue of replays with the info gathering pipelined ahead of it. Each worker (observer) has its own
+//! queue of replays with gathered info. Workers take from the front of their own queue and, once it runs dry, steal
+//! from the back of the longest other queue. One thread per info client gathers info for the next replays and hands
+//! them to the shortest queue, keeping up to prefetch_depth replays per worker ready.
+//!
+//! Replays are routed by game version: a worker gets replays recorded with the base build its process runs, from its
+//! own queue or stolen, and a gathered replay goes to a worker on its build when there is one. A worker only switches
+//! to another build, at the cost of a relaunch, when that build has more replays waiting than the workers already on
+//! it keep ready, or when nothing else is left.
+class ReplayFarm {
+public:
+    //! \param replays Paths of the replays to run, taken from the back first.
+    //! \param info_clients Connected clients used to gather replay info, one thread each. Not owned.
+    //! \param worker_count Number of workers taking replays.
+    //! \param prefetch_depth Replays with gathered info kept ready per worker.
+    ReplayFarm(std::vector<std::string> replays, const std::vector<ReplayObserver*>& info_clients, size_t worker_count, size_t prefetch_depth);
+    //! Stops gathering, waits for the info threads to finish the replay they are on.
+    ~ReplayFarm();
+
+    ReplayFarm(const ReplayFarm&) = delete;
+    ReplayFarm& operator=(const ReplayFarm&) = delete;
+
+    //! Takes the next replay for a worker. Blocks while its info is being gathered.
+    //!< \param worker Index of the worker.
+    //!< \param base_build Base build of the worker's process, 0 takes replays of any build.
+    //!< \param job Filled out with the replay.
+    //!< \return False once there are no replays left.
+    bool Next(size_t worker, uint32_t base_build, ReplayJob& job);
+
+    //! Puts a replay back at the front of the worker's queue, e.g. while its process is relaunched into another version.
+    void Retry(size_t worker, const ReplayJob& job);
+
+    //! \return True while there are replays that haven't been taken.
+    bool HasReplays() const;
+
+    //! \return The replays not taken yet, waiting for their info or not.
+    std::vector<std::string> GetRemainingReplays() const;
+
+private:
+    void GatherLoop(ReplayObserver* client);
+    size_t QueuedCount() const;
+    bool TakeJob(size_t worker, uint32_t base_build, ReplayJob& job);
+    uint32_t ChooseBuildToSwitchTo() const;
+    std::deque<ReplayJob>& ChooseQueue(uint32_t base_build);
+
+    std::vector<std::string> replays_;
+    std::vector<std::deque<ReplayJob>> queues_;
+    // Base build each worker last asked for replays of.
+    std::vector<uint32_t> worker_builds_;
+    size_t prefetch_depth_;
+    // Replays an info thread is gathering right now.
+    size_t gathering_;
+    // Info threads still able to gather.
+    size_t gatherers_;
+    bool stopping_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::thread> threads_;
+};
+
+}
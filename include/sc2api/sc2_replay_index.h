@@ -0,0 +1,109 @@
+/*! \file sc2_replay_index.h
+    \brief Persistent index of replay info.
+
+    Stores the ReplayInfo of every replay seen, keyed by path and checked against a hash of the file, so replays only
+    have to be sent to SC2 for their info once. Replay sets can be filtered and grouped from the index without
+    launching StarCraft II.
+*/
+
+#pragma once
+
+#include "sc2api/sc2_gametypes.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sc2 {
+
+//! Criteria for ReplayIndex::Filter. Members left at their defaults match every replay.
+struct ReplayFilter {
+    //! Base builds to keep, empty keeps all.
+    std::vector<uint32_t> base_builds;
+    //! Minimum and maximum MMR of every player in the replay, 0 for no bound.
+    int min_mmr;
+    int max_mmr;
+    //! Minimum APM of every player in the replay.
+    int min_apm;
+    //! Minimum duration in seconds.
+    float min_duration;
+    //! Exact map name, empty keeps all.
+    std::string map_name;
+    //! Number of players, 0 keeps all.
+    int num_players;
+
+    ReplayFilter() :
+        min_mmr(0),
+        max_mmr(0),
+        min_apm(0),
+        min_duration(0.0f),
+        num_players(0) {
+    }
+
+    //!< \return True if the replay meets all criteria.
+    bool Matches(const ReplayInfo& replay_info) const;
+};
+
+//! Thread safe index of replay info, saved to and loaded from a compact binary file. An entry is only used while the
+//! replay file still has the hash it had when it was indexed, a replaced file is queried again. Set it on the replay
+//! observers with Coordinator::SetReplayIndex so ReplayControlInterface::GatherReplayInfo uses and fills it.
+class ReplayIndex {
+public:
+    //! Hashes the content of a replay file.
+    //!< \param path Path of the replay.
+    //!< \param hash Set to the hash of the file.
+    //!< \return False if the file can't be read.
+    static bool HashReplayFile(const std::string& path, uint64_t& hash);
+
+    //! Adds the entries of an index file, replacing entries for the same replays.
+    //!< \return False if the file is missing or corrupt, the index is then left as it was.
+    bool Load(const std::string& path);
+    //! Writes all entries, replacing the file. The entries go to path.tmp first, which is then moved over path, so the
+    //! previous index survives a crash while saving.
+    bool Save(const std::string& path) const;
+
+    //! Looks up the info of a replay, hashing the file to make sure it hasn't changed since it was indexed.
+    //!< \param replay_path Path of the replay.
+    //!< \param replay_info Set to the indexed info.
+    //!< \return False if the replay isn't indexed or has changed.
+    bool Find(const std::string& replay_path, ReplayInfo& replay_info) const;
+    //! As Find, with the hash of the file already known.
+    bool Find(const std::string& replay_path, uint64_t hash, ReplayInfo& replay_info) const;
+
+    //! Adds or replaces the entry of ReplayInfo::replay_path.
+    //!< \param hash Hash of the file, see HashReplayFile.
+    void Add(const ReplayInfo& replay_info, uint64_t hash);
+    //! As Add, hashing the file.
+    //!< \return False if the file can't be read.
+    bool Add(const ReplayInfo& replay_info);
+
+    void Remove(const std::string& replay_path);
+    void Clear();
+    size_t Size() const;
+
+    //! Selects indexed replays by their info alone, without checking the files.
+    //!< \return The paths of the replays that match, sorted.
+    std::vector<std::string> Filter(const std::function<bool(const ReplayInfo&)>& keep) const;
+    std::vector<std::string> Filter(const ReplayFilter& filter) const;
+
+    //! Splits replays by the base build they were recorded with, so each group can run on one game version.
+    //!< \param replay_paths The replays to group.
+    //!< \param unindexed Set to the replays not in the index, if not null.
+    //!< \return The indexed replays per base build, in the order given.
+    std::map<uint32_t, std::vector<std::string>> GroupByBaseBuild(const std::vector<std::string>& replay_paths, std::vector<std::string>* unindexed = nullptr) const;
+
+private:
+    struct Entry {
+        uint64_t hash;
+        ReplayInfo info;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+}
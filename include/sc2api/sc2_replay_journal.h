@@ -0,0 +1,96 @@
+/*! \file sc2_replay_journal.h
+    \brief Durable record of the progress of a replay run.
+
+    Long replay runs can resume after a crash: the journal records when each replay is started, finished, failed or
+    ignored, and tells on restart which replays still have to run. Replays that keep failing, e.g. because they crash
+    SC2, are given up on after a number of attempts.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sc2 {
+
+//! Outcome of the latest attempt at a replay.
+enum class ReplayJobStatus {
+    Pending,
+    Started,
+    Finished,
+    Failed,
+    Ignored
+};
+
+//! Append only journal of replay outcomes. Each record is one line, "<status> <unix time ms> <duration ms> <path>"
+//! followed by a tab and a checksum of the record in 8 hex digits, so the file can be inspected and a line torn by a
+//! crash is skipped on load. Records are flushed right away and synced to disk every sync_interval records. A replay
+//! that was started but never finished, because the process died, counts as failed when the journal is opened again,
+//! and so does every earlier start of it without an outcome, so a replay that keeps crashing the process is given up
+//! on as well. Thread safe. Set it with Coordinator::SetReplayJournal.
+class ReplayJournal {
+public:
+    ReplayJournal();
+    ~ReplayJournal();
+
+    ReplayJournal(const ReplayJournal&) = delete;
+    ReplayJournal& operator=(const ReplayJournal&) = delete;
+
+    //! Reads the records of an existing journal and appends to it, or creates it.
+    //!< \param path Path of the journal file.
+    //!< \param sync_interval Records written between syncs to disk, 1 syncs every record.
+    //!< \return False if the file can't be opened for writing.
+    bool Open(const std::string& path, size_t sync_interval = 16);
+    //! Syncs and closes the file.
+    void Close();
+    bool IsOpen() const;
+
+    //! Failed attempts after which a replay isn't run again.
+    void SetMaxFailures(uint32_t max_failures);
+
+    void RecordStarted(const std::string& replay_path);
+    void RecordFinished(const std::string& replay_path);
+    void RecordFailed(const std::string& replay_path);
+    void RecordIgnored(const std::string& replay_path);
+    //! Syncs the records written so far to disk.
+    void Sync();
+
+    ReplayJobStatus GetStatus(const std::string& replay_path) const;
+    uint32_t GetFailureCount(const std::string& replay_path) const;
+    //!< \return False if the replay finished, was ignored or failed too often.
+    bool ShouldRun(const std::string& replay_path) const;
+    //!< \return The replays that should run, in the order given.
+    std::vector<std::string> GetPending(const std::vector<std::string>& replay_paths) const;
+
+private:
+    struct Job {
+        ReplayJobStatus status;
+        uint32_t failures;
+        std::chrono::steady_clock::time_point start_time;
+
+        Job() :
+            status(ReplayJobStatus::Pending),
+            failures(0) {
+        }
+    };
+
+    void Record(const std::string& replay_path, ReplayJobStatus status);
+    void Apply(Job& job, ReplayJobStatus status);
+    void SyncLocked();
+    bool ShouldRunLocked(const std::string& replay_path) const;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Job> jobs_;
+    std::FILE* file_;
+    size_t sync_interval_;
+    size_t unsynced_;
+    uint32_t max_failures_;
+};
+
+}
@@ -0,0 +1,127 @@
+/*! \file sc2_step_profiler.h
+    \brief Timing of the phases of a game step.
+
+    Shows where the wall time of a step goes: waiting for SC2 to simulate, fetching and decoding the observation,
+    issuing events, the bot's OnStep or sending actions. Enable it with Coordinator::SetStepProfiling.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+//! Phases of a step. They don't overlap for one client, e.g. GetObservation is the round trip to SC2 only and
+//! UpdateObservation the decoding of the response after it.
+enum class StepPhase {
+    Update,             // Coordinator::Update, recorded for the coordinator.
+    Step,               // Sending the step request.
+    WaitStep,           // Waiting for SC2 to simulate the step.
+    GetObservation,     // Round trip of the observation request.
+    UpdateObservation,  // Decoding the observation.
+    IssueEvents,        // Unit, upgrade and alert events, before OnStep.
+    OnStep,             // The client's OnStep.
+    SendActions         // Sending the actions and waiting for the response.
+};
+
+//! Number of StepPhase values.
+const int StepPhaseCount = 8;
+
+const char* StepPhaseToName(StepPhase phase);
+
+//! Durations of a phase over the last samples, in milliseconds.
+struct StepPhaseStats {
+    StepPhaseStats();
+
+    //! Samples recorded in total, the percentiles only cover the last ones.
+    uint64_t count;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+//! Thread safe recorder of phase durations per client. Keeps a rolling window of samples per client and phase for
+//! percentiles and, if tracing, every sample as an event for a Chrome trace (chrome://tracing or Perfetto).
+class StepProfiler {
+public:
+    //! Client id the coordinator records its own phases under.
+    static const int CoordinatorClient = 0;
+
+    //! \param window Samples kept per client and phase for the percentiles.
+    //! \param max_trace_events Events kept for the trace, later ones are dropped.
+    explicit StepProfiler(size_t window = 1024, size_t max_trace_events = 1 << 20);
+
+    //! Records every sample as a trace event from now on. Off by default.
+    void SetTracing(bool value);
+    //! Name of the client's track in the trace.
+    void SetClientName(int client, const std::string& name);
+
+    void Record(int client, StepPhase phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    StepPhaseStats GetStats(int client, StepPhase phase) const;
+    //!< \return Ids of the clients with samples.
+    std::vector<int> GetClients() const;
+
+    //! Writes the trace events recorded so far in Chrome's trace event format, one track per client.
+    //!< \return False if the file can't be written.
+    bool WriteChromeTrace(const std::string& path) const;
+
+    //! Drops all samples and trace events.
+    void Clear();
+
+    //! Records the time until it goes out of scope. Does nothing without a profiler.
+    class Scope {
+    public:
+        Scope(StepProfiler* profiler, int client, StepPhase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        StepProfiler* profiler_;
+        int client_;
+        StepPhase phase_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+private:
+    struct Samples {
+        Samples() :
+            next(0),
+            count(0) {
+        }
+
+        // Ring buffer of durations in milliseconds.
+        std::vector<float> durations;
+        size_t next;
+        uint64_t count;
+    };
+
+    struct TraceEvent {
+        int client;
+        StepPhase phase;
+        int64_t start_us;
+        int64_t duration_us;
+    };
+
+    size_t window_;
+    size_t max_trace_events_;
+    bool tracing_;
+    std::chrono::steady_clock::time_point origin_;
+
+    mutable std::mutex mutex_;
+    std::map<int, std::vector<Samples>> clients_;
+    std::map<int, std::string> client_names_;
+    std::vector<TraceEvent> trace_events_;
+};
+
+}
@@ -869,6 +869,10 @@ namespace sc2 {
     //! Converts a ABILITY_ID into a string of the same name.
     const char* AbilityTypeToName(AbilityID ability_type);
 
+    //! Whether the ability adds to a production queue, i.e. training, warping in, research and building interceptors
+    //! or nukes, instead of replacing the unit's current order. Each command adds one more, even if not queued.
+    bool IsQueueAbility(AbilityID ability_type);
+
     //! Converts a UPGRADE_ID into a string of the same name.
     const char* UpgradeIDToName(UpgradeID upgrade_id);
 
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_interfaces.h"
+#include "sc2api/sc2_unit.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace sc2 {
+
+// Commands of a higher priority are sent first when the budget runs short.
+enum class ActionPriority {
+    Low = 0,
+    Normal = 1,
+    High = 2,
+    // Never deferred, but still counts against the budget. Earlier commands of the same units are sent with it.
+    Critical = 3
+};
+
+struct ActionSchedulerParameters {
+    ActionSchedulerParameters() :
+        actions_per_minute_(0.0f),
+        burst_seconds_(1.0f),
+        max_defer_loops_(22),
+        target_tolerance_(0.5f) {
+    }
+
+    // Commands sent per minute of game time, each command counting once whatever the number of its units. 0 doesn't
+    // limit them.
+    float actions_per_minute_;
+
+    // How much unused budget carries over, in seconds of actions_per_minute_.
+    float burst_seconds_;
+
+    // Game loops a deferred command waits for budget before it's dropped as stale.
+    uint32_t max_defer_loops_;
+
+    // Points closer than this to the target of a unit's current order count as the same target.
+    float target_tolerance_;
+};
+
+struct ActionSchedulerStats {
+    ActionSchedulerStats() :
+        issued(0),
+        sent(0),
+        redundant(0),
+        superseded(0),
+        deferred(0),
+        expired(0) {
+    }
+
+    // Commands passed to the scheduler.
+    uint64_t issued;
+    // Commands passed on to the ActionInterface.
+    uint64_t sent;
+    // Commands dropped because their units already had the order.
+    uint64_t redundant;
+    // Waiting commands dropped because their units got a new order.
+    uint64_t superseded;
+    // Times a command had to wait for a later step, a command waiting several steps counts each time.
+    uint64_t deferred;
+    // Commands dropped after waiting longer than max_defer_loops_.
+    uint64_t expired;
+};
+
+// Filters and paces unit commands on top of an ActionInterface. Commands are collected during OnStep and passed on by
+// Flush, which:
+//   1. Drops units that are already carrying out the order, from the orders in the latest observation.
+//   2. Sends the commands the actions per minute budget allows, highest priority and oldest first, and keeps the rest
+//      for the next steps.
+// Queued commands are never considered redundant, and other commands only if the unit's one and only order matches,
+// as they also clear the orders queued after it. Neither are training and research, see IsQueueAbility, each command
+// adds one more. A unit's commands are sent in the order they were issued, an earlier command is sent with the
+// priority of the unit's later commands.
+class ActionScheduler {
+public:
+    ActionScheduler();
+    explicit ActionScheduler(const ActionSchedulerParameters& parameters);
+
+    void SetParameters(const ActionSchedulerParameters& parameters);
+    const ActionSchedulerParameters& GetParameters() const { return parameters_; }
+
+    void UnitCommand(const Unit* unit, AbilityID ability, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+    void UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+    void UnitCommand(const Unit* unit, AbilityID ability, const Unit* target, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+    void UnitCommand(const Units& units, AbilityID ability, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+    void UnitCommand(const Units& units, AbilityID ability, const Point2D& point, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+    void UnitCommand(const Units& units, AbilityID ability, const Unit* target, bool queued_command = false, ActionPriority priority = ActionPriority::Normal);
+
+    // Passes the commands that are due to actions. Call it once per step, after the step's commands were issued.
+    void Flush(const ObservationInterface* observation, ActionInterface* actions);
+
+    // Drops the waiting commands and resets the budget, e.g. at the start of a game.
+    void Clear();
+
+    size_t GetPendingCount() const { return pending_.size(); }
+    const ActionSchedulerStats& GetStats() const { return stats_; }
+    void ResetStats() { stats_ = ActionSchedulerStats(); }
+
+private:
+    enum class TargetType {
+        None,
+        Position,
+        Unit
+    };
+
+    struct Command {
+        std::vector<Tag> unit_tags;
+        AbilityID ability;
+        TargetType target_type;
+        Point2D point;
+        Tag target_tag;
+        bool queued;
+        ActionPriority priority;
+        // priority, or that of a later command of the same units if higher, set by Flush.
+        ActionPriority send_priority;
+        // Game loop of the first Flush that saw the command.
+        uint32_t issued_loop;
+        uint64_t sequence;
+    };
+
+    void Add(const Units& units, AbilityID ability, TargetType target_type, const Point2D& point, Tag target_tag, bool queued, ActionPriority priority);
+    bool HasOrder(const ObservationInterface* observation, const Unit& unit, const Command& command) const;
+    bool SameAbility(const ObservationInterface* observation, AbilityID order, AbilityID command) const;
+    void Send(ActionInterface* actions, const ObservationInterface* observation, const Command& command) const;
+
+    ActionSchedulerParameters parameters_;
+    std::vector<Command> pending_;
+    uint64_t next_sequence_;
+    float budget_;
+    uint32_t last_loop_;
+    bool started_;
+    ActionSchedulerStats stats_;
+};
+
+}
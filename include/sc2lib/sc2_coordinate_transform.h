@@ -0,0 +1,68 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_map_info.h"
+
+#include <vector>
+
+namespace sc2 {
+
+// Converts between world space and the pixel spaces of the spatial interfaces, for the resolutions and camera in
+// GameInfo::options. Pixel spaces have an upper left origin and pixels always cover a square area of the world:
+// - The feature layer map is centered on the camera, its shortest axis spans SpatialSetup::camera_width.
+// - Minimaps start at the upper left corner of the map, their longest axis spans the map.
+// The rendered main view is a perspective projection and has no such mapping, so it isn't supported.
+//
+// World to pixel conversions floor, so a pixel is the half open square [x, x + 1) of pixel space and points left of or
+// above the image give negative pixels instead of rounding into the first row or column. Pixel to world conversions
+// return the center of the pixel. Converting a pixel to world and back gives the same pixel.
+class CoordinateTransform {
+public:
+    enum class Space {
+        FeatureMap = 0,
+        FeatureMinimap = 1,
+        RenderMinimap = 2
+    };
+
+    CoordinateTransform();
+    explicit CoordinateTransform(const GameInfo& game_info, const Point2D& camera = Point2D());
+
+    // Call after the camera moves, e.g. with ObservationInterface::GetCameraPos each step.
+    void SetCamera(const Point2D& camera);
+    void SetGameInfo(const GameInfo& game_info);
+
+    Point2DI GetResolution(Space space) const;
+    // Size of a pixel in world units.
+    float GetPixelSize(Space space) const;
+    bool IsInBounds(Space space, const Point2DI& pixel) const;
+
+    Point2DI WorldToPixel(Space space, const Point2D& world) const;
+    Point2D PixelToWorld(Space space, const Point2DI& pixel) const;
+    // Maps the center of a pixel in one space to the pixel containing it in another.
+    Point2DI PixelToPixel(Space from, const Point2DI& pixel, Space to) const;
+
+    // Batched versions of the above, the output vectors are resized to match the input.
+    void WorldToPixel(Space space, const std::vector<Point2D>& world, std::vector<Point2DI>& pixels) const;
+    void PixelToWorld(Space space, const std::vector<Point2DI>& pixels, std::vector<Point2D>& world) const;
+    void PixelToPixel(Space from, const std::vector<Point2DI>& pixels, Space to, std::vector<Point2DI>& result) const;
+
+private:
+    // world.x = origin_x + pixel.x * pixel_size, world.y = origin_y - pixel.y * pixel_size for continuous pixel
+    // coordinates, where pixel (0, 0) is the upper left corner of the image.
+    struct Mapping {
+        float origin_x;
+        float origin_y;
+        float pixel_size;
+        int width;
+        int height;
+    };
+
+    static Mapping MakeMinimapMapping(const GameInfo& game_info, int width, int height);
+    const Mapping& Get(Space space) const { return mappings_[int(space)]; }
+
+    Mapping mappings_[3];
+    float camera_width_;
+    Point2D camera_;
+};
+
+}
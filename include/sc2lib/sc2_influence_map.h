@@ -0,0 +1,94 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_data.h"
+#include "sc2api/sc2_map_info.h"
+#include "sc2api/sc2_unit.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace sc2 {
+
+struct InfluenceParameters {
+    // Some nice parameters that generally work but may require tuning for certain bots.
+    InfluenceParameters() :
+        range_buffer_(1.0f),
+        falloff_(2.0f),
+        move_threshold_(0.25f) {
+    }
+
+    // Added to every weapon range on top of the attacker's radius, to cover the radius of the unit being threatened.
+    float range_buffer_;
+
+    // Distance past the weapon range over which the threat fades linearly to zero.
+    float falloff_;
+
+    // Units that moved less than this since they were last stamped are left in place by Update.
+    float move_threshold_;
+};
+
+// Grid of summed weapon DPS per cell, one layer for ground targets and one for air targets, at the resolution of the
+// map. Each unit adds a radial kernel: its full DPS within weapon range, fading to zero over falloff_.
+//
+// Stamps are kept per unit tag so Update only touches units that appeared, moved, changed or disappeared since the
+// previous call instead of rebuilding the whole grid every step.
+class InfluenceMap {
+public:
+    enum class Layer {
+        Ground = 0,
+        Air = 1
+    };
+
+    InfluenceMap();
+    explicit InfluenceMap(const InfluenceParameters& parameters);
+
+    // Sizes the layers to the map and removes all units.
+    void Reset(const GameInfo& game_info);
+    void Reset(int width, int height);
+
+    // Makes the layers reflect exactly the given units, e.g. all visible enemies. Units that are not in the list
+    // anymore are removed.
+    void Update(const Units& units, const UnitTypes& unit_types);
+
+    // Adds or restamps a single unit. Returns false if the unit has no weapons and so adds no influence.
+    bool AddUnit(const Unit& unit, const UnitTypes& unit_types);
+    void RemoveUnit(Tag tag);
+
+    // Recomputes the layers from the stored stamps, discarding any floating point drift from incremental updates.
+    void Rebuild();
+
+    // Influence at a point in world space, 0 off the map.
+    float GetValue(Layer layer, const Point2D& point) const;
+
+    // Raw layer data, indexed by x + y * GetWidth() in world coordinates (lower left origin).
+    const std::vector<float>& GetLayer(Layer layer) const;
+    int GetWidth() const { return width_; }
+    int GetHeight() const { return height_; }
+    size_t GetUnitCount() const { return stamps_.size(); }
+
+private:
+    struct Stamp {
+        Point2D pos;
+        float ground_dps;
+        float ground_range;
+        float air_dps;
+        float air_range;
+        // Value of update_count_ when the unit was last passed to Update.
+        uint32_t last_update;
+    };
+
+    bool MakeStamp(const Unit& unit, const UnitTypes& unit_types, Stamp& stamp) const;
+    bool NeedsRestamp(const Stamp& previous, const Stamp& next) const;
+    void Apply(const Stamp& stamp, float sign);
+    void ApplyKernel(std::vector<float>& layer, const Point2D& center, float range, float value);
+
+    InfluenceParameters parameters_;
+    int width_;
+    int height_;
+    std::vector<float> layers_[2];
+    std::unordered_map<Tag, Stamp> stamps_;
+    uint32_t update_count_;
+};
+
+}
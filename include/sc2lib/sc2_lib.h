@@ -2,3 +2,9 @@
 
 #include "sc2_search.h"
 #include "sc2_utils.h"
+#include "sc2_terrain.h"
+#include "sc2_map_cache.h"
+#include "sc2_influence_map.h"
+#include "sc2_coordinate_transform.h"
+#include "sc2_action_scheduler.h"
+#include "sc2_scenario.h"
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_interfaces.h"
+#include "sc2lib/sc2_search.h"
+#include "sc2lib/sc2_terrain.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sc2 {
+
+// A group of mineral fields and geysers that make up one base.
+struct ResourceCluster {
+    // Center of mass of the resources.
+    Point3D center;
+    std::vector<Point3D> minerals;
+    std::vector<Point3D> geysers;
+};
+
+// Everything about a map that can be worked out once and reused across games on it.
+struct MapStaticData {
+    MapStaticData();
+
+    // Pathing distance between two expansions, by index into expansion_locations. 0 if unreachable or not calculated.
+    float GetExpansionDistance(size_t a, size_t b) const;
+
+    std::string map_name;
+    std::string local_map_path;
+    // Result of HashGameInfoGrids for the map.
+    uint64_t grid_hash;
+    // All start locations on the map, including our own, sorted by position.
+    std::vector<Point2D> start_locations;
+    std::vector<ResourceCluster> resource_clusters;
+    // One per resource cluster, in the same order.
+    std::vector<Point3D> expansion_locations;
+    // Row major matrix of pathing distances between expansion locations.
+    std::vector<float> expansion_distances;
+};
+
+struct MapCacheParameters {
+    MapCacheParameters() :
+        calculate_distances_(true),
+        use_cache_(true),
+        cache_directory_(".") {
+    }
+
+    // Passed to search::CalculateExpansionLocations on a cache miss.
+    search::ExpansionParameters expansion_parameters_;
+
+    // If set the pathing distances between all expansions are queried on a cache miss.
+    bool calculate_distances_;
+
+    // If set GetMapStaticData loads the data from cache_directory_ when present and writes it there otherwise.
+    bool use_cache_;
+    std::string cache_directory_;
+};
+
+// Returns the static data for the current map. On a cache miss this makes blocking queries to SC2 (placement for the
+// expansions and optionally pathing between them), which can take hundreds of milliseconds. On a hit it only reads a
+// small file, so it is cheap to call at the start of every game, e.g. from OnGameStart after a RestartGame.
+MapStaticData GetMapStaticData(const ObservationInterface* observation, QueryInterface* query, const MapCacheParameters& parameters = MapCacheParameters());
+
+// Path of the cache file GetMapStaticData uses for the current map.
+std::string GetMapStaticDataPath(const GameInfo& game_info, const MapCacheParameters& parameters = MapCacheParameters());
+
+bool SaveMapStaticData(const std::string& path, const MapStaticData& data, const MapCacheParameters& parameters = MapCacheParameters());
+// Fails if the file is missing, corrupt, or was written with different expansion parameters or calculate_distances_.
+bool LoadMapStaticData(const std::string& path, MapStaticData& data, const MapCacheParameters& parameters = MapCacheParameters());
+
+// Keeps map static data and terrain analyses in memory so the games of one process that play the same map, e.g. the
+// games of a BatchCoordinator, share them. Each is worked out once per map, by the first game that asks for it, while
+// the other games on that map wait for it. Thread safe.
+class MapAnalysisCache {
+public:
+    explicit MapAnalysisCache(const MapCacheParameters& map_parameters = MapCacheParameters(),
+        const terrain::TerrainParameters& terrain_parameters = terrain::TerrainParameters());
+
+    // As sc2::GetMapStaticData, the observation and query interfaces are only used on a miss.
+    std::shared_ptr<const MapStaticData> GetMapStaticData(const ObservationInterface* observation, QueryInterface* query);
+    // As terrain::AnalyzeTerrain.
+    std::shared_ptr<const terrain::TerrainAnalysis> GetTerrainAnalysis(const GameInfo& game_info);
+
+    void Clear();
+
+private:
+    template<typename T>
+    struct Entry {
+        std::mutex mutex;
+        std::shared_ptr<const T> data;
+    };
+
+    template<typename T>
+    static std::shared_ptr<Entry<T> > FindOrAddEntry(std::mutex& mutex, std::unordered_map<uint64_t, std::shared_ptr<Entry<T> > >& entries, uint64_t key);
+
+    MapCacheParameters map_parameters_;
+    terrain::TerrainParameters terrain_parameters_;
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<Entry<MapStaticData> > > map_data_;
+    std::unordered_map<uint64_t, std::shared_ptr<Entry<terrain::TerrainAnalysis> > > terrain_analyses_;
+};
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_interfaces.h"
+#include "sc2api/sc2_unit.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+// Units to create at a position, count of them around it.
+struct ScenarioUnit {
+    ScenarioUnit();
+
+    UnitTypeID unit_type;
+    Point2D pos;
+    uint32_t player_id;
+    uint32_t count;
+
+    // Set once the units appeared, negative keeps the default of the unit type.
+    float life;
+    float energy;
+    float shields;
+};
+
+// Starting state of a test or benchmark, set up with debug commands.
+struct Scenario {
+    Scenario();
+
+    std::vector<ScenarioUnit> units;
+
+    // Kill the units of the players that are there before loading.
+    bool kill_existing;
+    // Cheats applied with the units.
+    bool give_all_upgrades;
+    bool give_all_tech;
+    bool show_map;
+};
+
+// Parses a scenario from text, one statement per line. Blank lines and lines starting with # are ignored.
+//   unit <type> <x> <y> [player=<id>] [count=<n>] [life=<value>] [energy=<value>] [shields=<value>]
+//   kill_existing
+//   upgrades
+//   tech
+//   show_map
+// <type> is the name of a UNIT_TYPEID, e.g. TERRAN_MARINE, or its number. On failure error, if not null, says which
+// line is wrong.
+bool ParseScenario(const std::string& text, Scenario& scenario, std::string* error = nullptr);
+
+// ParseScenario on the contents of a file, printing what's wrong on failure.
+bool LoadScenarioFile(const std::string& path, Scenario& scenario);
+
+// Sets up a scenario with as few debug requests as the protocol allows: one with the kills, cheats and units, merging
+// units of the same type, owner and position into one create command, and, once all units appeared, one with their
+// life, energy and shields. Creating units takes a game step, so the loader is driven from OnStep:
+//
+//   loader.Start(scenario, Observation(), Debug());
+//   ...
+//   void OnStep() { if (loader.Update(Observation(), Debug()) == ScenarioLoader::State::Done) { ... } }
+class ScenarioLoader {
+public:
+    enum class State {
+        Idle,
+        // Waiting for the units to appear.
+        Spawning,
+        Done,
+        // The units didn't all appear in time.
+        Failed
+    };
+
+    // timeout_loops: Game loops to wait for the units before giving up.
+    explicit ScenarioLoader(uint32_t timeout_loops = 200);
+
+    // Sends the kills, cheats and units with SendDebug, along with any debug commands queued before.
+    void Start(const Scenario& scenario, const ObservationInterface* observation, DebugInterface* debug);
+
+    // Checks for the units of the scenario, call it once per step after Start.
+    State Update(const ObservationInterface* observation, DebugInterface* debug);
+
+    State GetState() const { return state_; }
+
+    // Units the scenario created, in the order of its units.
+    const std::vector<Tag>& GetUnitTags() const { return unit_tags_; }
+
+private:
+    bool AssignUnits(const ObservationInterface* observation, std::vector<std::vector<const Unit*>>& assigned) const;
+
+    uint32_t timeout_loops_;
+    State state_;
+    Scenario scenario_;
+    uint32_t start_loop_;
+    // Units that were there before Start, the rest are new.
+    std::vector<Tag> existing_tags_;
+    std::vector<Tag> unit_tags_;
+};
+
+}
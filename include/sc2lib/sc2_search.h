@@ -10,8 +10,22 @@ namespace sc2 {
 
 namespace search {
 
+// Returns true for mineral fields and vespene geysers.
+bool IsResource(const Unit& unit);
+
+enum class ClusterMode {
+    // Each unit joins the cluster with the nearest center of mass if that is within distance_apart, otherwise it starts a
+    // new cluster. Results depend on the order of the units.
+    Greedy,
+    // Density based: units connected through chains of neighbors within distance_apart form one cluster. Units with
+    // fewer than min_points neighbors (counting themselves) that are not next to such a unit are dropped as noise.
+    DBSCAN
+};
+
 // Clusters units within some distance of each other and returns a list of them and their center of mass.
-std::vector<std::pair<Point3D, std::vector<Unit> > > Cluster(const Units& units, float distance_apart);
+// Units are bucketed in a grid of distance_apart sized cells, so only nearby units or clusters are compared. The
+// clusters point into the units passed in and are only valid as long as those are.
+std::vector<std::pair<Point3D, Units> > Cluster(const Units& units, float distance_apart, ClusterMode mode = ClusterMode::Greedy, size_t min_points = 1);
 
 struct ExpansionParameters {
     // Some nice parameters that generally work but may require tuning for certain maps.
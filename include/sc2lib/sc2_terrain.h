@@ -0,0 +1,120 @@
+#pragma once
+
+#include "sc2api/sc2_common.h"
+#include "sc2api/sc2_map_info.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+namespace terrain {
+
+typedef uint16_t RegionId;
+// Region of cells that are not pathable.
+static const RegionId NullRegion = 0xFFFF;
+
+// A connected area of the map bounded by cliffs and chokepoints, e.g. a main base or a natural.
+struct Region {
+    RegionId id;
+    // Center of mass of the region's cells. For concave regions this may lie outside the region.
+    Point2D center;
+    // Average terrain height over the region.
+    float height;
+    // Number of pathable cells in the region.
+    uint32_t area;
+    // Indices into TerrainAnalysis::chokepoints of the chokepoints bordering this region.
+    std::vector<uint32_t> chokepoints;
+};
+
+// A narrow passage between two regions.
+struct Chokepoint {
+    // Widest point of the passage border, in the middle of the passage.
+    Point2D center;
+    // The ends of the passage border, next to the walls on either side.
+    Point2D side_a;
+    Point2D side_b;
+    // Approximate width of the passage in cells.
+    float width;
+    RegionId region_a;
+    RegionId region_b;
+    // Index into TerrainAnalysis::ramps if the passage is on a ramp, -1 otherwise.
+    int32_t ramp;
+};
+
+// A connected area of pathable, non-placeable cells that changes height, i.e. a ramp between two levels.
+struct Ramp {
+    Point2D center;
+    // Highest and lowest cells of the ramp.
+    Point2D top;
+    Point2D bottom;
+    float top_height;
+    float bottom_height;
+    uint32_t area;
+    // Regions found at the top and the bottom of the ramp, NullRegion if none.
+    RegionId region_top;
+    RegionId region_bottom;
+};
+
+struct TerrainAnalysis {
+    TerrainAnalysis();
+
+    // Region for a point in world space, NullRegion if the point is off the map or not pathable.
+    RegionId GetRegionId(const Point2D& point) const;
+    const Region* GetRegion(const Point2D& point) const;
+
+    std::string map_name;
+    // Result of HashGameInfoGrids for the grids this analysis was computed from.
+    uint64_t grid_hash;
+    int width;
+    int height;
+    // Region of every cell, indexed by x + y * width in world coordinates (lower left origin).
+    std::vector<RegionId> region_map;
+    // Indexed by RegionId.
+    std::vector<Region> regions;
+    std::vector<Chokepoint> chokepoints;
+    std::vector<Ramp> ramps;
+};
+
+struct TerrainParameters {
+    // Some nice parameters that generally work but may require tuning for certain maps.
+    TerrainParameters() :
+        merge_ratio_(0.7f),
+        min_region_area_(64),
+        ramp_height_delta_(0.5f),
+        use_cache_(true),
+        cache_directory_(".") {
+    }
+
+    // Two basins of the distance transform are merged when the passage between them is at least this fraction as
+    // wide as the narrower of the two basins. Lower values produce fewer, larger regions.
+    float merge_ratio_;
+
+    // Regions with fewer cells than this are merged into their widest neighbor.
+    uint32_t min_region_area_;
+
+    // Minimum height difference across a non-placeable area for it to count as a ramp.
+    float ramp_height_delta_;
+
+    // If set AnalyzeTerrain loads the analysis from cache_directory_ when present and writes it there otherwise.
+    bool use_cache_;
+    std::string cache_directory_;
+};
+
+// Decomposes the pathing grid of a map into regions, chokepoints and ramps using a watershed of the distance to the
+// nearest unpathable cell. This takes on the order of tens of milliseconds for a ladder map, results are cached on
+// disk keyed by map name and grid hash so it only needs to run once per map.
+TerrainAnalysis AnalyzeTerrain(const GameInfo& game_info, const TerrainParameters& parameters = TerrainParameters());
+
+// Path of the cache file AnalyzeTerrain uses for a map.
+std::string GetTerrainCachePath(const GameInfo& game_info, const TerrainParameters& parameters = TerrainParameters());
+
+bool SaveTerrainAnalysis(const std::string& path, const TerrainAnalysis& analysis, const TerrainParameters& parameters = TerrainParameters());
+// Fails if the file is missing, corrupt, refers to regions, chokepoints or ramps it doesn't have, or was written with
+// different parameters.
+bool LoadTerrainAnalysis(const std::string& path, TerrainAnalysis& analysis, const TerrainParameters& parameters = TerrainParameters());
+
+}
+
+}
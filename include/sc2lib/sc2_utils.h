@@ -3,10 +3,20 @@
 #include "sc2api/sc2_common.h"
 #include "sc2api/sc2_map_info.h"
 
+#include <cstdint>
+#include <string>
+
 namespace sc2 {
 
 Point2D FindRandomLocation(const Point2D& min, const Point2D& max);
 Point2D FindRandomLocation(const GameInfo& game_info);
 Point2D FindCenterOfMap(const GameInfo& game_info);
 
+// Hashes the dimensions and static grids (pathing, terrain height, placement) of a map. Useful as a key for
+// caching map analysis, since map names alone don't change when a map is updated.
+uint64_t HashGameInfoGrids(const GameInfo& game_info);
+
+// Builds a file path in directory for a cached result about a map, e.g. "directory/Map_Name_0123456789abcdef.ext".
+std::string GetMapCachePath(const std::string& directory, const std::string& map_name, uint64_t key, const std::string& extension);
+
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <set>
+#include <cstdint>
 
 namespace sc2 {
 
@@ -75,4 +76,55 @@ static inline void SerializeT(std::ifstream& data_file, std::set<uint32_t>& s) {
     }
 }
 
+// Binary helpers, for caches where load speed and size matter more than readability.
+// Only use these with trivially copyable types; the layout is whatever the compiler produces.
+template<typename T> void WriteBinary(std::ofstream& s, const T& t) {
+    s.write(reinterpret_cast<const char*>(&t), sizeof(T));
+}
+
+template<typename T> bool ReadBinary(std::ifstream& s, T& t) {
+    return static_cast<bool>(s.read(reinterpret_cast<char*>(&t), sizeof(T)));
+}
+
+// Upper bound on element counts read back, so a corrupt file can't trigger a huge allocation.
+static const uint32_t MaxBinaryElements = 1 << 24;
+
+template<typename T> void WriteBinary(std::ofstream& s, const std::vector<T>& v) {
+    uint32_t size = static_cast<uint32_t>(v.size());
+    WriteBinary(s, size);
+    if (size > 0) {
+        s.write(reinterpret_cast<const char*>(v.data()), sizeof(T) * size);
+    }
+}
+
+template<typename T> bool ReadBinary(std::ifstream& s, std::vector<T>& v) {
+    uint32_t size = 0;
+    if (!ReadBinary(s, size) || size > MaxBinaryElements)
+        return false;
+
+    v.resize(size);
+    if (size == 0)
+        return true;
+
+    return static_cast<bool>(s.read(reinterpret_cast<char*>(v.data()), sizeof(T) * size));
+}
+
+static inline void WriteBinary(std::ofstream& s, const std::string& t) {
+    uint32_t size = static_cast<uint32_t>(t.size());
+    WriteBinary(s, size);
+    s.write(t.data(), size);
+}
+
+static inline bool ReadBinary(std::ifstream& s, std::string& t) {
+    uint32_t size = 0;
+    if (!ReadBinary(s, size) || size > MaxBinaryElements)
+        return false;
+
+    t.resize(size);
+    if (size == 0)
+        return true;
+
+    return static_cast<bool>(s.read(&t[0], size));
+}
+
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sc2 {
+
+// Fixed set of worker threads that live as long as the pool, so stepping clients in parallel doesn't create and join
+// a thread per client every step.
+class ThreadPool {
+public:
+    // A thread_count of 0 uses one thread per hardware core. If pin_threads is set worker i is pinned to core
+    // i modulo the core count, where the platform supports it.
+    explicit ThreadPool(size_t thread_count = 0, bool pin_threads = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetThreadCount() const { return threads_.size(); }
+
+    // Queues a task to run on a worker.
+    void Submit(std::function<void()> task);
+
+    // Runs task(0) through task(count - 1) on the workers and the calling thread and returns once all of them are
+    // done, i.e. a barrier. May be called from inside a task. While it waits the calling thread only runs tasks of
+    // this call, see TaskGroup.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void WorkerLoop(size_t index);
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    bool pin_threads_;
+    bool stopping_;
+};
+
+// Tasks run on a ThreadPool that the thread waiting for them helps with. The waiting thread only runs tasks of its own
+// group, never whatever else is queued on the pool, so a game waiting on its clients doesn't end up running another
+// game's update on its stack. Tasks no worker has picked up yet are run by RunPendingTask or Wait, so a group finishes
+// even if every worker is busy.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& thread_pool);
+    // Waits for the tasks of the group.
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Run(std::function<void()> task);
+
+    // Runs one task of the group that no worker has started on the calling thread. Returns false if there was none.
+    bool RunPendingTask();
+
+    // Runs pending tasks of the group on the calling thread and returns once all of them are done.
+    void Wait();
+
+private:
+    struct State;
+
+    ThreadPool& thread_pool_;
+    // Shared with the tasks queued on the pool, which may be picked up after the group is gone.
+    std::shared_ptr<State> state_;
+};
+
+}
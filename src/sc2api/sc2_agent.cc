@@ -2,11 +2,60 @@
 #include "sc2api/sc2_unit.h"
 #include "sc2api/sc2_interfaces.h"
 #include "sc2api/sc2_control_interfaces.h"
+#include "sc2api/sc2_map_info.h"
+#include "sc2api/sc2_step_profiler.h"
 
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace sc2 {
 
+// Results of a response to a RequestAction, empty if there is none.
+static void ReadActionResults(const GameResponsePtr& response, std::vector<uint32_t>& results) {
+    results.clear();
+    if (!response.get() || !response->has_action()) {
+        return;
+    }
+
+    for (int result : response->action().result()) {
+        results.push_back(static_cast<uint32_t>(result));
+    }
+}
+
+// Sends the actions, without waiting for the response if deferred. The results are read into results either way.
+static bool SendActionRequest(ProtoInterface& proto, ControlInterface& control, GameRequestPtr& request, bool deferred, std::vector<uint32_t>& results) {
+    if (!deferred) {
+        if (!proto.SendRequest(request)) {
+            return false;
+        }
+
+        ReadActionResults(control.WaitForResponse(), results);
+        return true;
+    }
+
+    return proto.SendRequestDeferred(request, [&control, &results](const GameResponsePtr& response) {
+        // ControlInterface::WaitForResponse reports these for responses that are waited for.
+        if (response.get() && response->error_size() > 0) {
+            std::vector<std::string> errors;
+            for (int i = 0; i < response->error_size(); ++i) {
+                errors.push_back(response->error(i));
+            }
+            control.Error(ClientError::SC2ProtocolError, errors);
+        }
+
+        ReadActionResults(response, results);
+    });
+}
+
+// The camera move of DebugInterface::DebugMoveCamera goes out with the actions rather than in a request of its own.
+static void AddDebugCameraMove(SC2APIProtocol::RequestAction* request_action, const Point2D& pos) {
+    SC2APIProtocol::ActionRawCameraMove* camera_move = request_action->add_actions()->mutable_action_raw()->mutable_camera_move();
+    SC2APIProtocol::Point* point = camera_move->mutable_center_world_space();
+    point->set_x(pos.x);
+    point->set_y(pos.y);
+}
+
 //-------------------------------------------------------------------------------------------------
 // ActionImp: an implementation of an ActionInterface.
 //-------------------------------------------------------------------------------------------------
@@ -14,12 +63,17 @@ namespace sc2 {
 class ActionImp : public ActionInterface {
 public:
     ProtoInterface& proto_;
+    // Reused every step, holds actions to send if has_actions_ is set.
     GameRequestPtr request_actions_;
+    bool has_actions_;
     ControlInterface& control_;
 
     ActionImp(ProtoInterface& proto, ControlInterface& control);
 
     SC2APIProtocol::RequestAction* GetRequestAction();
+    SC2APIProtocol::ActionRawUnitCommand* AddUnitCommand(AbilityID ability, bool queued_command);
+    void AddUnitTag(SC2APIProtocol::ActionRawUnitCommand* unit_command, Tag tag);
+    void CoalesceUnitCommands(SC2APIProtocol::RequestAction* request_action);
 
     void UnitCommand(const Unit* unit, AbilityID ability, bool queued_command = false) override;
     void UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command = false) override;
@@ -36,18 +90,38 @@ public:
     const std::vector<Tag>& Commands() const override;
 
     void SendActions() override;
+    void SetDeferredResponses(bool value) override;
+    const std::vector<uint32_t>& GetActionResults() const override;
 
     std::vector<Tag> commands_;
+    // Units given commands since the last SendActions, becomes commands_ once they're sent.
+    std::vector<Tag> issued_tags_;
+    bool deferred_responses_;
+    std::vector<uint32_t> action_results_;
+
+    // Scratch space of CoalesceUnitCommands, kept to reuse its memory.
+    SC2APIProtocol::RequestAction coalesced_;
 };
 
 ActionImp::ActionImp(ProtoInterface& proto, ControlInterface& control) :
     proto_(proto),
-    control_(control) {
+    has_actions_(false),
+    control_(control),
+    deferred_responses_(false) {
+}
+
+void ActionImp::SetDeferredResponses(bool value) {
+    deferred_responses_ = value;
+}
+
+const std::vector<uint32_t>& ActionImp::GetActionResults() const {
+    return action_results_;
 }
 
 SC2APIProtocol::RequestAction* ActionImp::GetRequestAction() {
-    if (request_actions_ == nullptr) {
-        request_actions_ = proto_.MakeRequest();
+    if (!has_actions_) {
+        proto_.ReuseRequest(request_actions_);
+        has_actions_ = true;
     }
     return request_actions_->mutable_action();
 }
@@ -59,26 +133,197 @@ const std::vector<Tag>& ActionImp::Commands() const {
 void ActionImp::SendActions() {
     commands_.clear();
 
-    if (request_actions_ == nullptr) {
-        return;
+    Point2D camera;
+    if (control_.TakeCameraMove(camera)) {
+        AddDebugCameraMove(GetRequestAction(), camera);
     }
 
-    if (!proto_.SendRequest(request_actions_)) {
+    if (!has_actions_) {
         return;
     }
 
+    StepProfiler::Scope scope(control_.GetStepProfiler(), control_.GetStepProfilerClient(), StepPhase::SendActions);
     SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    if (request_action) {
-        for (int i = 0, e = request_action->actions_size(); i < e; ++i) {
-            const SC2APIProtocol::Action& action = request_action->actions(i);
-            for (auto tag : action.action_raw().unit_command().unit_tags()) {
-                commands_.push_back(tag);
-            };
+    CoalesceUnitCommands(request_action);
+
+    if (!SendActionRequest(proto_, control_, request_actions_, deferred_responses_, action_results_)) {
+        return;
+    }
+
+    // Coalescing only drops a move, attack, stop or harvest command of a unit that gets a later one replacing it, so
+    // every unit issued a command still has one in the request.
+    commands_.swap(issued_tags_);
+    issued_tags_.clear();
+    has_actions_ = false;
+}
+
+namespace {
+
+// Commands with the same key do the same thing to each of their units, so they can be sent as one.
+struct UnitCommandKey {
+    uint32_t ability_id;
+    bool queued;
+    int target_case;
+    float x;
+    float y;
+    Tag target_tag;
+
+    explicit UnitCommandKey(const SC2APIProtocol::ActionRawUnitCommand& command) :
+        ability_id(command.ability_id()),
+        queued(command.queue_command()),
+        target_case(static_cast<int>(command.target_case())),
+        x(command.has_target_world_space_pos() ? command.target_world_space_pos().x() : 0.0f),
+        y(command.has_target_world_space_pos() ? command.target_world_space_pos().y() : 0.0f),
+        target_tag(command.has_target_unit_tag() ? command.target_unit_tag() : NullTag) {
+    }
+
+    bool operator==(const UnitCommandKey& other) const {
+        return ability_id == other.ability_id && queued == other.queued && target_case == other.target_case &&
+            x == other.x && y == other.y && target_tag == other.target_tag;
+    }
+};
+
+struct UnitCommandKeyHash {
+    size_t operator()(const UnitCommandKey& key) const {
+        size_t hash = std::hash<uint32_t>()(key.ability_id);
+        hash = hash * 31 + std::hash<float>()(key.x);
+        hash = hash * 31 + std::hash<float>()(key.y);
+        hash = hash * 31 + std::hash<Tag>()(key.target_tag);
+        return hash * 4 + static_cast<size_t>(key.target_case) * 2 + (key.queued ? 1 : 0);
+    }
+};
+
+struct UnitAbilityHash {
+    size_t operator()(const std::pair<Tag, uint32_t>& unit_ability) const {
+        return std::hash<Tag>()(unit_ability.first) * 31 + unit_ability.second;
+    }
+};
+
+bool IsUnitCommand(const SC2APIProtocol::Action& action) {
+    return action.has_action_raw() && action.action_raw().has_unit_command();
+}
+
+// Orders that every unit of a command carries out. A command of any other ability can be cast by just one of its
+// units, e.g. a spell, or adds to a production queue, so those aren't merged or dropped.
+bool IsCoalescedAbility(uint32_t ability_id) {
+    switch (static_cast<ABILITY_ID>(ability_id)) {
+        case ABILITY_ID::SMART:
+        case ABILITY_ID::ATTACK:
+        case ABILITY_ID::ATTACK_ATTACK:
+        case ABILITY_ID::ATTACK_ATTACKBUILDING:
+        case ABILITY_ID::ATTACK_REDIRECT:
+        case ABILITY_ID::SCAN_MOVE:
+        case ABILITY_ID::MOVE:
+        case ABILITY_ID::PATROL:
+        case ABILITY_ID::HOLDPOSITION:
+        case ABILITY_ID::STOP:
+        case ABILITY_ID::STOP_STOP:
+        case ABILITY_ID::STOP_BUILDING:
+        case ABILITY_ID::STOP_REDIRECT:
+        case ABILITY_ID::HARVEST_GATHER:
+        case ABILITY_ID::HARVEST_GATHER_DRONE:
+        case ABILITY_ID::HARVEST_GATHER_PROBE:
+        case ABILITY_ID::HARVEST_GATHER_SCV:
+        case ABILITY_ID::HARVEST_RETURN:
+        case ABILITY_ID::HARVEST_RETURN_DRONE:
+        case ABILITY_ID::HARVEST_RETURN_MULE:
+        case ABILITY_ID::HARVEST_RETURN_PROBE:
+        case ABILITY_ID::HARVEST_RETURN_SCV:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+// Bots often give the same order to many units one at a time, or give a unit several orders in one step. The
+// commands are merged into one command per order with all of its units, and the orders replaced later in the step
+// are dropped. A unit's orders keep their relative order. Only moving, attacking, stopping and harvesting are
+// coalesced: SC2 has just one unit of a command cast a spell or train a unit, so other commands are sent as issued.
+void ActionImp::CoalesceUnitCommands(SC2APIProtocol::RequestAction* request_action) {
+    int action_count = request_action->actions_size();
+    if (action_count < 2) {
+        return;
+    }
+
+    // Backwards, drop a unit's command if the unit gets the same ability again later without queueing it.
+    std::unordered_set<std::pair<Tag, uint32_t>, UnitAbilityHash> replaced;
+    std::vector<bool> dropped(action_count, false);
+    for (int i = action_count - 1; i >= 0; --i) {
+        if (!IsUnitCommand(request_action->actions(i)) || !IsCoalescedAbility(request_action->actions(i).action_raw().unit_command().ability_id())) {
+            continue;
+        }
+
+        SC2APIProtocol::ActionRawUnitCommand* command = request_action->mutable_actions(i)->mutable_action_raw()->mutable_unit_command();
+        uint32_t ability_id = command->ability_id();
+        int tag_count = command->unit_tags_size();
+        int kept = 0;
+        for (int t = 0; t < tag_count; ++t) {
+            Tag tag = command->unit_tags(t);
+            if (replaced.count(std::make_pair(tag, ability_id)) == 0) {
+                command->set_unit_tags(kept++, tag);
+            }
+        }
+        command->mutable_unit_tags()->Truncate(kept);
+        dropped[i] = tag_count > 0 && kept == 0;
+
+        if (!command->queue_command()) {
+            for (int t = 0; t < kept; ++t) {
+                replaced.insert(std::make_pair(command->unit_tags(t), ability_id));
+            }
         }
     }
 
-    request_actions_ = nullptr;
-    control_.WaitForResponse();
+    // Forwards, merge a command into the last one with the same key unless one of its units got another order since.
+    SC2APIProtocol::RequestAction& coalesced = coalesced_;
+    coalesced.Clear();
+    std::unordered_map<UnitCommandKey, int, UnitCommandKeyHash> last_with_key;
+    std::unordered_map<Tag, int> last_order;
+    for (int i = 0; i < action_count; ++i) {
+        if (dropped[i]) {
+            continue;
+        }
+
+        SC2APIProtocol::Action* action = request_action->mutable_actions(i);
+        if (!IsUnitCommand(*action)) {
+            // Autocast toggles are orders too as far as merging past them goes.
+            if (action->has_action_raw() && action->action_raw().has_toggle_autocast()) {
+                for (Tag tag : action->action_raw().toggle_autocast().unit_tags()) {
+                    last_order[tag] = coalesced.actions_size();
+                }
+            }
+            coalesced.add_actions()->Swap(action);
+            continue;
+        }
+
+        const SC2APIProtocol::ActionRawUnitCommand& command = action->action_raw().unit_command();
+        UnitCommandKey key(command);
+        auto group = last_with_key.find(key);
+        bool mergeable = group != last_with_key.end() && IsCoalescedAbility(command.ability_id());
+        for (int t = 0; mergeable && t < command.unit_tags_size(); ++t) {
+            auto order = last_order.find(command.unit_tags(t));
+            mergeable = order == last_order.end() || order->second < group->second;
+        }
+
+        int index = mergeable ? group->second : coalesced.actions_size();
+        if (mergeable) {
+            SC2APIProtocol::ActionRawUnitCommand* merged = coalesced.mutable_actions(index)->mutable_action_raw()->mutable_unit_command();
+            for (Tag tag : command.unit_tags()) {
+                merged->add_unit_tags(tag);
+            }
+        }
+        else {
+            coalesced.add_actions()->Swap(action);
+            last_with_key[key] = index;
+        }
+
+        for (Tag tag : coalesced.actions(index).action_raw().unit_command().unit_tags()) {
+            last_order[tag] = index;
+        }
+    }
+
+    request_action->Swap(&coalesced);
 }
 
 void ActionImp::ToggleAutocast(Tag unit_tag, AbilityID ability) {
@@ -121,67 +366,71 @@ void ActionImp::SendChat(const std::string& message, ChatChannel channel) {
     }
 }
 
+SC2APIProtocol::ActionRawUnitCommand* ActionImp::AddUnitCommand(AbilityID ability, bool queued_command) {
+    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
+    SC2APIProtocol::Action* action = request_action->add_actions();
+    SC2APIProtocol::ActionRaw* action_raw = action->mutable_action_raw();
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = action_raw->mutable_unit_command();
+
+    unit_command->set_ability_id(ability);
+    unit_command->set_queue_command(queued_command);
+    return unit_command;
+}
+
+void ActionImp::AddUnitTag(SC2APIProtocol::ActionRawUnitCommand* unit_command, Tag tag) {
+    unit_command->add_unit_tags(tag);
+    issued_tags_.push_back(tag);
+}
+
 void ActionImp::UnitCommand(const Unit* unit, AbilityID ability, bool queued_command) {
     if (!unit) return;
-    UnitCommand(Units({ unit }), ability, queued_command);
+    AddUnitTag(AddUnitCommand(ability, queued_command), unit->tag);
 }
 
 void ActionImp::UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command) {
     if (!unit) return;
-    UnitCommand(Units({ unit }), ability, point, queued_command);
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = AddUnitCommand(ability, queued_command);
+    SC2APIProtocol::Point2D* target_point = unit_command->mutable_target_world_space_pos();
+    target_point->set_x(point.x);
+    target_point->set_y(point.y);
+    AddUnitTag(unit_command, unit->tag);
 }
 
 void ActionImp::UnitCommand(const Unit* unit, AbilityID ability, const Unit* target, bool queued_command) {
     if (!unit || !target) return;
-    UnitCommand(Units({ unit }), ability, target, queued_command);
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = AddUnitCommand(ability, queued_command);
+    unit_command->set_target_unit_tag(target->tag);
+    AddUnitTag(unit_command, unit->tag);
 }
 
 void ActionImp::UnitCommand(const Units& units, AbilityID ability, bool queued_command) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionRaw* action_raw = action->mutable_action_raw();
-    SC2APIProtocol::ActionRawUnitCommand* unit_command = action_raw->mutable_unit_command();
-
-    unit_command->set_ability_id(ability);
-    unit_command->set_queue_command(queued_command);
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = AddUnitCommand(ability, queued_command);
 
     for (auto unit : units) {
         if (!unit) continue;
-        unit_command->add_unit_tags(unit->tag);
+        AddUnitTag(unit_command, unit->tag);
     }
 }
 
 void ActionImp::UnitCommand(const Units& units, AbilityID ability, const Point2D& point, bool queued_command) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionRaw* action_raw = action->mutable_action_raw();
-    SC2APIProtocol::ActionRawUnitCommand* unit_command = action_raw->mutable_unit_command();
-
-    unit_command->set_ability_id(ability);
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = AddUnitCommand(ability, queued_command);
     SC2APIProtocol::Point2D* target_point = unit_command->mutable_target_world_space_pos();
     target_point->set_x(point.x);
     target_point->set_y(point.y);
-    unit_command->set_queue_command(queued_command);
 
     for (auto unit : units) {
         if (!unit) continue;
-        unit_command->add_unit_tags(unit->tag);
+        AddUnitTag(unit_command, unit->tag);
     }
 }
 
 void ActionImp::UnitCommand(const Units& units, AbilityID ability, const Unit* target, bool queued_command) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionRaw* action_raw = action->mutable_action_raw();
-    SC2APIProtocol::ActionRawUnitCommand* unit_command = action_raw->mutable_unit_command();
-
-    unit_command->set_ability_id(ability);
+    SC2APIProtocol::ActionRawUnitCommand* unit_command = AddUnitCommand(ability, queued_command);
     unit_command->set_target_unit_tag(target->tag);
-    unit_command->set_queue_command(queued_command);
 
     for (auto unit : units) {
         if (!unit) continue;
-        unit_command->add_unit_tags(unit->tag);
+        AddUnitTag(unit_command, unit->tag);
     }
 }
 
@@ -194,9 +443,12 @@ class ActionFeatureLayerImp : public ActionFeatureLayerInterface {
 public:
     ProtoInterface& proto_;
     ControlInterface& control_;
+    const ObservationInterface& observation_;
+    // Reused every step, holds actions to send if has_actions_ is set.
     GameRequestPtr request_actions_;
+    bool has_actions_;
 
-    ActionFeatureLayerImp(ProtoInterface& proto, ControlInterface& control);
+    ActionFeatureLayerImp(ProtoInterface& proto, ControlInterface& control, const ObservationInterface& observation);
 
     SC2APIProtocol::RequestAction* GetRequestAction();
 
@@ -205,49 +457,128 @@ public:
     void CameraMove(const Point2DI& center) override;
     void Select(const Point2DI& center, PointSelectionType selection_type) override;
     void Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) override;
+    size_t EncodeActions(const int32_t* data, size_t action_count) override;
 
     void SendActions() override;
+    void SetDeferredResponses(bool value) override;
+    const std::vector<uint32_t>& GetActionResults() const override;
+
+    bool deferred_responses_;
+    std::vector<uint32_t> action_results_;
+
+    // Index of the last camera move in the request if no action on the screen came after it, -1 otherwise. A camera
+    // move after it replaces it, the actions in between don't depend on the camera.
+    int camera_move_index_;
+
+    // Add the actions of the interface functions, false if the action is dropped.
+    bool AddUnitCommand(AbilityID ability);
+    bool AddUnitCommand(AbilityID ability, const Point2DI& point, bool minimap);
+    bool AddCameraMove(const Point2DI& center);
+    bool AddSelect(const Point2DI& center, PointSelectionType selection_type);
+    bool AddSelect(const Point2DI& p0, const Point2DI& p1, bool add_to_selection);
+
+private:
+
+    bool IsOnScreen(const Point2DI& point) const;
+    bool IsOnMinimap(const Point2DI& point) const;
+    // The action last added, if there is one.
+    const SC2APIProtocol::ActionSpatial* GetLastAction() const;
+    // Adds an action, on_screen if it targets the screen and so depends on the camera.
+    SC2APIProtocol::ActionSpatial* AddAction(bool on_screen);
 };
 
-ActionFeatureLayerImp::ActionFeatureLayerImp(ProtoInterface& proto, ControlInterface& control) :
+ActionFeatureLayerImp::ActionFeatureLayerImp(ProtoInterface& proto, ControlInterface& control, const ObservationInterface& observation) :
     proto_(proto),
-    control_(control) {
+    control_(control),
+    observation_(observation),
+    has_actions_(false),
+    deferred_responses_(false),
+    camera_move_index_(-1) {
+}
+
+void ActionFeatureLayerImp::SetDeferredResponses(bool value) {
+    deferred_responses_ = value;
+}
+
+const std::vector<uint32_t>& ActionFeatureLayerImp::GetActionResults() const {
+    return action_results_;
 }
 
 SC2APIProtocol::RequestAction* ActionFeatureLayerImp::GetRequestAction() {
-    if (request_actions_ == nullptr) {
-        request_actions_ = proto_.MakeRequest();
+    if (!has_actions_) {
+        proto_.ReuseRequest(request_actions_);
+        has_actions_ = true;
+        camera_move_index_ = -1;
     }
     return request_actions_->mutable_action();
 }
 
 void ActionFeatureLayerImp::SendActions() {
-    if (request_actions_ == nullptr) {
+    Point2D camera;
+    if (control_.TakeCameraMove(camera)) {
+        AddDebugCameraMove(GetRequestAction(), camera);
+    }
+
+    if (!has_actions_) {
         return;
     }
 
-    if (!proto_.SendRequest(request_actions_)) {
+    StepProfiler::Scope scope(control_.GetStepProfiler(), control_.GetStepProfilerClient(), StepPhase::SendActions);
+    if (!SendActionRequest(proto_, control_, request_actions_, deferred_responses_, action_results_)) {
         return;
     }
 
-    request_actions_ = nullptr;
-    control_.WaitForResponse();
+    has_actions_ = false;
 }
 
-void ActionFeatureLayerImp::UnitCommand(AbilityID ability) {
+// Without feature layers the resolution is 0 and anything goes, the game reports what it rejects.
+static bool IsInResolution(const Point2DI& point, int resolution_x, int resolution_y) {
+    if (resolution_x <= 0 || resolution_y <= 0) {
+        return true;
+    }
+
+    return point.x >= 0 && point.y >= 0 && point.x < resolution_x && point.y < resolution_y;
+}
+
+bool ActionFeatureLayerImp::IsOnScreen(const Point2DI& point) const {
+    const SpatialSetup& setup = observation_.GetGameInfo().options.feature_layer;
+    return IsInResolution(point, setup.map_resolution_x, setup.map_resolution_y);
+}
+
+bool ActionFeatureLayerImp::IsOnMinimap(const Point2DI& point) const {
+    const SpatialSetup& setup = observation_.GetGameInfo().options.feature_layer;
+    return IsInResolution(point, setup.minimap_resolution_x, setup.minimap_resolution_y);
+}
+
+const SC2APIProtocol::ActionSpatial* ActionFeatureLayerImp::GetLastAction() const {
+    if (!has_actions_ || request_actions_->action().actions_size() == 0) {
+        return nullptr;
+    }
+
+    const SC2APIProtocol::RequestAction& request_action = request_actions_->action();
+    return &request_action.actions(request_action.actions_size() - 1).action_feature_layer();
+}
+
+SC2APIProtocol::ActionSpatial* ActionFeatureLayerImp::AddAction(bool on_screen) {
     SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionSpatial* action_feature_layer = action->mutable_action_feature_layer();
-    SC2APIProtocol::ActionSpatialUnitCommand* unit_command = action_feature_layer->mutable_unit_command();
+    if (on_screen) {
+        camera_move_index_ = -1;
+    }
+    return request_action->add_actions()->mutable_action_feature_layer();
+}
+
+bool ActionFeatureLayerImp::AddUnitCommand(AbilityID ability) {
+    SC2APIProtocol::ActionSpatialUnitCommand* unit_command = AddAction(false)->mutable_unit_command();
     unit_command->set_ability_id(ability);
+    return true;
 }
 
-void ActionFeatureLayerImp::UnitCommand(AbilityID ability, const Point2DI& point, bool minimap) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionSpatial* action_feature_layer = action->mutable_action_feature_layer();
-    SC2APIProtocol::ActionSpatialUnitCommand* unit_command = action_feature_layer->mutable_unit_command();
+bool ActionFeatureLayerImp::AddUnitCommand(AbilityID ability, const Point2DI& point, bool minimap) {
+    if (minimap ? !IsOnMinimap(point) : !IsOnScreen(point)) {
+        return false;
+    }
 
+    SC2APIProtocol::ActionSpatialUnitCommand* unit_command = AddAction(!minimap)->mutable_unit_command();
     SC2APIProtocol::PointI* pt;
     if (minimap) {
         pt = unit_command->mutable_target_minimap_coord();
@@ -258,36 +589,69 @@ void ActionFeatureLayerImp::UnitCommand(AbilityID ability, const Point2DI& point
     pt->set_x(point.x);
     pt->set_y(point.y);
     unit_command->set_ability_id(ability);
+    return true;
 }
 
-void ActionFeatureLayerImp::CameraMove(const Point2DI& center) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionSpatial* action_feature_layer = action->mutable_action_feature_layer();
-    SC2APIProtocol::ActionSpatialCameraMove* camera_move = action_feature_layer->mutable_camera_move();
+bool ActionFeatureLayerImp::AddCameraMove(const Point2DI& center) {
+    if (!IsOnMinimap(center)) {
+        return false;
+    }
+
+    SC2APIProtocol::ActionSpatialCameraMove* camera_move;
+    if (camera_move_index_ >= 0) {
+        camera_move = GetRequestAction()->mutable_actions(camera_move_index_)->mutable_action_feature_layer()->mutable_camera_move();
+    }
+    else {
+        camera_move = AddAction(false)->mutable_camera_move();
+        camera_move_index_ = GetRequestAction()->actions_size() - 1;
+    }
 
     SC2APIProtocol::PointI* center_proto = camera_move->mutable_center_minimap();
     center_proto->set_x(center.x);
     center_proto->set_y(center.y);
+    return true;
 }
 
-void ActionFeatureLayerImp::Select(const Point2DI& center, PointSelectionType selection_type) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionSpatial* action_feature_layer = action->mutable_action_feature_layer();
-    SC2APIProtocol::ActionSpatialUnitSelectionPoint* select_pt = action_feature_layer->mutable_unit_selection_point();
+bool ActionFeatureLayerImp::AddSelect(const Point2DI& center, PointSelectionType selection_type) {
+    if (!IsOnScreen(center)) {
+        return false;
+    }
+
+    // Selecting the same again right after changes nothing, unless it toggles.
+    const SC2APIProtocol::ActionSpatial* last = GetLastAction();
+    SC2APIProtocol::ActionSpatialUnitSelectionPoint_Type type = static_cast<SC2APIProtocol::ActionSpatialUnitSelectionPoint_Type>(selection_type);
+    if (selection_type != PointSelectionType::PtToggle && last && last->has_unit_selection_point()) {
+        const SC2APIProtocol::ActionSpatialUnitSelectionPoint& last_select = last->unit_selection_point();
+        if (last_select.type() == type && last_select.selection_screen_coord().x() == center.x &&
+            last_select.selection_screen_coord().y() == center.y) {
+            return true;
+        }
+    }
 
+    SC2APIProtocol::ActionSpatialUnitSelectionPoint* select_pt = AddAction(true)->mutable_unit_selection_point();
     SC2APIProtocol::PointI* center_proto = select_pt->mutable_selection_screen_coord();
     center_proto->set_x(center.x);
     center_proto->set_y(center.y);
-    select_pt->set_type(static_cast<SC2APIProtocol::ActionSpatialUnitSelectionPoint_Type>(selection_type));
+    select_pt->set_type(type);
+    return true;
 }
 
-void ActionFeatureLayerImp::Select(const Point2DI& p0, const Point2DI& p1, bool /*add_to_selection*/) {
-    SC2APIProtocol::RequestAction* request_action = GetRequestAction();
-    SC2APIProtocol::Action* action = request_action->add_actions();
-    SC2APIProtocol::ActionSpatial* action_feature_layer = action->mutable_action_feature_layer();
-    SC2APIProtocol::ActionSpatialUnitSelectionRect* select_rect = action_feature_layer->mutable_unit_selection_rect();
+bool ActionFeatureLayerImp::AddSelect(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) {
+    if (!IsOnScreen(p0) || !IsOnScreen(p1)) {
+        return false;
+    }
+
+    const SC2APIProtocol::ActionSpatial* last = GetLastAction();
+    if (last && last->has_unit_selection_rect() && last->unit_selection_rect().selection_screen_coord_size() == 1) {
+        const SC2APIProtocol::ActionSpatialUnitSelectionRect& last_select = last->unit_selection_rect();
+        const SC2APIProtocol::RectangleI& rect = last_select.selection_screen_coord(0);
+        if (last_select.selection_add() == add_to_selection &&
+            rect.p0().x() == p0.x && rect.p0().y() == p0.y && rect.p1().x() == p1.x && rect.p1().y() == p1.y) {
+            return true;
+        }
+    }
+
+    SC2APIProtocol::ActionSpatialUnitSelectionRect* select_rect = AddAction(true)->mutable_unit_selection_rect();
     SC2APIProtocol::RectangleI* selection_screen_coord = select_rect->add_selection_screen_coord();
     SC2APIProtocol::PointI* selection_p0 = selection_screen_coord->mutable_p0();
     selection_p0->set_x(p0.x);
@@ -295,6 +659,104 @@ void ActionFeatureLayerImp::Select(const Point2DI& p0, const Point2DI& p1, bool
     SC2APIProtocol::PointI* selection_p1 = selection_screen_coord->mutable_p1();
     selection_p1->set_x(p1.x);
     selection_p1->set_y(p1.y);
+    select_rect->set_selection_add(add_to_selection);
+    return true;
+}
+
+void ActionFeatureLayerImp::UnitCommand(AbilityID ability) {
+    AddUnitCommand(ability);
+}
+
+void ActionFeatureLayerImp::UnitCommand(AbilityID ability, const Point2DI& point, bool minimap) {
+    AddUnitCommand(ability, point, minimap);
+}
+
+void ActionFeatureLayerImp::CameraMove(const Point2DI& center) {
+    AddCameraMove(center);
+}
+
+void ActionFeatureLayerImp::Select(const Point2DI& center, PointSelectionType selection_type) {
+    AddSelect(center, selection_type);
+}
+
+void ActionFeatureLayerImp::Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) {
+    AddSelect(p0, p1, add_to_selection);
+}
+
+namespace {
+
+// Passes an action of EncodeActions on to the function of its type, false if it's malformed or dropped.
+template<class Add>
+bool DecodeSpatialAction(const int32_t* data, Add& add) {
+    int32_t argument = data[1];
+    Point2DI p0(data[2], data[3]);
+    Point2DI p1(data[4], data[5]);
+
+    switch (static_cast<SpatialActionType>(data[0])) {
+        case SpatialActionType::NoOp:
+            return true;
+        case SpatialActionType::UnitCommand:
+            return argument > 0 && add.UnitCommand(static_cast<uint32_t>(argument));
+        case SpatialActionType::UnitCommandScreen:
+            return argument > 0 && add.UnitCommand(static_cast<uint32_t>(argument), p0, false);
+        case SpatialActionType::UnitCommandMinimap:
+            return argument > 0 && add.UnitCommand(static_cast<uint32_t>(argument), p0, true);
+        case SpatialActionType::CameraMove:
+            return add.CameraMove(p0);
+        case SpatialActionType::SelectPoint:
+            return argument >= static_cast<int32_t>(PointSelectionType::PtSelect) &&
+                argument <= static_cast<int32_t>(PointSelectionType::PtAddAllType) &&
+                add.Select(p0, static_cast<PointSelectionType>(argument));
+        case SpatialActionType::SelectRect:
+            return add.Select(p0, p1, argument != 0);
+    }
+
+    return false;
+}
+
+// Adds through the interface, which doesn't say whether it dropped an action.
+struct InterfaceSpatialActions {
+    ActionFeatureLayerInterface& actions;
+
+    bool UnitCommand(AbilityID ability) { actions.UnitCommand(ability); return true; }
+    bool UnitCommand(AbilityID ability, const Point2DI& point, bool minimap) { actions.UnitCommand(ability, point, minimap); return true; }
+    bool CameraMove(const Point2DI& center) { actions.CameraMove(center); return true; }
+    bool Select(const Point2DI& center, PointSelectionType selection_type) { actions.Select(center, selection_type); return true; }
+    bool Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) { actions.Select(p0, p1, add_to_selection); return true; }
+};
+
+struct ImpSpatialActions {
+    ActionFeatureLayerImp& actions;
+
+    bool UnitCommand(AbilityID ability) { return actions.AddUnitCommand(ability); }
+    bool UnitCommand(AbilityID ability, const Point2DI& point, bool minimap) { return actions.AddUnitCommand(ability, point, minimap); }
+    bool CameraMove(const Point2DI& center) { return actions.AddCameraMove(center); }
+    bool Select(const Point2DI& center, PointSelectionType selection_type) { return actions.AddSelect(center, selection_type); }
+    bool Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) { return actions.AddSelect(p0, p1, add_to_selection); }
+};
+
+template<class Add>
+size_t DecodeSpatialActions(const int32_t* data, size_t action_count, Add& add) {
+    size_t accepted = 0;
+    for (size_t i = 0; i < action_count; ++i, data += SpatialActionWidth) {
+        if (DecodeSpatialAction(data, add)) {
+            ++accepted;
+        }
+    }
+
+    return accepted;
+}
+
+}
+
+size_t ActionFeatureLayerInterface::EncodeActions(const int32_t* data, size_t action_count) {
+    InterfaceSpatialActions add{ *this };
+    return DecodeSpatialActions(data, action_count, add);
+}
+
+size_t ActionFeatureLayerImp::EncodeActions(const int32_t* data, size_t action_count) {
+    ImpSpatialActions add{ *this };
+    return DecodeSpatialActions(data, action_count, add);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -320,7 +782,7 @@ AgentControlImp::AgentControlImp(Agent* agent, ControlInterface* control_interfa
     actions_(nullptr),
     agent_(agent) {
     actions_ = std::make_unique<ActionImp>(control_interface_->Proto(), *control_interface);
-    actions_feature_layer_ = std::make_unique<ActionFeatureLayerImp>(control_interface_->Proto(), *control_interface);
+    actions_feature_layer_ = std::make_unique<ActionFeatureLayerImp>(control_interface_->Proto(), *control_interface, *agent->Observation());
 }
 
 bool AgentControlImp::Restart() {
@@ -0,0 +1,113 @@
+#include "sc2api/sc2_batch_coordinator.h"
+#include "sc2api/sc2_coordinator.h"
+
+#include <cassert>
+#include <chrono>
+
+namespace sc2 {
+
+// How long Update waits for a game to finish before polling the others for a response from SC2 again.
+static const int BatchPollIntervalMs = 1;
+
+BatchCoordinator::BatchCoordinator(size_t thread_count, bool pin_threads) :
+    thread_pool_(thread_count, pin_threads),
+    updates_finished_(0) {
+}
+
+BatchCoordinator::~BatchCoordinator() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    update_finished_.wait(lock, [this]() {
+        for (const Game& game : games_) {
+            if (game.updating) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    // The games outlive the batch, don't leave them pointing at its pool and cache.
+    for (const Game& game : games_) {
+        game.coordinator->SetThreadPool(nullptr);
+        game.coordinator->SetGameDataCache(nullptr);
+    }
+}
+
+void BatchCoordinator::AddGame(Coordinator* game) {
+    assert(game);
+    game->SetThreadPool(&thread_pool_);
+    game->SetGameDataCache(&game_data_cache_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    games_.push_back(Game{ game, true, false });
+}
+
+size_t BatchCoordinator::GetGameCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return games_.size();
+}
+
+Coordinator* BatchCoordinator::GetGame(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < games_.size() ? games_[index].coordinator : nullptr;
+}
+
+bool BatchCoordinator::IsRunning(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < games_.size() && games_[index].running;
+}
+
+bool BatchCoordinator::Update() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const size_t updates_at_start = updates_finished_;
+
+    for (;;) {
+        bool any_running = false;
+        for (size_t i = 0; i < games_.size(); ++i) {
+            if (!games_[i].running) {
+                continue;
+            }
+
+            any_running = true;
+            if (games_[i].updating) {
+                continue;
+            }
+
+            // Only this thread touches a game that isn't being updated, so it can be polled without the lock. Sending
+            // the steps right away lets SC2 simulate while other games are polled and updated.
+            Coordinator* game = games_[i].coordinator;
+            lock.unlock();
+            game->RequestSteps();
+            bool ready = game->IsReadyToUpdate();
+            lock.lock();
+
+            if (ready) {
+                games_[i].updating = true;
+                thread_pool_.Submit([this, i, game]() { UpdateGame(i, game); });
+            }
+        }
+
+        if (!any_running) {
+            return false;
+        }
+
+        if (updates_finished_ != updates_at_start) {
+            return true;
+        }
+
+        update_finished_.wait_for(lock, std::chrono::milliseconds(BatchPollIntervalMs));
+    }
+}
+
+void BatchCoordinator::UpdateGame(size_t index, Coordinator* game) {
+    // The game is passed in rather than read from games_, which AddGame may reallocate while this runs. Indices stay
+    // valid, games are never removed.
+    bool running = game->Update();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    games_[index].running = running;
+    games_[index].updating = false;
+    ++updates_finished_;
+    update_finished_.notify_all();
+}
+
+}
@@ -4,12 +4,16 @@
 #include "sc2api/sc2_control_interfaces.h"
 #include "sc2api/sc2_proto_to_pods.h"
 #include "sc2api/sc2_game_settings.h"
+#include "sc2api/sc2_game_data_cache.h"
+#include "sc2api/sc2_step_profiler.h"
 
 #include "sc2utils/sc2_manage_process.h"
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <cassert>
 #include <limits>
 #include <fstream>
@@ -32,7 +36,17 @@ public:
 
     // Game state info.
     UnitPool unit_pool_;
-    std::unordered_map<Tag, Unit> units_previous_map_;
+
+    // What the events need of the units of the previous observation, sorted by tag. The units themselves stay in
+    // unit_pool_ and are updated in place.
+    struct PreviousUnit {
+        Tag tag;
+        bool has_orders;
+        bool built;
+    };
+    std::vector<PreviousUnit> units_previous_;
+    // Set while an event that compares to the previous observation is subscribed to.
+    bool track_previous_units_ = true;
     uint32_t current_game_loop_;
     uint32_t previous_game_loop;
     RawActions raw_actions_;
@@ -80,6 +94,9 @@ public:
     mutable bool buffs_cached_;
     mutable bool effects_cached_;
 
+    // Ability and unit type data shared with other clients, not owned.
+    GameDataCache* game_data_cache_ = nullptr;
+
     std::vector<PlayerResult> player_results_;
 
     ObservationImp(ProtoInterface& proto, ObservationPtr& observation, ResponseObservationPtr& response, ControlInterface& control);
@@ -127,6 +144,9 @@ public:
     const SC2APIProtocol::Observation* GetRawObservation() const final;
 
     bool UpdateObservation();
+    // Fills units_previous_ from the units in the pool.
+    void SavePreviousUnits();
+    std::string GetGameDataCacheKey() const;
 };
 
 ObservationImp::ObservationImp(ProtoInterface& proto, ObservationPtr& observation, ResponseObservationPtr& response, ControlInterface& control) :
@@ -194,6 +214,16 @@ const Abilities& ObservationImp::GetAbilityData(bool force_refresh) const {
         return abilities_;
     }
 
+    // Another game on the same version and map may have queried the data already.
+    std::string cache_key;
+    if (game_data_cache_ && !force_refresh) {
+        cache_key = GetGameDataCacheKey();
+        if (game_data_cache_->GetAbilities(cache_key, abilities_)) {
+            abilities_cached_ = true;
+            return abilities_;
+        }
+    }
+
     abilities_.clear();
 
     // Send a request for ability ids.
@@ -238,6 +268,9 @@ const Abilities& ObservationImp::GetAbilityData(bool force_refresh) const {
     }
 
     abilities_cached_ = true;
+    if (game_data_cache_ && !force_refresh) {
+        game_data_cache_->SetAbilities(cache_key, abilities_);
+    }
     return abilities_;
 }
 
@@ -250,6 +283,15 @@ const UnitTypes& ObservationImp::GetUnitTypeData(bool force_refresh) const {
         return unit_types_;
     }
 
+    std::string cache_key;
+    if (game_data_cache_ && !force_refresh) {
+        cache_key = GetGameDataCacheKey();
+        if (game_data_cache_->GetUnitTypes(cache_key, unit_types_)) {
+            unit_types_cached = true;
+            return unit_types_;
+        }
+    }
+
     unit_types_.clear();
 
     // Send a request for ability ids.
@@ -280,9 +322,16 @@ const UnitTypes& ObservationImp::GetUnitTypeData(bool force_refresh) const {
     }
 
     unit_types_cached = true;
+    if (game_data_cache_ && !force_refresh) {
+        game_data_cache_->SetUnitTypes(cache_key, unit_types_);
+    }
     return unit_types_;
 }
 
+std::string ObservationImp::GetGameDataCacheKey() const {
+    return GameDataCache::MakeKey(proto_.GetBaseBuild(), proto_.GetDataVersion(), GetGameInfo().local_map_path);
+}
+
 const Upgrades& ObservationImp::GetUpgradeData(bool force_refresh) const {
     if (force_refresh || upgrade_ids_.size() < 1) {
         upgrades_cached_ = false;
@@ -521,6 +570,16 @@ float ObservationImp::TerrainHeight(const Point2D& point) const {
     return decodedHeight;
 }
 
+void ObservationImp::SavePreviousUnits() {
+    units_previous_.clear();
+    unit_pool_.ForEachExistingUnit([&](Unit& unit) {
+        units_previous_.push_back(PreviousUnit{ unit.tag, !unit.orders.empty(), unit.build_progress >= 1.0f });
+    });
+    std::sort(units_previous_.begin(), units_previous_.end(), [](const PreviousUnit& a, const PreviousUnit& b) {
+        return a.tag < b.tag;
+    });
+}
+
 bool ObservationImp::UpdateObservation() {
     // Convert observation into data.
     if (!Convert(observation_, score_)) {
@@ -585,10 +644,10 @@ bool ObservationImp::UpdateObservation() {
         return false;
     }
 
-    units_previous_map_.clear();
-    unit_pool_.ForEachExistingUnit([&](Unit& unit) {
-        units_previous_map_[unit.tag] = unit;
-    });
+    units_previous_.clear();
+    if (track_previous_units_) {
+        SavePreviousUnits();
+    }
 
     unit_pool_.ClearExisting();
 
@@ -655,6 +714,8 @@ public:
     ProtoInterface& proto_;
     ControlInterface& control_;
     ObservationInterface& observation_;
+    // Reused by every query.
+    GameRequestPtr request_;
 
     QueryImp(ProtoInterface& proto, ControlInterface& control, ObservationInterface& observation);
 
@@ -693,7 +754,7 @@ std::vector<AvailableAbilities> QueryImp::GetAbilitiesForUnits(const Units& unit
             return available_abilities_out;
         }
 
-        GameRequestPtr request = proto_.MakeRequest();
+        GameRequestPtr& request = proto_.ReuseRequest(request_);
         SC2APIProtocol::RequestQuery* query = request->mutable_query();
         query->set_ignore_resource_requirements(ignore_resource_requirements);
         for (const auto unit : units) {
@@ -765,7 +826,7 @@ float QueryImp::PathingDistance(const Unit* start_unit, const Point2D& end) {
 }
 
 std::vector<float> QueryImp::PathingDistance(const std::vector<PathingQuery>& queries) {
-    GameRequestPtr request = proto_.MakeRequest();
+    GameRequestPtr& request = proto_.ReuseRequest(request_);
     SC2APIProtocol::RequestQuery* request_query = request->mutable_query();
 
     for (const PathingQuery& query : queries) {
@@ -824,7 +885,7 @@ bool QueryImp::Placement(const AbilityID& ability, const Point2D& target_pos, co
 }
 
 std::vector<bool> QueryImp::Placement(const std::vector<PlacementQuery>& queries) {
-    GameRequestPtr request = proto_.MakeRequest();
+    GameRequestPtr& request = proto_.ReuseRequest(request_);
     SC2APIProtocol::RequestQuery* request_query = request->mutable_query();
 
     for (const PlacementQuery& query : queries) {
@@ -884,28 +945,58 @@ public:
         Color color;
         uint32_t size = 0;
     };
-    std::vector<DebugText> debug_text_;
 
     struct DebugLine {
         Point3D p0;
         Point3D p1;
         Color color;
     };
-    std::vector<DebugLine> debug_line_;
 
     struct DebugBox {
         Point3D p_min;
         Point3D p_max;
         Color color;
     };
-    std::vector<DebugBox> debug_box_;
 
     struct DebugSphere {
         Point3D p_;
         float r_;
         Color color_;
     };
-    std::vector<DebugSphere> debug_sphere_;
+
+    struct DebugPrimitives {
+        std::vector<DebugText> text;
+        std::vector<DebugLine> lines;
+        std::vector<DebugBox> boxes;
+        std::vector<DebugSphere> spheres;
+
+        bool Empty() const;
+        void Clear();
+        bool operator==(const DebugPrimitives& other) const;
+    };
+
+    struct DebugLayer {
+        DebugLayer() :
+            begun(false) {
+        }
+
+        // What the game displays, serialized in draw.
+        DebugPrimitives drawn;
+        SC2APIProtocol::DebugDraw draw;
+        // Drawn since the layer was begun, replaces drawn on SendDebug if it differs.
+        DebugPrimitives next;
+        bool begun;
+    };
+
+    // Layers by name. The unnamed layer holds the primitives that only draw until the next SendDebug, it's begun on
+    // every SendDebug.
+    std::map<std::string, DebugLayer> layers_;
+    // Primitives go to the next primitives of this layer.
+    DebugLayer* drawing_;
+    // A layer changed since the last debug request, so it has to send the primitives again.
+    bool draw_dirty_;
+    // The game drops the primitives on a restart, noticed by the game loop going back.
+    uint32_t last_game_loop_;
 
     std::vector<SC2APIProtocol::DebugGameState> debug_state_;
 
@@ -942,6 +1033,9 @@ public:
     bool set_score_;
     float score_;
 
+    // Reused by every SendDebug.
+    GameRequestPtr request_;
+
     DebugImp(ProtoInterface& proto, ObservationInterface& observation, ControlInterface& control);
 
     void DebugTextOut(const std::string& out, Color color = Colors::White) override;
@@ -970,19 +1064,151 @@ public:
     void DebugSetShields(float value, const Unit* unit) override;
     void DebugMoveCamera(const Point2D& pos) override;
     void DebugTestApp(AppTest app_test, int delay_ms) override;
+    void DebugBeginLayer(const std::string& name) override;
+    void DebugClearLayer(const std::string& name) override;
     void SendDebug() override;
+
+    // Takes the camera move of DebugMoveCamera, sent with the next actions.
+    bool TakeCameraMove(Point2D& pos);
+
+private:
+    bool HasCommands() const;
+    void UpdateLayers();
 };
 
+static void SetDebugPoint(SC2APIProtocol::Point* point, const Point3D& p) {
+    point->set_x(p.x);
+    point->set_y(p.y);
+    point->set_z(p.z);
+}
+
+static void SetDebugColor(SC2APIProtocol::Color* proto_color, const Color& color) {
+    proto_color->set_r(color.r);
+    proto_color->set_g(color.g);
+    proto_color->set_b(color.b);
+}
+
+static bool SameDebugPoint(const Point3D& a, const Point3D& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool SameDebugColor(const Color& a, const Color& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+bool DebugImp::DebugPrimitives::Empty() const {
+    return text.empty() && lines.empty() && boxes.empty() && spheres.empty();
+}
+
+void DebugImp::DebugPrimitives::Clear() {
+    text.clear();
+    lines.clear();
+    boxes.clear();
+    spheres.clear();
+}
+
+bool DebugImp::DebugPrimitives::operator==(const DebugPrimitives& other) const {
+    if (text.size() != other.text.size() || lines.size() != other.lines.size() ||
+        boxes.size() != other.boxes.size() || spheres.size() != other.spheres.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        const DebugText& a = text[i];
+        const DebugText& b = other.text[i];
+        if (a.text != b.text || a.has_coords != b.has_coords || a.size != b.size || !SameDebugColor(a.color, b.color)) {
+            return false;
+        }
+        if (a.has_coords && (a.is_3d != b.is_3d || !SameDebugPoint(a.pt, b.pt))) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const DebugLine& a = lines[i];
+        const DebugLine& b = other.lines[i];
+        if (!SameDebugPoint(a.p0, b.p0) || !SameDebugPoint(a.p1, b.p1) || !SameDebugColor(a.color, b.color)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        const DebugBox& a = boxes[i];
+        const DebugBox& b = other.boxes[i];
+        if (!SameDebugPoint(a.p_min, b.p_min) || !SameDebugPoint(a.p_max, b.p_max) || !SameDebugColor(a.color, b.color)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        const DebugSphere& a = spheres[i];
+        const DebugSphere& b = other.spheres[i];
+        if (!SameDebugPoint(a.p_, b.p_) || a.r_ != b.r_ || !SameDebugColor(a.color_, b.color_)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void BuildDebugDraw(const DebugImp::DebugPrimitives& primitives, SC2APIProtocol::DebugDraw* draw) {
+    draw->Clear();
+
+    for (const DebugImp::DebugText& entry : primitives.text) {
+        SC2APIProtocol::DebugText* debug_text = draw->add_text();
+        debug_text->set_text(entry.text);
+        debug_text->set_size(entry.size);
+        if (entry.has_coords) {
+            if (entry.is_3d) {
+                SetDebugPoint(debug_text->mutable_world_pos(), entry.pt);
+            }
+            else {
+                SC2APIProtocol::Point* pos = debug_text->mutable_virtual_pos();
+                pos->set_x(entry.pt.x);
+                pos->set_y(entry.pt.y);
+            }
+        }
+        SetDebugColor(debug_text->mutable_color(), entry.color);
+    }
+
+    for (const DebugImp::DebugLine& line : primitives.lines) {
+        SC2APIProtocol::DebugLine* debug_line = draw->add_lines();
+        SC2APIProtocol::Line* proto_line = debug_line->mutable_line();
+        SetDebugPoint(proto_line->mutable_p0(), line.p0);
+        SetDebugPoint(proto_line->mutable_p1(), line.p1);
+        SetDebugColor(debug_line->mutable_color(), line.color);
+    }
+
+    for (const DebugImp::DebugBox& box : primitives.boxes) {
+        SC2APIProtocol::DebugBox* debug_box = draw->add_boxes();
+        SetDebugPoint(debug_box->mutable_min(), box.p_min);
+        SetDebugPoint(debug_box->mutable_max(), box.p_max);
+        SetDebugColor(debug_box->mutable_color(), box.color);
+    }
+
+    for (const DebugImp::DebugSphere& sphere : primitives.spheres) {
+        SC2APIProtocol::DebugSphere* debug_sphere = draw->add_spheres();
+        SetDebugPoint(debug_sphere->mutable_p(), sphere.p_);
+        debug_sphere->set_r(sphere.r_);
+        SetDebugColor(debug_sphere->mutable_color(), sphere.color_);
+    }
+}
+
 DebugImp::DebugImp(ProtoInterface& proto, ObservationInterface& observation, ControlInterface& control) :
     proto_(proto),
     observation_(observation),
     control_(control),
+    drawing_(nullptr),
+    draw_dirty_(false),
+    last_game_loop_(0),
     has_move_camera(false),
     app_test_set_(false),
     endgame_surrender_(false),
     endgame_victory_(false),
     set_score_(false),
     score_(0.0f) {
+    drawing_ = &layers_[std::string()];
+    drawing_->begun = true;
 }
 
 void DebugImp::DebugTextOut(const std::string& out, Color color) {
@@ -990,7 +1216,7 @@ void DebugImp::DebugTextOut(const std::string& out, Color color) {
     debug_text.text = out;
     debug_text.has_coords = false;
     debug_text.color = color;
-    debug_text_.push_back(debug_text);
+    drawing_->next.text.push_back(debug_text);
 }
 
 void DebugImp::DebugTextOut(const std::string& out, const Point2D& pt_virtual_2D, Color color, uint32_t size) {
@@ -1002,7 +1228,7 @@ void DebugImp::DebugTextOut(const std::string& out, const Point2D& pt_virtual_2D
     debug_text.pt.y = pt_virtual_2D.y;
     debug_text.color = color;
     debug_text.size = size;
-    debug_text_.push_back(debug_text);
+    drawing_->next.text.push_back(debug_text);
 }
 
 void DebugImp::DebugTextOut(const std::string& out, const Point3D& pt3D, Color color, uint32_t size) {
@@ -1015,7 +1241,7 @@ void DebugImp::DebugTextOut(const std::string& out, const Point3D& pt3D, Color c
     debug_text.pt.z = pt3D.z;
     debug_text.color = color;
     debug_text.size = size;
-    debug_text_.push_back(debug_text);
+    drawing_->next.text.push_back(debug_text);
 }
 
 void DebugImp::DebugLineOut(const Point3D& p0, const Point3D& p1, Color color) {
@@ -1023,7 +1249,7 @@ void DebugImp::DebugLineOut(const Point3D& p0, const Point3D& p1, Color color) {
     line.p0 = p0;
     line.p1 = p1;
     line.color = color;
-    debug_line_.push_back(line);
+    drawing_->next.lines.push_back(line);
 }
 
 void DebugImp::DebugBoxOut(const Point3D& p_min, const Point3D& p_max, Color color) {
@@ -1031,7 +1257,7 @@ void DebugImp::DebugBoxOut(const Point3D& p_min, const Point3D& p_max, Color col
     box.p_min = p_min;
     box.p_max = p_max;
     box.color = color;
-    debug_box_.push_back(box);
+    drawing_->next.boxes.push_back(box);
 }
 
 void DebugImp::DebugSphereOut(const Point3D& p, float r, Color color) {
@@ -1039,7 +1265,7 @@ void DebugImp::DebugSphereOut(const Point3D& p, float r, Color color) {
     sphere.p_ = p;
     sphere.r_ = r;
     sphere.color_ = color;
-    debug_sphere_.push_back(sphere);
+    drawing_->next.spheres.push_back(sphere);
 }
 
 void DebugImp::DebugShowMap() {
@@ -1154,91 +1380,94 @@ void DebugImp::DebugTestApp(AppTest app_test, int delay_ms) {
     app_test_delay_ms_ = delay_ms;
 }
 
-void DebugImp::SendDebug() {
-    GameRequestPtr request = proto_.MakeRequest();
-    SC2APIProtocol::RequestDebug* request_debug = request->mutable_debug();
+void DebugImp::DebugBeginLayer(const std::string& name) {
+    drawing_ = &layers_[name];
+    if (!drawing_->begun) {
+        drawing_->next.Clear();
+        drawing_->begun = true;
+    }
+}
 
-    for (const DebugText& entry : debug_text_) {
-        SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
-        SC2APIProtocol::DebugText* debug_text = command->mutable_draw()->add_text();
-        debug_text->set_text(entry.text);
-        debug_text->set_size(entry.size);
-        if (entry.has_coords) {
-            if (entry.is_3d) {
-                SC2APIProtocol::Point* pos = debug_text->mutable_world_pos();
-                pos->set_x(entry.pt.x);
-                pos->set_y(entry.pt.y);
-                pos->set_z(entry.pt.z);
-            }
-            else {
-                SC2APIProtocol::Point* pos = debug_text->mutable_virtual_pos();
-                pos->set_x(entry.pt.x);
-                pos->set_y(entry.pt.y);
-            }
-        }
-        SC2APIProtocol::Color* color_text = debug_text->mutable_color();
-        color_text->set_r(entry.color.r);
-        color_text->set_g(entry.color.g);
-        color_text->set_b(entry.color.b);
+void DebugImp::DebugClearLayer(const std::string& name) {
+    if (name.empty()) {
+        return;
     }
 
-    for (const DebugLine& line : debug_line_) {
-        SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
-        SC2APIProtocol::DebugLine* debug_line = command->mutable_draw()->add_lines();
-        SC2APIProtocol::Line* proto_line = debug_line->mutable_line();
+    auto found = layers_.find(name);
+    if (found == layers_.end()) {
+        return;
+    }
 
-        SC2APIProtocol::Point* p0 = proto_line->mutable_p0();
-        p0->set_x(line.p0.x);
-        p0->set_y(line.p0.y);
-        p0->set_z(line.p0.z);
+    if (drawing_ == &found->second) {
+        drawing_ = &layers_[std::string()];
+    }
 
-        SC2APIProtocol::Point* p1 = proto_line->mutable_p1();
-        p1->set_x(line.p1.x);
-        p1->set_y(line.p1.y);
-        p1->set_z(line.p1.z);
+    if (!found->second.drawn.Empty()) {
+        draw_dirty_ = true;
+    }
+    layers_.erase(found);
+}
 
-        SC2APIProtocol::Color* color_line = debug_line->mutable_color();
-        color_line->set_r(line.color.r);
-        color_line->set_g(line.color.g);
-        color_line->set_b(line.color.b);
+bool DebugImp::TakeCameraMove(Point2D& pos) {
+    if (!has_move_camera) {
+        return false;
     }
 
-    for (const DebugBox& box : debug_box_) {
-        SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
-        SC2APIProtocol::DebugBox* debug_box = command->mutable_draw()->add_boxes();
+    pos = debug_move_camera_;
+    has_move_camera = false;
+    return true;
+}
 
-        SC2APIProtocol::Point* p_min = debug_box->mutable_min();
-        p_min->set_x(box.p_min.x);
-        p_min->set_y(box.p_min.y);
-        p_min->set_z(box.p_min.z);
+bool DebugImp::HasCommands() const {
+    return !debug_unit_values_.empty() || !debug_state_.empty() || !debug_unit_.empty() || !debug_kill_tag_.empty() ||
+        app_test_set_ || set_score_ || endgame_surrender_ || endgame_victory_;
+}
+
+void DebugImp::UpdateLayers() {
+    uint32_t game_loop = observation_.GetGameLoop();
+    if (game_loop < last_game_loop_) {
+        draw_dirty_ = true;
+    }
+    last_game_loop_ = game_loop;
 
-        SC2APIProtocol::Point* p_max = debug_box->mutable_max();
-        p_max->set_x(box.p_max.x);
-        p_max->set_y(box.p_max.y);
-        p_max->set_z(box.p_max.z);
+    for (auto& entry : layers_) {
+        DebugLayer& layer = entry.second;
+        if (!layer.begun) {
+            continue;
+        }
 
-        SC2APIProtocol::Color* color_box = debug_box->mutable_color();
-        color_box->set_r(box.color.r);
-        color_box->set_g(box.color.g);
-        color_box->set_b(box.color.b);
+        // Only layers that changed are serialized again.
+        if (!(layer.next == layer.drawn)) {
+            std::swap(layer.drawn, layer.next);
+            BuildDebugDraw(layer.drawn, &layer.draw);
+            draw_dirty_ = true;
+        }
+        layer.next.Clear();
+        layer.begun = false;
     }
 
-    for (const DebugSphere& sphere : debug_sphere_) {
-        SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
-        SC2APIProtocol::DebugSphere* debug_sphere = command->mutable_draw()->add_spheres();
+    drawing_ = &layers_[std::string()];
+    drawing_->begun = true;
+}
 
-        SC2APIProtocol::Point* p = debug_sphere->mutable_p();
-        p->set_x(sphere.p_.x);
-        p->set_y(sphere.p_.y);
-        p->set_z(sphere.p_.z);
+void DebugImp::SendDebug() {
+    UpdateLayers();
 
-        debug_sphere->set_r(sphere.r_);
+    // Nothing to change, the game keeps displaying what it has.
+    if (!draw_dirty_ && !HasCommands()) {
+        return;
+    }
 
-        SC2APIProtocol::Color* color_sphere = debug_sphere->mutable_color();
-        color_sphere->set_r(sphere.color_.r);
-        color_sphere->set_g(sphere.color_.g);
-        color_sphere->set_b(sphere.color_.b);
+    GameRequestPtr& request = proto_.ReuseRequest(request_);
+    SC2APIProtocol::RequestDebug* request_debug = request->mutable_debug();
+
+    // The primitives of a request replace all those displayed, so every layer is sent when one of them changed.
+    for (const auto& entry : layers_) {
+        if (!entry.second.drawn.Empty()) {
+            request_debug->add_debug()->mutable_draw()->CopyFrom(entry.second.draw);
+        }
     }
+    draw_dirty_ = false;
 
     for (const DebugSetUnitValue& set_unit_value : debug_unit_values_) {
         SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
@@ -1292,6 +1521,7 @@ void DebugImp::SendDebug() {
         test_process->set_test(static_cast<SC2APIProtocol::DebugTestProcess_Test>(app_test_));
         test_process->set_delay_ms(app_test_delay_ms_);
     }
+    app_test_set_ = false;
 
     if (set_score_) {
         SC2APIProtocol::DebugCommand* command = request_debug->add_debug();
@@ -1316,11 +1546,6 @@ void DebugImp::SendDebug() {
     endgame_victory_ = false;
 
     proto_.SendRequest(request);
-    debug_text_.clear();
-    debug_line_.clear();
-    debug_box_.clear();
-    debug_sphere_.clear();
-
     debug_state_.clear();
     debug_unit_.clear();
     debug_kill_tag_.clear();
@@ -1328,22 +1553,6 @@ void DebugImp::SendDebug() {
 
     // Wait for the response.
     control_.WaitForResponse();
-
-    if (has_move_camera) {
-        GameRequestPtr camera_request = proto_.MakeRequest();
-        SC2APIProtocol::RequestAction* request_action = camera_request->mutable_action();
-        SC2APIProtocol::Action* action = request_action->add_actions();
-        SC2APIProtocol::ActionRaw* action_raw = action->mutable_action_raw();
-        SC2APIProtocol::ActionRawCameraMove* camera_move = action_raw->mutable_camera_move();
-
-        SC2APIProtocol::Point* point = camera_move->mutable_center_world_space();
-        point->set_x(debug_move_camera_.x);
-        point->set_y(debug_move_camera_.y);
-
-        has_move_camera = false;
-        proto_.SendRequest(camera_request);
-        control_.WaitForResponse();
-    }
 }
 
 
@@ -1373,6 +1582,23 @@ public:
     std::unique_ptr<DebugImp> debug_imp_;
     ProcessInfo pi_;
 
+    StepProfiler* step_profiler_;
+    int step_profiler_client_;
+
+    // Requests sent every step, reused.
+    GameRequestPtr request_step_;
+    GameRequestPtr request_observation_;
+
+    StepRequestStatus step_request_status_;
+    // Deferred action failures before the last RequestStepObservation.
+    uint32_t action_failures_;
+
+    // Units given commands in the last actions sent, for the idle events. Reused every step.
+    std::unordered_set<Tag> command_tags_;
+
+    EventSubscriptions event_subscriptions_;
+    std::vector<ClientEvent> events_;
+
     // Errors that may have occured during calls to the various interfaces.
     std::vector<ClientError> client_errors_;
     std::vector<std::string> protocol_errors_;
@@ -1398,6 +1624,10 @@ public:
     bool Step(int count = 1) override;
     bool WaitStep() override;
 
+    bool RequestStepObservation(int count = 1) override;
+    bool WaitStepObservation() override;
+    const StepRequestStatus& GetStepRequestStatus() const override { return step_request_status_; };
+
     bool SaveReplay(const std::string& path) override;
 
     bool Ping() override;
@@ -1415,6 +1645,7 @@ public:
     bool HasResponsePending() const override;
 
     bool GetObservation() override;
+    bool ReadObservation(const GameResponsePtr& response);
     bool PollResponse() override;
     bool ConsumeResponse() override;
 
@@ -1424,9 +1655,12 @@ public:
     void Error(ClientError error, const std::vector<std::string>& errors = {}) override;
     void ErrorIf(bool condition, ClientError error, const std::vector<std::string>& errors = {}) override;
 
+    void SetEventSubscriptions(const EventSubscriptions& subscriptions);
+    void AddEvent(ClientEventType type, const Unit* unit = nullptr, UpgradeID upgrade = UpgradeID());
+
     void IssueUnitDestroyedEvents();
     void IssueUnitAddedEvents();
-    void IssueIdleEvent(const Unit* unit, const std::vector<Tag>& commands);
+    void IssueIdleEvent(const Unit* unit, const std::unordered_set<Tag>& commands);
     void IssueBuildingCompletedEvent(const Unit* unit);
     void IssueAlertEvents();
     void IssueUpgradeEvents();
@@ -1441,6 +1675,11 @@ public:
     void ClearClientErrors() override { client_errors_.clear(); };
     void ClearProtocolErrors() override { protocol_errors_.clear(); };
     void UseGeneralizedAbility(bool value) override { observation_imp_->use_generalized_ability_ = value; };
+    void SetGameDataCache(GameDataCache* cache) override { observation_imp_->game_data_cache_ = cache; };
+    void SetStepProfiler(StepProfiler* profiler, int client_id) override { step_profiler_ = profiler; step_profiler_client_ = client_id; };
+    StepProfiler* GetStepProfiler() const override { return step_profiler_; };
+    int GetStepProfilerClient() const override { return step_profiler_client_; };
+    bool TakeCameraMove(Point2D& pos) override { return debug_imp_->TakeCameraMove(pos); };
 
     virtual void Save();
     virtual void Load();
@@ -1452,7 +1691,10 @@ ControlImp::ControlImp(Client& client) :
     is_multiplayer_(false),
     observation_imp_(nullptr),
     query_imp_(nullptr),
-    debug_imp_(nullptr) {
+    debug_imp_(nullptr),
+    step_profiler_(nullptr),
+    step_profiler_client_(0),
+    action_failures_(0) {
 
 #if SC2API_MESSAGE_LOGGING
     response_message_log_ = std::make_unique<sc2::Log>(
@@ -1757,7 +1999,8 @@ bool ControlImp::Step(int count) {
     if (app_state_ != AppState::normal)
         return false;
 
-    GameRequestPtr request = proto_.MakeRequest();
+    StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::Step);
+    GameRequestPtr& request = proto_.ReuseRequest(request_step_);
     SC2APIProtocol::RequestStep* step = request->mutable_step();
     step->set_count(count);
     if (!proto_.SendRequest(request)) {
@@ -1768,7 +2011,11 @@ bool ControlImp::Step(int count) {
 }
 
 bool ControlImp::WaitStep() {
-    GameResponsePtr response = WaitForResponse();
+    GameResponsePtr response;
+    {
+        StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::WaitStep);
+        response = WaitForResponse();
+    }
     if (!response.get() || !response->has_step() || response->error_size() > 0) {
         return false;
     }
@@ -1776,6 +2023,53 @@ bool ControlImp::WaitStep() {
     return GetObservation();
 }
 
+bool ControlImp::RequestStepObservation(int count) {
+    if (app_state_ != AppState::normal)
+        return false;
+
+    StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::Step);
+    step_request_status_ = StepRequestStatus();
+    action_failures_ = proto_.GetDeferredFailures(SC2APIProtocol::Response::kAction);
+
+    GameRequestPtr& request = proto_.ReuseRequest(request_step_);
+    request->mutable_step()->set_count(count);
+    bool sent = proto_.SendRequestDeferred(request, [this](const GameResponsePtr& response) {
+        step_request_status_.step = response.get() && response->has_step() && response->error_size() == 0;
+        if (response.get() && response->error_size() > 0) {
+            std::vector<std::string> errors;
+            for (int i = 0; i < response->error_size(); ++i) {
+                errors.push_back(response->error(i));
+            }
+            Error(ClientError::SC2ProtocolError, errors);
+        }
+    });
+    if (!sent) {
+        step_request_status_.step = false;
+        return false;
+    }
+
+    GameRequestPtr& request_observation = proto_.ReuseRequest(request_observation_);
+    request_observation->mutable_observation();
+    if (!proto_.SendRequest(request_observation)) {
+        step_request_status_.observation = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool ControlImp::WaitStepObservation() {
+    GameResponsePtr response;
+    {
+        StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::WaitStep);
+        response = WaitForResponse();
+    }
+
+    step_request_status_.actions = proto_.GetDeferredFailures(SC2APIProtocol::Response::kAction) == action_failures_;
+    step_request_status_.observation = ReadObservation(response);
+    return step_request_status_.step && step_request_status_.observation;
+}
+
 bool ControlImp::SaveReplay(const std::string& path) {
     GameRequestPtr request = proto_.MakeRequest();
     request->mutable_save_replay();
@@ -1957,13 +2251,22 @@ bool ControlImp::GetObservation() {
     if (app_state_ != AppState::normal)
         return false;
 
-    GameRequestPtr request = proto_.MakeRequest();
-    request->mutable_observation();
-    if (!proto_.SendRequest(request)) {
-        return false;
+    GameResponsePtr response;
+    {
+        StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::GetObservation);
+        GameRequestPtr& request = proto_.ReuseRequest(request_observation_);
+        request->mutable_observation();
+        if (!proto_.SendRequest(request)) {
+            return false;
+        }
+
+        response = WaitForResponse();
     }
 
-    GameResponsePtr response = WaitForResponse();
+    return ReadObservation(response);
+}
+
+bool ControlImp::ReadObservation(const GameResponsePtr& response) {
     ResponseObservationPtr response_observation;
     SET_MESSAGE_RESPONSE(response_observation, response, observation);
     if (response_observation.HasErrors()) {
@@ -1992,7 +2295,10 @@ bool ControlImp::GetObservation() {
     observation_ = observation;
     response_ = response_observation;
 
-    observation_imp_->UpdateObservation();
+    {
+        StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::UpdateObservation);
+        observation_imp_->UpdateObservation();
+    }
 
     return true;
 }
@@ -2035,6 +2341,46 @@ bool ControlImp::ConsumeResponse() {
     return true;
 }
 
+static const ObservationImp::PreviousUnit* FindPreviousUnit(const std::vector<ObservationImp::PreviousUnit>& units, Tag tag) {
+    auto found = std::lower_bound(units.begin(), units.end(), tag, [](const ObservationImp::PreviousUnit& unit, Tag value) {
+        return unit.tag < value;
+    });
+    return found != units.end() && found->tag == tag ? &*found : nullptr;
+}
+
+EventSubscriptions::EventSubscriptions() :
+    unit_destroyed(true),
+    unit_created(true),
+    unit_enter_vision(true),
+    unit_idle(true),
+    building_construction_complete(true),
+    upgrade_completed(true),
+    alerts(true),
+    event_list(false) {
+}
+
+void ControlImp::SetEventSubscriptions(const EventSubscriptions& subscriptions) {
+    event_subscriptions_ = subscriptions;
+    bool track_previous_units = subscriptions.unit_created || subscriptions.unit_enter_vision ||
+        subscriptions.unit_idle || subscriptions.building_construction_complete;
+
+    // Nothing was saved while untracked. Starting from the units there are now, the events only cover what changes
+    // from here, rather than every unit seeming new.
+    if (track_previous_units && !observation_imp_->track_previous_units_) {
+        observation_imp_->SavePreviousUnits();
+    }
+    observation_imp_->track_previous_units_ = track_previous_units;
+    if (!subscriptions.event_list) {
+        events_.clear();
+    }
+}
+
+void ControlImp::AddEvent(ClientEventType type, const Unit* unit, UpgradeID upgrade) {
+    if (event_subscriptions_.event_list) {
+        events_.push_back(ClientEvent{ type, unit, upgrade });
+    }
+}
+
 void ControlImp::IssueUnitDestroyedEvents() {
     if (!observation_->has_raw_data()) {
         return;
@@ -2050,62 +2396,55 @@ void ControlImp::IssueUnitDestroyedEvents() {
                 continue;
             }
 
+            // Dead units leave the pool whether or not the event is wanted.
             observation_imp_->unit_pool_.MarkDead(tag);
-            client_.OnUnitDestroyed(unit);
+            if (event_subscriptions_.unit_destroyed) {
+                AddEvent(ClientEventType::UnitDestroyed, unit);
+                client_.OnUnitDestroyed(unit);
+            }
         }
     }
 }
 
 void ControlImp::IssueUnitAddedEvents() {
+    if (!event_subscriptions_.unit_created && !event_subscriptions_.unit_enter_vision) {
+        return;
+    }
+
+    const std::vector<ObservationImp::PreviousUnit>& previous = observation_imp_->units_previous_;
     observation_imp_->unit_pool_.ForEachExistingUnit([&](sc2::Unit& unit) {
-        auto found = observation_imp_->units_previous_map_.find(unit.tag);
-        if (found != observation_imp_->units_previous_map_.end()) {
+        if (FindPreviousUnit(previous, unit.tag)) {
             return;
         }
 
         if (unit.alliance == Unit::Alliance::Enemy && unit.display_type == Unit::DisplayType::Visible) {
-            client_.OnUnitEnterVision(&unit);
+            if (event_subscriptions_.unit_enter_vision) {
+                AddEvent(ClientEventType::UnitEnterVision, &unit);
+                client_.OnUnitEnterVision(&unit);
+            }
         }
         else if (unit.alliance == Unit::Alliance::Self) {
-            client_.OnUnitCreated(&unit);
+            if (event_subscriptions_.unit_created) {
+                AddEvent(ClientEventType::UnitCreated, &unit);
+                client_.OnUnitCreated(&unit);
+            }
         }
     });
 }
 
-void ControlImp::IssueIdleEvent(const Unit* unit, const std::vector<Tag>& commands) {
+void ControlImp::IssueIdleEvent(const Unit* unit, const std::unordered_set<Tag>& commands) {
     if (!unit || !unit->orders.empty() || unit->build_progress < 1.0f) {
         return;
     }
-    // Lookup unit from previous map.
-    auto found = observation_imp_->units_previous_map_.find(unit->tag);
 
-    // If it's not in the previous map it's a new unit with new orders so trigger the OnIdle event.
-    if (found == observation_imp_->units_previous_map_.end()) {
-        client_.OnUnitIdle(unit);
-        return;
-    }
-
-    // Otherwise get that unit from the previous list and verify it's state changed to idle.
-    const Unit& unit_previous = found->second;
+    const ObservationImp::PreviousUnit* unit_previous = FindPreviousUnit(observation_imp_->units_previous_, unit->tag);
 
-    if (!unit_previous.orders.empty()) {
+    // If it's not in the previous observation it's a new unit with no orders, if it had orders or wasn't finished it
+    // just became idle. If the unit was issued a command but does not currently have orders the order must have
+    // failed. Reissue the OnUnitIdle event in that case.
+    if (!unit_previous || unit_previous->has_orders || !unit_previous->built || commands.count(unit->tag) > 0) {
+        AddEvent(ClientEventType::UnitIdle, unit);
         client_.OnUnitIdle(unit);
-        return;
-    }
-
-    // If the unit had less than 1.0 build progress in the last stop this is the first time it's active.
-    if (unit_previous.build_progress < 1.0f) {
-        client_.OnUnitIdle(unit);
-        return;
-    }
-
-    // Iterate the issued commands, if a unit exists in that list but does not currently have orders
-    // the order must have failed. Reissue the OnUnitIdle event in that case.
-    for (auto t : commands) {
-        if (t == unit->tag) {
-            client_.OnUnitIdle(unit);
-            break;
-        }
     }
 }
 
@@ -2115,14 +2454,9 @@ void ControlImp::IssueBuildingCompletedEvent(const Unit* unit) {
         return;
     }
 
-   auto found = observation_imp_->units_previous_map_.find(unit->tag);
-
-    if (found == observation_imp_->units_previous_map_.end()) {
-        return;
-    }
-
-    const Unit& unit_previous = found->second;
-    if (unit_previous.build_progress < 1.0f) {
+    const ObservationImp::PreviousUnit* unit_previous = FindPreviousUnit(observation_imp_->units_previous_, unit->tag);
+    if (unit_previous && !unit_previous->built) {
+        AddEvent(ClientEventType::BuildingConstructionComplete, unit);
         client_.OnBuildingConstructionComplete(unit);
     }
 }
@@ -2132,10 +2466,12 @@ void ControlImp::IssueAlertEvents() {
     for (const auto alert : observation_->alerts()) {
         switch (alert) {
             case SC2APIProtocol::Alert::NuclearLaunchDetected: {
+                AddEvent(ClientEventType::NuclearLaunchDetected);
                 client_.OnNuclearLaunchDetected();
                 break;
             }
             case SC2APIProtocol::Alert::NydusWormDetected: {
+                AddEvent(ClientEventType::NydusDetected);
                 client_.OnNydusDetected();
                 break;
             }
@@ -2147,13 +2483,11 @@ void ControlImp::IssueAlertEvents() {
 }
 
 void ControlImp::IssueUpgradeEvents() {
-    std::set<uint32_t> previous;
-    for (auto up : observation_imp_->upgrades_previous_) {
-        previous.insert(up);
-    }
-
+    // A player has a few dozen upgrades at most, a scan is cheaper than building a set.
+    const std::vector<UpgradeID>& previous = observation_imp_->upgrades_previous_;
     for (auto up : observation_imp_->upgrades_) {
-        if (previous.find(up) == previous.end()) {
+        if (std::find(previous.begin(), previous.end(), up) == previous.end()) {
+            AddEvent(ClientEventType::UpgradeCompleted, nullptr, up);
             client_.OnUpgradeCompleted(up);
         }
     }
@@ -2164,19 +2498,41 @@ bool ControlImp::IssueEvents(const std::vector<Tag>& commands) {
         return false;
     }
 
-    IssueUnitDestroyedEvents();
-    IssueUnitAddedEvents();
+    {
+        StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::IssueEvents);
+        events_.clear();
+        IssueUnitDestroyedEvents();
+        IssueUnitAddedEvents();
+
+        bool idle = event_subscriptions_.unit_idle;
+        bool building_completed = event_subscriptions_.building_construction_complete;
+        if (idle) {
+            command_tags_.clear();
+            command_tags_.insert(commands.begin(), commands.end());
+        }
+
+        if (idle || building_completed) {
+            Units units = observation_imp_->GetUnits(Unit::Alliance::Self);
+            for (const auto& unit : units) {
+                if (idle) {
+                    IssueIdleEvent(unit, command_tags_);
+                }
+                if (building_completed) {
+                    IssueBuildingCompletedEvent(unit);
+                }
+            }
+        }
 
-    Units units = observation_imp_->GetUnits(Unit::Alliance::Self);
-    for (const auto& unit : units) {
-        IssueIdleEvent(unit, commands);
-        IssueBuildingCompletedEvent(unit);
+        if (event_subscriptions_.upgrade_completed) {
+            IssueUpgradeEvents();
+        }
+        if (event_subscriptions_.alerts) {
+            IssueAlertEvents();
+        }
     }
 
-    IssueUpgradeEvents();
-    IssueAlertEvents();
-
     // Run the users OnStep function after events have been issued.
+    StepProfiler::Scope scope(step_profiler_, step_profiler_client_, StepPhase::OnStep);
     client_.OnStep();
 
     return true;
@@ -2289,9 +2645,23 @@ const ControlInterface* Client::Control() const {
     return control_imp_;
 }
 
+void Client::SetEventSubscriptions(const EventSubscriptions& subscriptions) {
+    control_imp_->SetEventSubscriptions(subscriptions);
+}
+
+const EventSubscriptions& Client::GetEventSubscriptions() const {
+    return control_imp_->event_subscriptions_;
+}
+
+const std::vector<ClientEvent>& Client::GetEvents() const {
+    return control_imp_->events_;
+}
+
 void Client::Reset() {
+    EventSubscriptions subscriptions = control_imp_->event_subscriptions_;
     delete control_imp_;
     control_imp_ = new ControlImp(*this);
+    control_imp_->SetEventSubscriptions(subscriptions);
 }
 
 bool IsCarryingMinerals(const Unit& unit) {
@@ -14,17 +14,12 @@
 
 namespace sc2 {
 
-void StartCivetweb() {
-    static bool is_initialized = false;
+static void StartCivetwebOnce() {
     static const char* REQUEST_TIMEOUT_MS = "5000";
     static const char* WEBSOCKET_TIMEOUT_MS = "1200000";
     static const char* NUM_THREADS = "4";
     static const char* NO_DELAY = "1";
 
-    if (is_initialized) {
-        return;
-    }
-
     const char* options[] = {
         "request_timeout_ms",
         REQUEST_TIMEOUT_MS,
@@ -40,8 +35,12 @@ void StartCivetweb() {
     mg_callbacks callbacks;
     memset(&callbacks, 0, sizeof(callbacks));
     mg_start(&callbacks, nullptr, options);
+}
 
-    is_initialized = true;
+void StartCivetweb() {
+    // Connections may be made from several threads, e.g. by a ProcessPool.
+    static std::once_flag initialized;
+    std::call_once(initialized, StartCivetwebOnce);
 }
 
 bool GetClientData(const mg_connection* connection, sc2::Connection*& out) {
@@ -143,16 +142,16 @@ void Connection::Send(const SC2APIProtocol::Request* request) {
         return;
     }
     size_t size = request->ByteSize();
-    void* buffer = malloc(size);
-    request->SerializeToArray(buffer, (int)size);
+    if (send_buffer_.size() < size) {
+        send_buffer_.resize(size);
+    }
+    request->SerializeToArray(send_buffer_.data(), (int)size);
     mg_websocket_write(
         connection_,
         MG_WEBSOCKET_OPCODE_BINARY,
-        (const char*) buffer,
+        send_buffer_.data(),
         size);
 
-    free(buffer);
-
     if (verbose_) {
         std::cout << "Sending: " << request->DebugString();
     }
@@ -194,6 +193,9 @@ void Connection::PushResponse(SC2APIProtocol::Response*& response) {
     queue_.push_back(response);
     condition_.notify_one();
     has_response_ = true;
+    if (response_callback_) {
+        response_callback_();
+    }
 }
 
 void Connection::PopResponse(SC2APIProtocol::Response*& response) {
@@ -214,6 +216,11 @@ void Connection::SetConnectionClosedCallback(std::function<void()> callback) {
     connection_closed_callback_ = callback;
 }
 
+void Connection::SetResponseCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    response_callback_ = callback;
+}
+
 bool Connection::HasConnection() const {
     return connection_ != nullptr;
 }
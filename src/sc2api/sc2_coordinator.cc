@@ -4,33 +4,32 @@
 #include "sc2api/sc2_args.h"
 #include "sc2api/sc2_interfaces.h"
 #include "sc2api/sc2_control_interfaces.h"
+#include "sc2api/sc2_game_data_cache.h"
+#include "sc2api/sc2_process_pool.h"
+#include "sc2api/sc2_replay_farm.h"
+#include "sc2api/sc2_replay_index.h"
+#include "sc2api/sc2_replay_journal.h"
+#include "sc2api/sc2_step_profiler.h"
 
 #include "sc2utils/sc2_manage_process.h"
 #include "sc2utils/sc2_scan_directory.h"
+#include "sc2utils/sc2_thread_pool.h"
 
 #include "s2clientprotocol/sc2api.pb.h"
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <fstream>
 #include <cassert>
-#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace sc2 {
 
-void RunParallel(const std::function<void(Agent* a)>& step, std::vector<Agent*>& agents) {
-    // Run all steps in parallel.
-    std::vector<std::thread> threads(agents.size());
-    for (size_t i = 0; i < agents.size(); ++i) {
-        Agent* a = agents[i];
-        threads[i] = std::thread(std::bind(step, a));
-    }
-
-    for (auto& t : threads) {
-        t.join();
-    }
-}
-
 int LaunchProcess(ProcessSettings& process_settings, Client* client, int window_width, int window_height, int window_start_x, int window_start_y, int port, int client_num=0) {
     assert(client);
     process_settings.process_info.push_back(sc2::ProcessInfo());
@@ -39,33 +38,7 @@ int LaunchProcess(ProcessSettings& process_settings, Client* client, int window_
     // Get the next port
     pi.port = port;
 
-    // Command line arguments that will be passed to sc2.
-    std::vector<std::string> cl = {
-        "-listen", process_settings.net_address,
-		"-port", std::to_string(pi.port)
-    };
-
-    // DirectX will fail if multiple games try to launch in fullscreen mode. Force them into windowed mode.
-    cl.push_back("-displayMode"); cl.push_back("0");
-
-    if (process_settings.data_version.size() > 0) {
-        cl.push_back("-dataVersion"); cl.push_back(process_settings.data_version);
-    }
-
-    for (const std::string& command : process_settings.extra_command_lines)
-        cl.push_back(command);
-
-    cl.push_back("-windowwidth"); cl.push_back(std::to_string(window_width));
-    cl.push_back("-windowheight"); cl.push_back(std::to_string(window_height));
-
-    if (client_num < 2) {
-        cl.push_back("-windowx"); cl.push_back(std::to_string(window_start_x + window_width * client_num));
-        cl.push_back("-windowy"); cl.push_back(std::to_string(window_start_y));
-    }
-    else if (client_num < 4) {
-        cl.push_back("-windowx"); cl.push_back(std::to_string(window_start_x + window_width * (client_num - 2)));
-        cl.push_back("-windowy"); cl.push_back(std::to_string(window_start_y + window_height));
-    }
+    std::vector<std::string> cl = GetProcessCommandLine(process_settings, pi.port, window_width, window_height, window_start_x, window_start_y, client_num);
 
     pi.process_path = process_settings.process_path;
     pi.process_id = StartProcess(process_settings.process_path, cl);
@@ -82,6 +55,19 @@ int LaunchProcess(ProcessSettings& process_settings, Client* client, int window_
     return pi.port;
 }
 
+bool AcquireProcess(ProcessSettings& process_settings, ProcessPool& process_pool, Client* client) {
+    assert(client);
+    ProcessInfo pi;
+    if (!process_pool.Acquire(pi, process_settings.process_path, process_settings.data_version)) {
+        return false;
+    }
+
+    std::cout << "Took SC2 (" << pi.process_path << ") from the process pool, PID: " << std::to_string(pi.process_id) << std::endl;
+    process_settings.process_info.push_back(pi);
+    client->Control()->SetProcessInfo(pi);
+    return true;
+}
+
 bool AttachClients(ProcessSettings& process_settings, std::vector<Client*> clients) {
     bool connected = false;
 
@@ -140,18 +126,43 @@ public:
     bool JoinGame();
     bool JoinGame(Agent* const agent);
     void StartReplay();
+    void StartFarmReplays();
+    void StartFarmReplay(size_t observer_index);
+    bool LaunchReplayInfoClients();
+    void PrepareReplayList();
+    void OnReplayIgnored(const std::string& replay_path);
+    void OnReplayLoaded(ReplayObserver* r, const std::string& replay_path, bool sent);
+    void OnReplayEnded(ReplayObserver* r, bool finished);
     bool ShouldIgnore(ReplayObserver* r, const std::string& file);
     bool ShouldRelaunch(ReplayObserver* r);
 
+    void RequestSteps();
+    bool IsReadyToUpdate();
+    bool Update();
+    bool AllGamesEnded() const;
+
+    void RequestAgentSteps();
     void StepAgents();
+    bool RequestAgentPipelinedStep(Agent* a);
+    bool SendAgentPipelinedActions(Agent* a);
+    void ObserveAgentPipelined(Agent* a, bool step_requested);
+    void StepAgentsPipelined();
+    void StepAgentsAsync();
     void StepAgentsRealtime();
     void StepReplayObservers();
     void StepReplayObserversRealtime();
 
     bool AnyObserverAvailable() const;
 
+    ThreadPool& GetThreadPool();
+    //! Runs step(0) to step(count - 1) on the worker pool and waits for all of them.
+    void RunParallel(size_t count, const std::function<void(size_t)>& step);
+
     bool WaitForAllResponses();
     void AddAgent(Agent* agent);
+    void AddReplayObserver(ReplayObserver* replay_observer);
+    //! Hands step_profiler_ to the bots and replay observers, numbered as documented in Coordinator::SetStepProfiling.
+    void ApplyStepProfiler();
 
     //! Are we registered to RestartGame ?
     bool IsRegisteredForRestartGame();
@@ -162,6 +173,9 @@ public:
     void RestartGame(Agent* const agent);
 
     bool Relaunch(ReplayObserver* replay_observer);
+    //! Launches a process for each client, or takes them from the process pool, and connects them.
+    //! \return The port of the last process launched, as LaunchProcesses.
+    int LaunchClients(const std::vector<Client*>& clients);
 
     int window_width_ = 1024;
     int window_height_ = 768;
@@ -174,6 +188,58 @@ public:
     int last_port_ = 0;
 
     bool use_generalized_ability_id = true;
+
+    // Persistent workers for parallel stepping, created on first use. 0 threads means one per client.
+    std::unique_ptr<ThreadPool> thread_pool_;
+    size_t worker_threads_ = 0;
+    bool pin_worker_threads_ = false;
+    // Pool owned by the caller, used instead of thread_pool_ when set.
+    ThreadPool* shared_thread_pool_ = nullptr;
+
+    GameDataCache* game_data_cache_ = nullptr;
+    ProcessPool* process_pool_ = nullptr;
+    ReplayIndex* replay_index_ = nullptr;
+    // Set once the replay list has been filtered and ordered, see PrepareReplayList.
+    bool replay_list_prepared_ = false;
+    ReplayJournal* replay_journal_ = nullptr;
+    // Replay each observer is running, by observer index, empty if none.
+    std::vector<std::string> active_replays_;
+
+    mutable std::mutex replay_stats_mutex_;
+    ReplayStats replay_stats_;
+
+    // Set once the step requests of the next update have been sent.
+    bool steps_requested_ = false;
+
+    // Game loops simulated while the agents' OnStep runs, 0 if pipelining is off.
+    int pipeline_action_delay_ = 0;
+
+    // If set each agent is stepped as soon as its own responses arrive, see StepAgentsAsync.
+    bool async_agents_ = false;
+
+    // If set bots don't wait for the responses to their actions, see Coordinator::SetDeferredActionResponses.
+    bool deferred_action_responses_ = false;
+    // If set the step and observation requests are sent together, see Coordinator::SetCombinedStepRequests.
+    bool combined_step_requests_ = false;
+    // Counts agent responses and finished agent updates, so StepAgentsAsync can wait for either.
+    std::mutex async_mutex_;
+    std::condition_variable async_event_;
+    uint64_t async_events_ = 0;
+
+    // Processes gathering replay info ahead of the observers, 0 if the replay farm is off. See StartFarmReplays.
+    size_t replay_info_processes_ = 0;
+    size_t replay_prefetch_depth_ = 2;
+    std::vector<std::unique_ptr<ReplayObserver>> replay_info_clients_;
+    // Declared after the info clients, its threads use them.
+    std::unique_ptr<ReplayFarm> replay_farm_;
+    // Version each observer has to be relaunched into, set by StartFarmReplay and applied by Relaunch.
+    struct FarmRelaunch {
+        std::string process_path;
+        std::string data_version;
+    };
+    std::vector<FarmRelaunch> farm_relaunch_;
+
+    std::unique_ptr<StepProfiler> step_profiler_;
 };
 
 CoordinatorImp::CoordinatorImp() :
@@ -186,6 +252,9 @@ CoordinatorImp::CoordinatorImp() :
 }
 
 CoordinatorImp::~CoordinatorImp() {
+    // Stop gathering replay info before the processes go away.
+    replay_farm_.reset();
+
     for (auto& p : process_settings_.process_info) {
         TerminateProcess(p.process_id);
     }
@@ -198,6 +267,31 @@ bool CoordinatorImp::AnyObserverAvailable() const {
                        });
 }
 
+ThreadPool& CoordinatorImp::GetThreadPool() {
+    if (shared_thread_pool_) {
+        return *shared_thread_pool_;
+    }
+
+    if (!thread_pool_) {
+        // The calling thread runs one of the steps itself.
+        size_t clients = std::max(agents_.size(), replay_observers_.size());
+        size_t threads = worker_threads_ > 0 ? worker_threads_ : std::max<size_t>(clients, 2) - 1;
+        thread_pool_.reset(new ThreadPool(threads, pin_worker_threads_));
+    }
+
+    return *thread_pool_;
+}
+
+void CoordinatorImp::RunParallel(size_t count, const std::function<void(size_t)>& step) {
+    // A single client doesn't need the pool, don't start its threads for it.
+    if (count == 1) {
+        step(0);
+        return;
+    }
+
+    GetThreadPool().ParallelFor(count, step);
+}
+
 bool CoordinatorImp::ShouldIgnore(ReplayObserver* r, const std::string& file) {
     if (file.empty())
         return true;
@@ -229,6 +323,11 @@ bool CoordinatorImp::ShouldRelaunch(ReplayObserver* r) {
 }
 
 void CoordinatorImp::StartReplay() {
+    if (replay_info_processes_ > 0) {
+        StartFarmReplays();
+        return;
+    }
+
     // If no replays given in the settings don't try.
     if (replay_settings_.replay_file.empty()) {
         return;
@@ -236,10 +335,11 @@ void CoordinatorImp::StartReplay() {
 
     assert(!replay_observers_.empty());
     if (!starcraft_started_) {
-        last_port_ = LaunchProcesses(process_settings_,
-            std::vector<sc2::Client*>(replay_observers_.begin(), replay_observers_.end()), window_width_, window_height_, window_start_x_, window_start_y_);
+        last_port_ = LaunchClients(std::vector<sc2::Client*>(replay_observers_.begin(), replay_observers_.end()));
     }
 
+    PrepareReplayList();
+
     // Run a replay with each available replay observer.
     for (auto r : replay_observers_) {
         // If the replay observer is idle or out of game use it for a new replay.
@@ -254,6 +354,7 @@ void CoordinatorImp::StartReplay() {
             const std::string& file = replay_settings_.replay_file.back();
 
             if (ShouldIgnore(r, file)) {
+                OnReplayIgnored(file);
                 replays.pop_back();
                 continue;
             }
@@ -263,6 +364,7 @@ void CoordinatorImp::StartReplay() {
             }
 
             bool launched = r->ReplayControl()->LoadReplay(file, interface_settings_, replay_settings_.player_id, process_settings_.realtime);
+            OnReplayLoaded(r, file, launched);
             replays.pop_back();
             if (launched)
                 break;
@@ -272,7 +374,217 @@ void CoordinatorImp::StartReplay() {
     starcraft_started_ = true;
 }
 
-static void CallOnStep(CoordinatorImp* imp, Agent* a) {
+bool CoordinatorImp::LaunchReplayInfoClients() {
+    if (!replay_info_clients_.empty()) {
+        return true;
+    }
+
+    for (size_t i = 0; i < replay_info_processes_; ++i) {
+        replay_info_clients_.emplace_back(new ReplayObserver());
+        replay_info_clients_.back()->ReplayControl()->SetReplayIndex(replay_index_);
+        if (process_pool_ && AcquireProcess(process_settings_, *process_pool_, replay_info_clients_.back().get())) {
+            continue;
+        }
+
+        last_port_ = LaunchProcess(process_settings_,
+            replay_info_clients_.back().get(),
+            window_width_,
+            window_height_,
+            window_start_x_,
+            window_start_y_,
+            last_port_ + 1
+        );
+    }
+
+    // Since connect is blocking do it after the processes are launched.
+    bool connected = false;
+    for (auto& client : replay_info_clients_) {
+        const ProcessInfo& pi = client->Control()->GetProcessInfo();
+        if (client->Control()->Connect(process_settings_.net_address, pi.port, process_settings_.timeout_ms)) {
+            connected = true;
+        }
+        else {
+            std::cerr << "Replay info client failed to connect, the observers will gather replay info themselves." << std::endl;
+        }
+    }
+
+    return connected;
+}
+
+void CoordinatorImp::StartFarmReplays() {
+    bool farm_has_replays = replay_farm_ && replay_farm_->HasReplays();
+    if (!farm_has_replays && replay_settings_.replay_file.empty()) {
+        return;
+    }
+
+    assert(!replay_observers_.empty());
+    if (!starcraft_started_) {
+        last_port_ = LaunchClients(std::vector<sc2::Client*>(replay_observers_.begin(), replay_observers_.end()));
+    }
+
+    // Hand the replays set since the last farm ran dry to a new one.
+    if (!farm_has_replays) {
+        LaunchReplayInfoClients();
+
+        std::vector<ReplayObserver*> info_clients;
+        for (auto& client : replay_info_clients_) {
+            if (client->Control()->IsReadyForCreateGame()) {
+                info_clients.push_back(client.get());
+            }
+        }
+
+        PrepareReplayList();
+        replay_farm_.reset();
+        replay_farm_.reset(new ReplayFarm(std::move(replay_settings_.replay_file), info_clients, replay_observers_.size(), replay_prefetch_depth_));
+        replay_settings_.replay_file.clear();
+        farm_relaunch_.resize(replay_observers_.size());
+    }
+
+    // Each idle observer takes its next replay on its own, loading one doesn't wait for the others.
+    RunParallel(replay_observers_.size(), [this](size_t i) { StartFarmReplay(i); });
+
+    starcraft_started_ = true;
+}
+
+void CoordinatorImp::StartFarmReplay(size_t observer_index) {
+    ReplayObserver* r = replay_observers_[observer_index];
+    if (!r->Control()->IsReadyForCreateGame()) {
+        return;
+    }
+
+    r->ReplayControl()->UseGeneralizedAbility(use_generalized_ability_id);
+
+    ReplayJob job;
+    while (replay_farm_->Next(observer_index, r->Control()->Proto().GetBaseBuild(), job)) {
+        if (job.has_info) {
+            r->ReplayControl()->SetReplayInfo(job.info);
+        }
+        else if (!r->ReplayControl()->GatherReplayInfo(job.path, true)) {
+            OnReplayIgnored(job.path);
+            continue;
+        }
+
+        // Observers filter in parallel, each gets its own copy of the player to observe.
+        const ReplayInfo& replay_info = r->ReplayControl()->GetReplayInfo();
+        uint32_t player_id = replay_settings_.player_id;
+        if (r->IgnoreReplay(replay_info, player_id)) {
+            OnReplayIgnored(job.path);
+            continue;
+        }
+
+        bool version_match = replay_info.base_build == r->Control()->Proto().GetBaseBuild() &&
+            replay_info.data_version == r->Control()->Proto().GetDataVersion();
+        std::string process_path = process_settings_.process_path;
+        if (!version_match && FindBaseExe(process_path, replay_info.base_build)) {
+            // Relaunch only restarts this observer, keep the replay for it.
+            std::cout << "Replay is from a different version. Relaunching client into the correct version..." << std::endl;
+            farm_relaunch_[observer_index].process_path = process_path;
+            farm_relaunch_[observer_index].data_version = replay_info.data_version;
+            replay_farm_->Retry(observer_index, job);
+            r->Control()->Error(ClientError::WrongGameVersion);
+            return;
+        }
+
+        bool launched = r->ReplayControl()->LoadReplay(job.path, interface_settings_, player_id, process_settings_.realtime);
+        OnReplayLoaded(r, job.path, launched);
+        if (launched) {
+            return;
+        }
+    }
+}
+
+void CoordinatorImp::PrepareReplayList() {
+    if (replay_list_prepared_) {
+        return;
+    }
+    replay_list_prepared_ = true;
+
+    // Skip what an earlier run finished or gave up on.
+    if (replay_journal_) {
+        replay_settings_.replay_file = replay_journal_->GetPending(replay_settings_.replay_file);
+    }
+
+    if (!replay_index_) {
+        return;
+    }
+
+    // Replays are taken from the back: first the build the observers run, then one build after the other, so each
+    // observer is only relaunched when a build runs out. Replays that aren't indexed go last.
+    std::vector<std::string>& replays = replay_settings_.replay_file;
+    std::vector<std::string> unindexed;
+    std::map<uint32_t, std::vector<std::string>> groups = replay_index_->GroupByBaseBuild(replays, &unindexed);
+    uint32_t running_build = replay_observers_.empty() ? 0 : replay_observers_.front()->Control()->Proto().GetBaseBuild();
+
+    replays = std::move(unindexed);
+    for (const auto& group : groups) {
+        if (group.first != running_build) {
+            replays.insert(replays.end(), group.second.begin(), group.second.end());
+        }
+    }
+
+    auto running = groups.find(running_build);
+    if (running != groups.end()) {
+        replays.insert(replays.end(), running->second.begin(), running->second.end());
+    }
+}
+
+void CoordinatorImp::OnReplayIgnored(const std::string& replay_path) {
+    if (replay_journal_) {
+        replay_journal_->RecordIgnored(replay_path);
+    }
+
+    std::lock_guard<std::mutex> lock(replay_stats_mutex_);
+    ++replay_stats_.replays_ignored;
+}
+
+void CoordinatorImp::OnReplayLoaded(ReplayObserver* r, const std::string& replay_path, bool sent) {
+    if (!sent) {
+        if (replay_journal_) {
+            replay_journal_->RecordFailed(replay_path);
+        }
+        return;
+    }
+
+    if (replay_journal_) {
+        replay_journal_->RecordStarted(replay_path);
+    }
+
+    // Each observer only touches its own entry, so this is safe while observers run in parallel.
+    for (size_t i = 0; i < replay_observers_.size(); ++i) {
+        if (replay_observers_[i] == r) {
+            active_replays_[i] = replay_path;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(replay_stats_mutex_);
+    ++replay_stats_.replays_loaded;
+}
+
+void CoordinatorImp::OnReplayEnded(ReplayObserver* r, bool finished) {
+    for (size_t i = 0; i < replay_observers_.size(); ++i) {
+        if (replay_observers_[i] != r || active_replays_[i].empty()) {
+            continue;
+        }
+
+        // A replay that ends because SC2 crashed or timed out didn't finish.
+        finished = finished && r->Control()->GetAppState() == AppState::normal && r->Control()->GetClientErrors().empty();
+        if (replay_journal_) {
+            if (finished) {
+                replay_journal_->RecordFinished(active_replays_[i]);
+            }
+            else {
+                replay_journal_->RecordFailed(active_replays_[i]);
+            }
+        }
+        active_replays_[i].clear();
+    }
+}
+
+// How long StepAgentsAsync waits for a response before polling the agents again.
+static const int AsyncWaitSliceMs = 10;
+
+// In pipelined stepping the actions are sent in the next update, after the step in flight has finished.
+static void CallOnStep(CoordinatorImp* imp, Agent* a, bool send_actions = true) {
     ControlInterface* control = a->Control();
     if (!control->IsInGame()) {
         a->OnGameEnd();
@@ -304,6 +616,10 @@ static void CallOnStep(CoordinatorImp* imp, Agent* a) {
 
     ActionInterface* action = a->Actions();
     control->IssueEvents(action->Commands());
+    if (!send_actions) {
+        return;
+    }
+
     if (action) {
         action->SendActions();
     }
@@ -314,24 +630,97 @@ static void CallOnStep(CoordinatorImp* imp, Agent* a) {
     }
 }
 
-void CoordinatorImp::StepAgents() {
-    auto step_agent = [this](Agent* a) {
+static void SendAgentActions(Agent* a) {
+    if (a->Actions()) {
+        a->Actions()->SendActions();
+    }
+
+    if (a->ActionsFeatureLayer()) {
+        a->ActionsFeatureLayer()->SendActions();
+    }
+}
+
+void CoordinatorImp::RequestSteps() {
+    if (steps_requested_) {
+        return;
+    }
+
+    // Pipelined and asynchronous agents already have their step in flight.
+    if (agents_.size() > 0 && !process_settings_.realtime && pipeline_action_delay_ == 0 && !async_agents_) {
+        RequestAgentSteps();
+    }
+    steps_requested_ = true;
+}
+
+bool CoordinatorImp::IsReadyToUpdate() {
+    // Agents step together, so wait for all of them.
+    for (auto a : agents_) {
+        ControlInterface* control = a->Control();
+        if (control->GetAppState() == AppState::normal && control->HasResponsePending() && !control->PollResponse()) {
+            return false;
+        }
+    }
+
+    if (replay_observers_.empty() || !starcraft_started_) {
+        return true;
+    }
+
+    // Replay observers step independently and skip the ones that are still loading, so one is enough. Observers in an
+    // error state count as ready so Update can relaunch them.
+    for (auto r : replay_observers_) {
+        ControlInterface* control = r->Control();
+        if (control->GetAppState() != AppState::normal || !control->HasResponsePending() || control->PollResponse()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CoordinatorImp::RequestAgentSteps() {
+    for (auto a : agents_) {
         ControlInterface* control = a->Control();
 
         if (control->GetAppState() != AppState::normal) {
-            return;
+            continue;
         }
 
         if (control->PollLeaveGame()) {
-            return;
+            continue;
         }
 
         if (control->IsFinishedGame()) {
-            return;
+            continue;
         }
 
-        control->Step(process_settings_.step_size);
-        control->WaitStep();
+        if (combined_step_requests_) {
+            control->RequestStepObservation(process_settings_.step_size);
+        }
+        else {
+            control->Step(process_settings_.step_size);
+        }
+    }
+}
+
+void CoordinatorImp::StepAgents() {
+    // The step requests were all sent by RequestAgentSteps, so the games simulate while we wait on the first one.
+    auto step_agent = [this](Agent* a) {
+        ControlInterface* control = a->Control();
+
+        if (combined_step_requests_) {
+            if (control->Proto().GetResponsePending() != SC2APIProtocol::Response::kObservation) {
+                return;
+            }
+
+            control->WaitStepObservation();
+        }
+        else {
+            if (control->Proto().GetResponsePending() != SC2APIProtocol::Response::kStep) {
+                return;
+            }
+
+            control->WaitStep();
+        }
 
         if (process_settings_.multi_threaded) {
             CallOnStep(this, a);
@@ -342,7 +731,7 @@ void CoordinatorImp::StepAgents() {
         step_agent(agents_.front());
     }
     else {
-        RunParallel(step_agent, agents_);
+        RunParallel(agents_.size(), [this, &step_agent](size_t i) { step_agent(agents_[i]); });
     }
 
     if (!process_settings_.multi_threaded) {
@@ -362,6 +751,274 @@ void CoordinatorImp::StepAgents() {
 
 }
 
+// Pipelined stepping is split in phases so that no agent waits on a step the other agents haven't requested yet. A
+// multiplayer step only finishes once every player requested it, so an agent waiting inside a phase would need the
+// other agents' tasks to run at the same time, which a pool with fewer workers than agents can't promise.
+
+// Returns false if the agent isn't stepped this update.
+bool CoordinatorImp::RequestAgentPipelinedStep(Agent* a) {
+    const int action_delay = std::min(pipeline_action_delay_, process_settings_.step_size);
+    ControlInterface* control = a->Control();
+    if (control->GetAppState() != AppState::normal) {
+        return false;
+    }
+
+    // Without a step in flight this is the first update of a game, or the game ended and may be leaving.
+    if (control->Proto().GetResponsePending() != SC2APIProtocol::Response::kStep) {
+        if (control->PollLeaveGame() || control->IsFinishedGame()) {
+            return false;
+        }
+
+        control->Step(action_delay);
+    }
+
+    return true;
+}
+
+// Returns true if the rest of the step was requested.
+bool CoordinatorImp::SendAgentPipelinedActions(Agent* a) {
+    const int action_delay = std::min(pipeline_action_delay_, process_settings_.step_size);
+    ControlInterface* control = a->Control();
+
+    // The game is now action_delay game loops past the observation the actions were chosen from.
+    control->WaitForResponse();
+    if (!control->IsInGame()) {
+        return false;
+    }
+
+    SendAgentActions(a);
+    if (process_settings_.step_size <= action_delay) {
+        return false;
+    }
+
+    control->Step(process_settings_.step_size - action_delay);
+    return true;
+}
+
+void CoordinatorImp::ObserveAgentPipelined(Agent* a, bool step_requested) {
+    const int action_delay = std::min(pipeline_action_delay_, process_settings_.step_size);
+    ControlInterface* control = a->Control();
+    if (step_requested) {
+        control->WaitForResponse();
+    }
+
+    control->GetObservation();
+    if (control->IsInGame()) {
+        control->Proto().SetAllowRequestsDuringStep(true);
+        control->Step(action_delay);
+    }
+}
+
+void CoordinatorImp::StepAgentsPipelined() {
+    std::vector<Agent*> stepping;
+    for (auto a : agents_) {
+        if (RequestAgentPipelinedStep(a)) {
+            stepping.push_back(a);
+        }
+    }
+
+    // Every agent has a step in flight, so each can wait for its own.
+    std::vector<char> step_requested(stepping.size(), 0);
+    RunParallel(stepping.size(), [this, &stepping, &step_requested](size_t i) {
+        step_requested[i] = SendAgentPipelinedActions(stepping[i]) ? 1 : 0;
+    });
+
+    RunParallel(stepping.size(), [this, &stepping, &step_requested](size_t i) {
+        ObserveAgentPipelined(stepping[i], step_requested[i] != 0);
+        if (process_settings_.multi_threaded) {
+            CallOnStep(this, stepping[i], false);
+        }
+    });
+
+    if (!process_settings_.multi_threaded) {
+        for (auto a : agents_) {
+            ControlInterface* control = a->Control();
+            if (control->GetAppState() != AppState::normal) {
+                continue;
+            }
+
+            // A leave game request is only possible once the game has ended, i.e. without a step in flight.
+            if (control->Proto().GetResponsePending() != SC2APIProtocol::Response::kStep && control->PollLeaveGame()) {
+                continue;
+            }
+
+            CallOnStep(this, a, false);
+        }
+    }
+}
+
+void CoordinatorImp::StepAgentsAsync() {
+    // Each agent runs its own loop: wait for its step, observe, call OnStep, send its actions and request its next
+    // step right away. Agents are picked up in the order their responses arrive rather than in a fixed order, and the
+    // only thing that keeps them in lockstep is SC2 itself, a multiplayer step finishes once every player requested it.
+    const bool pipelined = pipeline_action_delay_ > 0;
+    const int first_step = pipelined ? std::min(pipeline_action_delay_, process_settings_.step_size) : process_settings_.step_size;
+
+    auto notify = [this]() {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        ++async_events_;
+        async_event_.notify_all();
+    };
+
+    std::vector<Agent*> waiting;
+    for (auto a : agents_) {
+        ControlInterface* control = a->Control();
+        if (control->GetAppState() != AppState::normal) {
+            continue;
+        }
+
+        // Without a step in flight this is the first update of a game, or the game ended and may be leaving. All
+        // first steps are sent before any agent waits, a multiplayer step can't finish before the others are sent.
+        if (control->Proto().GetResponsePending() != SC2APIProtocol::Response::kStep) {
+            if (control->PollLeaveGame() || control->IsFinishedGame()) {
+                continue;
+            }
+
+            control->Step(first_step);
+        }
+
+        waiting.push_back(a);
+    }
+
+    // A pipelined step takes two responses, so an agent whose delayed step arrived sends its actions, requests the rest
+    // of the step and goes back to waiting. Tasks only start once their agent's response is in, so none of them waits
+    // on another agent's step and any pool size works. Each agent is in one task at a time, and the map is filled
+    // before any task runs, so the tasks can update their own agent's entry.
+    std::unordered_map<Agent*, bool> rest_requested;
+    for (auto a : waiting) {
+        rest_requested[a] = false;
+    }
+
+    // Returns false if the agent waits for another response before its OnStep.
+    auto exchange = [this, pipelined, &rest_requested](Agent* a) {
+        if (!pipelined) {
+            a->Control()->WaitStep();
+            return true;
+        }
+
+        bool& rest = rest_requested.at(a);
+        if (!rest && SendAgentPipelinedActions(a)) {
+            rest = true;
+            return false;
+        }
+
+        ObserveAgentPipelined(a, rest);
+        rest = false;
+        return true;
+    };
+    // OnStep only runs on the pool if multithreaded, otherwise it runs on this thread.
+    auto on_step = [this, pipelined](Agent* a) {
+        if (pipelined) {
+            CallOnStep(this, a, false);
+            return;
+        }
+
+        CallOnStep(this, a);
+        ControlInterface* control = a->Control();
+        if (control->IsInGame()) {
+            control->Proto().SetAllowRequestsDuringStep(true);
+            control->Step(process_settings_.step_size);
+        }
+    };
+
+    if (waiting.size() <= 1) {
+        if (!waiting.empty()) {
+            while (!exchange(waiting.front())) {
+            }
+            on_step(waiting.front());
+        }
+        return;
+    }
+
+    // Responses that arrive before this are found by polling.
+    const std::vector<Agent*> waiting_agents = waiting;
+    for (auto a : waiting_agents) {
+        a->Control()->Proto().SetResponseCallback(notify);
+    }
+
+    // Waiting here only ever runs this game's own agents, never other work queued on a shared pool.
+    TaskGroup tasks(GetThreadPool());
+    const bool multi_threaded = process_settings_.multi_threaded;
+    size_t running = 0;
+    std::vector<Agent*> ready_for_on_step;
+    std::vector<Agent*> waiting_again;
+    int waited_ms = 0;
+    for (;;) {
+        uint64_t events = 0;
+        std::vector<Agent*> on_step_agents;
+        {
+            std::lock_guard<std::mutex> lock(async_mutex_);
+            events = async_events_;
+            on_step_agents.swap(ready_for_on_step);
+            waiting.insert(waiting.end(), waiting_again.begin(), waiting_again.end());
+            waiting_again.clear();
+        }
+
+        for (Agent* a : on_step_agents) {
+            on_step(a);
+        }
+
+        // If nothing arrived within the timeout let the agents' own waits deal with it, they detect crashed and
+        // unresponsive games.
+        bool timed_out = waited_ms >= process_settings_.timeout_ms;
+        bool dispatched = !on_step_agents.empty();
+        for (size_t i = 0; i < waiting.size();) {
+            Agent* a = waiting[i];
+            if (!timed_out && a->Control()->HasResponsePending() && !a->Control()->PollResponse()) {
+                ++i;
+                continue;
+            }
+
+            waiting.erase(waiting.begin() + i);
+            dispatched = true;
+            {
+                std::lock_guard<std::mutex> lock(async_mutex_);
+                ++running;
+            }
+            tasks.Run([this, a, multi_threaded, &exchange, &on_step, &running, &ready_for_on_step, &waiting_again]() {
+                bool stepped = exchange(a);
+                if (stepped && multi_threaded) {
+                    on_step(a);
+                }
+
+                std::lock_guard<std::mutex> lock(async_mutex_);
+                if (!stepped) {
+                    waiting_again.push_back(a);
+                }
+                else if (!multi_threaded) {
+                    ready_for_on_step.push_back(a);
+                }
+                --running;
+                ++async_events_;
+                async_event_.notify_all();
+            });
+        }
+
+        if (dispatched) {
+            waited_ms = 0;
+            continue;
+        }
+
+        if (tasks.RunPendingTask()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(async_mutex_);
+        if (waiting.empty() && running == 0 && ready_for_on_step.empty() && waiting_again.empty()) {
+            break;
+        }
+        if (async_events_ == events) {
+            async_event_.wait_for(lock, std::chrono::milliseconds(AsyncWaitSliceMs));
+            waited_ms += AsyncWaitSliceMs;
+        }
+    }
+
+    // The agents may outlive the coordinator.
+    for (auto a : waiting_agents) {
+        a->Control()->Proto().SetResponseCallback(nullptr);
+    }
+}
+
 void CoordinatorImp::StepAgentsRealtime() {
     auto step_agent = [this](Agent* a) {
         ControlInterface* control = a->Control();
@@ -421,7 +1078,7 @@ void CoordinatorImp::StepAgentsRealtime() {
     };
 
     if (process_settings_.multi_threaded) {
-        RunParallel(step_agent, agents_);
+        RunParallel(agents_.size(), [this, &step_agent](size_t i) { step_agent(agents_[i]); });
     }
     else {
         for (auto a : agents_) {
@@ -443,12 +1100,20 @@ void CoordinatorImp::StepReplayObservers() {
             if (replay_observers_.size() > 1 && !r->Control()->PollResponse()) {
                 return;
             }
-            r->ReplayControl()->WaitForReplay();
+            if (!r->ReplayControl()->WaitForReplay()) {
+                OnReplayEnded(r, false);
+            }
         }
 
         if (r->Control()->IsInGame()) {
-            r->Control()->Step(process_settings_.step_size);
-            r->Control()->WaitStep();
+            if (combined_step_requests_) {
+                r->Control()->RequestStepObservation(process_settings_.step_size);
+                r->Control()->WaitStepObservation();
+            }
+            else {
+                r->Control()->Step(process_settings_.step_size);
+                r->Control()->WaitStep();
+            }
 
             // If multithreaded run everyones OnStep in parallel.
             if (process_settings_.multi_threaded) {
@@ -457,6 +1122,7 @@ void CoordinatorImp::StepReplayObservers() {
             }
 
             if (!r->Control()->IsInGame()) {
+                OnReplayEnded(r, true);
                 r->OnGameEnd();
             }
         }
@@ -467,16 +1133,7 @@ void CoordinatorImp::StepReplayObservers() {
     }
     else {
         // Run all steps in parallel.
-        std::vector<std::thread> threads;
-        threads.reserve(replay_observers_.size());
-        for (auto r : replay_observers_) {
-            threads.emplace_back(run_replay, r);
-        }
-
-        // Join all threads.
-        for (auto& t : threads) {
-            t.join();
-        }
+        RunParallel(replay_observers_.size(), [this, &run_replay](size_t i) { run_replay(replay_observers_[i]); });
     }
 
     // Do everyones OnStep, if not multi threaded, in single threaded mode.
@@ -506,7 +1163,9 @@ void CoordinatorImp::StepReplayObserversRealtime() {
             if (replay_observers_.size() > 1 && !r->Control()->PollResponse()) {
                 return;
             }
-            r->ReplayControl()->WaitForReplay();
+            if (!r->ReplayControl()->WaitForReplay()) {
+                OnReplayEnded(r, false);
+            }
         }
 
         if (r->Control()->IsInGame()) {
@@ -518,6 +1177,7 @@ void CoordinatorImp::StepReplayObserversRealtime() {
             }
 
             if (!r->Control()->IsInGame()) {
+                OnReplayEnded(r, true);
                 r->OnGameEnd();
             }
         }
@@ -528,16 +1188,7 @@ void CoordinatorImp::StepReplayObserversRealtime() {
     }
     else {
         // Run all steps in parallel.
-        std::vector<std::thread> threads;
-        threads.reserve(replay_observers_.size());
-        for (auto r : replay_observers_) {
-            threads.emplace_back(run_replay, r);
-        }
-
-        // Join all threads.
-        for (auto& t : threads) {
-            t.join();
-        }
+        RunParallel(replay_observers_.size(), [this, &run_replay](size_t i) { run_replay(replay_observers_[i]); });
     }
 
     // Do everyones OnStep, if not multi threaded, in single threaded mode.
@@ -728,9 +1379,14 @@ bool CoordinatorImp::StartGame() {
 }
 
 bool CoordinatorImp::Relaunch(ReplayObserver* replay_observer) {
+    auto start_time = std::chrono::steady_clock::now();
     ControlInterface* control = replay_observer->Control();
     const ProcessInfo& pi = control->GetProcessInfo();
 
+    const std::vector<ClientError>& errors = control->GetClientErrors();
+    bool wrong_version = std::find(errors.begin(), errors.end(), ClientError::WrongGameVersion) != errors.end();
+    int profiler_client = control->GetStepProfilerClient();
+
     // Try to kill SC2 then relaunch it
     sc2::TerminateProcess(pi.process_id);
 
@@ -742,19 +1398,62 @@ bool CoordinatorImp::Relaunch(ReplayObserver* replay_observer) {
 
     // Control interface has been reconstructed.
     control = replay_observer->Control();
+    control->SetGameDataCache(game_data_cache_);
+    control->SetStepProfiler(step_profiler_.get(), profiler_client);
+
+    // Switch to the version the replay farm asked for.
+    for (size_t i = 0; i < farm_relaunch_.size() && i < replay_observers_.size(); ++i) {
+        if (replay_observers_[i] == replay_observer && !farm_relaunch_[i].process_path.empty()) {
+            process_settings_.process_path = farm_relaunch_[i].process_path;
+            process_settings_.data_version = farm_relaunch_[i].data_version;
+            farm_relaunch_[i] = FarmRelaunch();
+        }
+    }
 
-    last_port_ = LaunchProcess(process_settings_,
-        replay_observer,
-        window_width_,
-        window_height_,
-        window_start_x_,
-        window_start_y_,
-        last_port_ + 1
-    );
+    // A process from the pool is already up, which is most of the time a relaunch takes.
+    if (!process_pool_ || !AcquireProcess(process_settings_, *process_pool_, replay_observer)) {
+        last_port_ = LaunchProcess(process_settings_,
+            replay_observer,
+            window_width_,
+            window_height_,
+            window_start_x_,
+            window_start_y_,
+            last_port_ + 1
+        );
+    }
 
     const ProcessInfo& pi_new = control->GetProcessInfo();
 
-    return control->Connect(process_settings_.net_address, pi_new.port, process_settings_.timeout_ms);
+    bool connected = control->Connect(process_settings_.net_address, pi_new.port, process_settings_.timeout_ms);
+
+    std::lock_guard<std::mutex> lock(replay_stats_mutex_);
+    ++replay_stats_.relaunches;
+    if (wrong_version) {
+        ++replay_stats_.version_relaunches;
+    }
+    replay_stats_.relaunch_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    return connected;
+}
+
+int CoordinatorImp::LaunchClients(const std::vector<Client*>& clients) {
+    if (!process_pool_) {
+        return LaunchProcesses(process_settings_, clients, window_width_, window_height_, window_start_x_, window_start_y_);
+    }
+
+    int client_num = 0;
+    for (Client* c : clients) {
+        if (!AcquireProcess(process_settings_, *process_pool_, c)) {
+            LaunchProcess(process_settings_, c, window_width_, window_height_, window_start_x_, window_start_y_,
+                process_settings_.port_start + static_cast<int>(process_settings_.process_info.size()) - 1, client_num);
+        }
+        ++client_num;
+    }
+
+    AttachClients(process_settings_, clients);
+
+    // Pool processes listen on the pool's ports, leave the coordinator's range as if they had been launched here.
+    return process_settings_.port_start + static_cast<int>(clients.size()) - 1;
 }
 
 // Coordinator.
@@ -841,8 +1540,7 @@ void Coordinator::LaunchStarcraft() {
     // The process may have died.
     int port_start = 0;
     if (imp_->process_settings_.process_info.size() != imp_->agents_.size()) {
-        port_start = LaunchProcesses(imp_->process_settings_,
-            std::vector<sc2::Client*>(imp_->agents_.begin(), imp_->agents_.end()), imp_->window_width_, imp_->window_height_, imp_->window_start_x_, imp_->window_start_y_);
+        port_start = imp_->LaunchClients(std::vector<sc2::Client*>(imp_->agents_.begin(), imp_->agents_.end()));
     }
 
     SetupPorts( imp_->agents_.size(), port_start);
@@ -890,27 +1588,49 @@ void Coordinator::WaitForAllResponses() {
 }
 
 bool Coordinator::Update() {
-    if (imp_->agents_.size() > 0) {
-        if (imp_->process_settings_.realtime) {
-            imp_->StepAgentsRealtime();
+    StepProfiler::Scope scope(imp_->step_profiler_.get(), StepProfiler::CoordinatorClient, StepPhase::Update);
+    return imp_->Update();
+}
+
+void Coordinator::RequestSteps() {
+    imp_->RequestSteps();
+}
+
+bool Coordinator::IsReadyToUpdate() {
+    return imp_->IsReadyToUpdate();
+}
+
+bool CoordinatorImp::Update() {
+    RequestSteps();
+    steps_requested_ = false;
+
+    if (agents_.size() > 0) {
+        if (process_settings_.realtime) {
+            StepAgentsRealtime();
+        }
+        else if (async_agents_) {
+            StepAgentsAsync();
+        }
+        else if (pipeline_action_delay_ > 0) {
+            StepAgentsPipelined();
         }
         else {
-            imp_->StepAgents();
+            StepAgents();
         }
     }
 
-    if (imp_->replay_observers_.size() > 0 && imp_->starcraft_started_) {
-        if (imp_->process_settings_.realtime) {
-            imp_->StepReplayObserversRealtime();
+    if (replay_observers_.size() > 0 && starcraft_started_) {
+        if (process_settings_.realtime) {
+            StepReplayObserversRealtime();
         }
         else {
-            imp_->StepReplayObservers();
+            StepReplayObservers();
         }
     }
 
     // check agents for needing to RestartGame
-    if (!imp_->process_settings_.multi_threaded && imp_->IsRegisteredForRestartGame()) {
-        for (auto agent : imp_->agents_) {
+    if (!process_settings_.multi_threaded && IsRegisteredForRestartGame()) {
+        for (auto agent : agents_) {
             if (agent->Control()->IsInGame()) {
                 continue;
             }
@@ -922,26 +1642,26 @@ bool Coordinator::Update() {
             }
 
             if (!agentControl->HasRestartGameOccurred()) {
-                if (!imp_->process_settings_.realtime) {
+                if (!process_settings_.realtime) {
                     // need to send RequestRestartGame simultaneous to the clients in non-realtime mode
-                    imp_->RestartGame();
+                    RestartGame();
                     break;
                 }
 
-                imp_->RestartGame(agent);
+                RestartGame(agent);
             }
         }
     }
 
-    if (imp_->replay_observers_.size() > 0) {
-        if (imp_->AnyObserverAvailable()) {
-            imp_->StartReplay();
+    if (replay_observers_.size() > 0) {
+        if (AnyObserverAvailable()) {
+            StartReplay();
         }
     }
 
     // Check for errors in all agents/replay observers at the end of an update.
     bool error_occurred = false;
-    for (auto agent : imp_->agents_) {
+    for (auto agent : agents_) {
         const ControlInterface* control = agent->Control();
         const std::vector<ClientError>& client_errors = control->GetClientErrors();
         if (!client_errors.empty()) {
@@ -951,15 +1671,16 @@ bool Coordinator::Update() {
     }
 
     bool relaunched = false;
-    for (auto replay_observer : imp_->replay_observers_) {
+    for (auto replay_observer : replay_observers_) {
         ControlInterface* control = replay_observer->Control();
         const std::vector<ClientError>& client_errors = control->GetClientErrors();
         if (!client_errors.empty()) {
+            OnReplayEnded(replay_observer, false);
             replay_observer->OnError(client_errors, control->GetProtocolErrors());
             error_occurred = true;
-            if (imp_->replay_recovery_) {
+            if (replay_recovery_) {
                 // An error did occur but if we succesfully recovered ignore it. The client will still gets its event
-                bool connected = imp_->Relaunch(replay_observer);
+                bool connected = Relaunch(replay_observer);
                 if (connected) {
                     error_occurred = false;
                     relaunched = true;
@@ -1011,13 +1732,17 @@ bool Coordinator::SendMapCommand(const std::string& commandId) {
 }
 
 bool Coordinator::AllGamesEnded() const {
-    for (auto a : imp_->agents_) {
+    return imp_->AllGamesEnded();
+}
+
+bool CoordinatorImp::AllGamesEnded() const {
+    for (auto a : agents_) {
         if (a->Control()->IsInGame() || a->Control()->HasResponsePending()) {
             return false;
         }
     }
 
-    for (auto r : imp_->replay_observers_) {
+    for (auto r : replay_observers_) {
         if (r->Control()->IsInGame() || r->Control()->HasResponsePending()) {
             return false;
         }
@@ -1029,6 +1754,44 @@ bool Coordinator::AllGamesEnded() const {
 void CoordinatorImp::AddAgent(Agent* agent) {
     assert(agent);
     agents_.push_back(agent);
+    if (game_data_cache_) {
+        agent->Control()->SetGameDataCache(game_data_cache_);
+    }
+    agent->Actions()->SetDeferredResponses(deferred_action_responses_ || combined_step_requests_);
+    agent->ActionsFeatureLayer()->SetDeferredResponses(deferred_action_responses_ || combined_step_requests_);
+    ApplyStepProfiler();
+}
+
+void CoordinatorImp::AddReplayObserver(ReplayObserver* replay_observer) {
+    assert(replay_observer);
+    replay_observers_.push_back(replay_observer);
+    active_replays_.push_back(std::string());
+    if (game_data_cache_) {
+        replay_observer->Control()->SetGameDataCache(game_data_cache_);
+    }
+    replay_observer->ReplayControl()->SetReplayIndex(replay_index_);
+    ApplyStepProfiler();
+}
+
+void CoordinatorImp::ApplyStepProfiler() {
+    StepProfiler* profiler = step_profiler_.get();
+    if (profiler) {
+        profiler->SetClientName(StepProfiler::CoordinatorClient, "Coordinator");
+    }
+
+    int client_id = StepProfiler::CoordinatorClient;
+    for (size_t i = 0; i < agents_.size(); ++i) {
+        agents_[i]->Control()->SetStepProfiler(profiler, ++client_id);
+        if (profiler) {
+            profiler->SetClientName(client_id, "Agent " + std::to_string(i));
+        }
+    }
+    for (size_t i = 0; i < replay_observers_.size(); ++i) {
+        replay_observers_[i]->Control()->SetStepProfiler(profiler, ++client_id);
+        if (profiler) {
+            profiler->SetClientName(client_id, "ReplayObserver " + std::to_string(i));
+        }
+    }
 }
 
 bool CoordinatorImp::IsRegisteredForRestartGame() {
@@ -1093,14 +1856,74 @@ void CoordinatorImp::RestartGame(Agent* const agent) {
 }
 
 void Coordinator::AddReplayObserver(ReplayObserver* replay_observer) {
-    assert(replay_observer);
-    imp_->replay_observers_.push_back(replay_observer);
+    imp_->AddReplayObserver(replay_observer);
 }
 
 void Coordinator::SetMultithreaded(bool value) {
     imp_->process_settings_.multi_threaded = value;
 }
 
+void Coordinator::SetWorkerThreads(size_t thread_count, bool pin_threads) {
+    imp_->worker_threads_ = thread_count;
+    imp_->pin_worker_threads_ = pin_threads;
+    imp_->thread_pool_.reset();
+}
+
+void Coordinator::SetThreadPool(ThreadPool* thread_pool) {
+    imp_->shared_thread_pool_ = thread_pool;
+}
+
+void Coordinator::SetProcessPool(ProcessPool* process_pool) {
+    imp_->process_pool_ = process_pool;
+}
+
+void Coordinator::SetStepProfiling(bool value, bool trace) {
+    if (!value) {
+        imp_->step_profiler_.reset();
+    }
+    else if (!imp_->step_profiler_) {
+        imp_->step_profiler_ = std::make_unique<StepProfiler>();
+    }
+
+    if (imp_->step_profiler_) {
+        imp_->step_profiler_->SetTracing(trace);
+    }
+    imp_->ApplyStepProfiler();
+}
+
+StepProfiler* Coordinator::GetStepProfiler() const {
+    return imp_->step_profiler_.get();
+}
+
+void Coordinator::SetGameDataCache(GameDataCache* cache) {
+    imp_->game_data_cache_ = cache;
+    for (auto a : imp_->agents_) {
+        a->Control()->SetGameDataCache(cache);
+    }
+    for (auto r : imp_->replay_observers_) {
+        r->Control()->SetGameDataCache(cache);
+    }
+}
+
+void Coordinator::SetReplayIndex(ReplayIndex* replay_index) {
+    imp_->replay_index_ = replay_index;
+    for (auto r : imp_->replay_observers_) {
+        r->ReplayControl()->SetReplayIndex(replay_index);
+    }
+    for (auto& r : imp_->replay_info_clients_) {
+        r->ReplayControl()->SetReplayIndex(replay_index);
+    }
+}
+
+void Coordinator::SetReplayJournal(ReplayJournal* replay_journal) {
+    imp_->replay_journal_ = replay_journal;
+}
+
+ReplayStats Coordinator::GetReplayStats() const {
+    std::lock_guard<std::mutex> lock(imp_->replay_stats_mutex_);
+    return imp_->replay_stats_;
+}
+
 void Coordinator::SetRealtime(bool value) {
     // Realtime must be set before LaunchStarcraft is called.
     assert(!imp_->starcraft_started_);
@@ -1132,6 +1955,38 @@ void Coordinator::SetTimeoutMS(uint32_t timeout_ms) {
     imp_->process_settings_.timeout_ms = timeout_ms;
 }
 
+void Coordinator::SetStepPipelining(int action_delay) {
+    // Pipelining must be set before LaunchStarcraft is called.
+    assert(!imp_->starcraft_started_);
+    imp_->pipeline_action_delay_ = std::max(action_delay, 0);
+}
+
+void Coordinator::SetAsyncAgents(bool value) {
+    // Asynchronous stepping must be set before LaunchStarcraft is called.
+    assert(!imp_->starcraft_started_);
+    imp_->async_agents_ = value;
+}
+
+void Coordinator::SetDeferredActionResponses(bool value) {
+    imp_->deferred_action_responses_ = value;
+    for (auto a : imp_->agents_) {
+        a->Actions()->SetDeferredResponses(value || imp_->combined_step_requests_);
+        a->ActionsFeatureLayer()->SetDeferredResponses(value || imp_->combined_step_requests_);
+    }
+}
+
+void Coordinator::SetCombinedStepRequests(bool value) {
+    imp_->combined_step_requests_ = value;
+    SetDeferredActionResponses(imp_->deferred_action_responses_);
+}
+
+void Coordinator::SetReplayFarm(size_t info_processes, size_t prefetch_depth) {
+    // The info processes are launched with the replay observers.
+    assert(!imp_->starcraft_started_);
+    imp_->replay_info_processes_ = info_processes;
+    imp_->replay_prefetch_depth_ = std::max<size_t>(prefetch_depth, 1);
+}
+
 void Coordinator::SetPortStart(int port_start) {
     assert(!imp_->starcraft_started_);
     imp_->process_settings_.port_start = port_start;
@@ -1170,6 +2025,7 @@ void Coordinator::SetUseGeneralizedAbilityId(bool value) {
 
 bool Coordinator::SetReplayPath(const std::string& path) {
     imp_->replay_settings_.replay_file.clear();
+    imp_->replay_list_prepared_ = false;
 
     if (HasExtension(path, ".SC2Replay")) {
         imp_->replay_settings_.replay_file.push_back(path);
@@ -1191,6 +2047,7 @@ bool Coordinator::LoadReplayList(const std::string& file_path) {
         return false;
 
     imp_->replay_settings_.replay_file.clear();
+    imp_->replay_list_prepared_ = false;
 
     std::ifstream replay_file(file_path);
 
@@ -1210,9 +2067,19 @@ void Coordinator::SaveReplayList(const std::string& file_path) {
     for (const std::string& line : imp_->replay_settings_.replay_file) {
         replay_file << line << std::endl;
     }
+
+    if (imp_->replay_farm_) {
+        for (const std::string& line : imp_->replay_farm_->GetRemainingReplays()) {
+            replay_file << line << std::endl;
+        }
+    }
 }
 
 bool Coordinator::HasReplays() const {
+    if (imp_->replay_farm_ && imp_->replay_farm_->HasReplays()) {
+        return true;
+    }
+
     return !imp_->replay_settings_.replay_file.empty();
 }
 
@@ -0,0 +1,47 @@
+#include "sc2api/sc2_game_data_cache.h"
+
+namespace sc2 {
+
+std::string GameDataCache::MakeKey(uint32_t base_build, const std::string& data_version, const std::string& map_path) {
+    return std::to_string(base_build) + "/" + data_version + "/" + map_path;
+}
+
+bool GameDataCache::GetAbilities(const std::string& key, Abilities& abilities) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = abilities_.find(key);
+    if (found == abilities_.end()) {
+        return false;
+    }
+
+    abilities = found->second;
+    return true;
+}
+
+void GameDataCache::SetAbilities(const std::string& key, const Abilities& abilities) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abilities_[key] = abilities;
+}
+
+bool GameDataCache::GetUnitTypes(const std::string& key, UnitTypes& unit_types) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = unit_types_.find(key);
+    if (found == unit_types_.end()) {
+        return false;
+    }
+
+    unit_types = found->second;
+    return true;
+}
+
+void GameDataCache::SetUnitTypes(const std::string& key, const UnitTypes& unit_types) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unit_types_[key] = unit_types;
+}
+
+void GameDataCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abilities_.clear();
+    unit_types_.clear();
+}
+
+}
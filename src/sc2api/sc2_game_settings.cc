@@ -35,6 +35,14 @@ ReplaySettings::ReplaySettings() :
     player_id(1) {
 }
 
+ReplayStats::ReplayStats() :
+    replays_loaded(0),
+    replays_ignored(0),
+    relaunches(0),
+    version_relaunches(0),
+    relaunch_seconds(0.0) {
+}
+
 const char* kMapBelShirVestigeLE       = "Ladder/(2)Bel'ShirVestigeLE (Void).SC2Map";
 const char* kMapEmpty                  = "Test/Empty.SC2Map";
 const char* kMapEmptyLong              = "Test/EmptyLong.SC2Map";
@@ -0,0 +1,309 @@
+#include "sc2api/sc2_process_pool.h"
+#include "sc2api/sc2_connection.h"
+
+#include "sc2utils/sc2_manage_process.h"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace sc2 {
+
+// Consecutive failed launches after which the pool stops replenishing until the version changes.
+static const size_t MaxLaunchFailures = 3;
+// How often a launching process is checked for accepting connections.
+static const unsigned int ReadyPollMs = 250;
+
+// Whether something on this machine listens on the port, tested by binding it on the loopback address.
+static bool IsPortInUse(int port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<unsigned short>(port));
+
+#if defined(_WIN32)
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        return false;
+    }
+
+    bool in_use = false;
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s != INVALID_SOCKET) {
+        in_use = bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0;
+        closesocket(s);
+    }
+    WSACleanup();
+    return in_use;
+#else
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) {
+        return false;
+    }
+
+    bool in_use = bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0;
+    close(s);
+    return in_use;
+#endif
+}
+
+std::vector<std::string> GetProcessCommandLine(const ProcessSettings& process_settings, int port, int window_width, int window_height, int window_start_x, int window_start_y, int client_num) {
+    // Command line arguments that will be passed to sc2.
+    std::vector<std::string> cl = {
+        "-listen", process_settings.net_address,
+        "-port", std::to_string(port)
+    };
+
+    // DirectX will fail if multiple games try to launch in fullscreen mode. Force them into windowed mode.
+    cl.push_back("-displayMode"); cl.push_back("0");
+
+    if (process_settings.data_version.size() > 0) {
+        cl.push_back("-dataVersion"); cl.push_back(process_settings.data_version);
+    }
+
+    for (const std::string& command : process_settings.extra_command_lines)
+        cl.push_back(command);
+
+    cl.push_back("-windowwidth"); cl.push_back(std::to_string(window_width));
+    cl.push_back("-windowheight"); cl.push_back(std::to_string(window_height));
+
+    if (client_num < 2) {
+        cl.push_back("-windowx"); cl.push_back(std::to_string(window_start_x + window_width * client_num));
+        cl.push_back("-windowy"); cl.push_back(std::to_string(window_start_y));
+    }
+    else if (client_num < 4) {
+        cl.push_back("-windowx"); cl.push_back(std::to_string(window_start_x + window_width * (client_num - 2)));
+        cl.push_back("-windowy"); cl.push_back(std::to_string(window_start_y + window_height));
+    }
+
+    return cl;
+}
+
+ProcessPool::ProcessPool(const ProcessSettings& process_settings, size_t spare_count, int port_start, int port_count) :
+    settings_(process_settings),
+    spare_count_(spare_count),
+    port_start_(port_start),
+    port_count_(std::max(port_count, 1)),
+    next_port_(port_start),
+    window_width_(1024),
+    window_height_(768),
+    window_start_x_(100),
+    window_start_y_(200),
+    launching_(0),
+    failures_(0),
+    stopping_(false) {
+    settings_.process_info.clear();
+    thread_ = std::thread(&ProcessPool::ReplenishLoop, this);
+}
+
+ProcessPool::~ProcessPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+
+    for (const Spare& spare : ready_) {
+        TerminateProcess(spare.info.process_id);
+    }
+}
+
+void ProcessPool::SetWindow(int width, int height, int start_x, int start_y) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_width_ = width;
+    window_height_ = height;
+    window_start_x_ = start_x;
+    window_start_y_ = start_y;
+}
+
+bool ProcessPool::Acquire(ProcessInfo& process_info, const std::string& process_path, const std::string& data_version) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::string path = process_path.empty() ? settings_.process_path : process_path;
+    std::string version = data_version.empty() ? settings_.data_version : data_version;
+
+    // Spares are launched for the version last asked for, the ones of another version would only take up room.
+    if (path != settings_.process_path || version != settings_.data_version) {
+        settings_.process_path = path;
+        settings_.data_version = version;
+        failures_ = 0;
+
+        auto other_version = std::remove_if(ready_.begin(), ready_.end(), [this](const Spare& spare) {
+            return spare.info.process_path != settings_.process_path || spare.data_version != settings_.data_version;
+        });
+        for (auto it = other_version; it != ready_.end(); ++it) {
+            TerminateProcess(it->info.process_id);
+        }
+        ready_.erase(other_version, ready_.end());
+    }
+
+    while (!ready_.empty()) {
+        Spare spare = ready_.front();
+        ready_.pop_front();
+        changed_.notify_all();
+
+        // A spare may have died while it waited.
+        if (IsProcessRunning(spare.info.process_id)) {
+            process_info = spare.info;
+            acquired_.push_back(spare.info);
+            return true;
+        }
+    }
+
+    // Nothing ready, launch one on the spot.
+    ProcessSettings settings;
+    int port = 0;
+    std::vector<std::string> command_line;
+    if (!PrepareLaunch(settings, port, command_line)) {
+        return false;
+    }
+    lock.unlock();
+
+    bool launched = Launch(settings, command_line, port, process_info);
+
+    lock.lock();
+    ReleasePort(port);
+    if (launched) {
+        acquired_.push_back(process_info);
+    }
+    return launched;
+}
+
+size_t ProcessPool::GetReadyCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_.size();
+}
+
+bool ProcessPool::PrepareLaunch(ProcessSettings& settings, int& port, std::vector<std::string>& command_line) {
+    // Processes taken from the pool that have exited free their ports.
+    acquired_.erase(std::remove_if(acquired_.begin(), acquired_.end(), [](const ProcessInfo& process) {
+        return !IsProcessRunning(process.process_id);
+    }), acquired_.end());
+
+    for (int i = 0; i < port_count_; ++i) {
+        int candidate = next_port_;
+        next_port_ = next_port_ + 1 < port_start_ + port_count_ ? next_port_ + 1 : port_start_;
+        if (IsPortUsed(candidate) || IsPortInUse(candidate)) {
+            continue;
+        }
+
+        settings = settings_;
+        port = candidate;
+        launching_ports_.push_back(port);
+        command_line = GetProcessCommandLine(settings, port, window_width_, window_height_, window_start_x_, window_start_y_);
+        return true;
+    }
+
+    std::cerr << "ProcessPool: no free port in " << port_start_ << " to " << port_start_ + port_count_ - 1 << std::endl;
+    return false;
+}
+
+void ProcessPool::ReleasePort(int port) {
+    auto found = std::find(launching_ports_.begin(), launching_ports_.end(), port);
+    if (found != launching_ports_.end()) {
+        launching_ports_.erase(found);
+    }
+}
+
+bool ProcessPool::IsPortUsed(int port) {
+    if (std::find(launching_ports_.begin(), launching_ports_.end(), port) != launching_ports_.end()) {
+        return true;
+    }
+
+    auto same_port = [port](const ProcessInfo& process) { return process.port == port; };
+    if (std::any_of(acquired_.begin(), acquired_.end(), same_port)) {
+        return true;
+    }
+
+    return std::any_of(ready_.begin(), ready_.end(), [&same_port](const Spare& spare) { return same_port(spare.info); });
+}
+
+void ProcessPool::ReplenishLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [this]() {
+            return stopping_ || (ready_.size() + launching_ < spare_count_ && failures_ < MaxLaunchFailures);
+        });
+
+        if (stopping_) {
+            break;
+        }
+
+        ProcessSettings settings;
+        int port = 0;
+        std::vector<std::string> command_line;
+        if (!PrepareLaunch(settings, port, command_line)) {
+            ++failures_;
+            continue;
+        }
+        ++launching_;
+
+        lock.unlock();
+        ProcessInfo process_info;
+        bool launched = Launch(settings, command_line, port, process_info);
+        lock.lock();
+
+        --launching_;
+        ReleasePort(port);
+        if (!launched) {
+            ++failures_;
+            continue;
+        }
+        failures_ = 0;
+
+        // The version may have changed while it launched.
+        if (stopping_ || settings.process_path != settings_.process_path || settings.data_version != settings_.data_version) {
+            TerminateProcess(process_info.process_id);
+            continue;
+        }
+
+        ready_.push_back(Spare{ process_info, settings.data_version });
+        changed_.notify_all();
+    }
+}
+
+bool ProcessPool::Launch(const ProcessSettings& settings, const std::vector<std::string>& command_line, int port, ProcessInfo& process_info) {
+    process_info.process_path = settings.process_path;
+    process_info.port = port;
+    process_info.process_id = StartProcess(settings.process_path, command_line);
+    if (!process_info.process_id) {
+        std::cerr << "ProcessPool: unable to start sc2 executable with path: " << settings.process_path << std::endl;
+        return false;
+    }
+
+    // Ready once it accepts a connection. The probe disconnects again, the client that takes the process reconnects.
+    unsigned int waited_ms = 0;
+    while (waited_ms < static_cast<unsigned int>(settings.timeout_ms)) {
+        Connection probe;
+        if (probe.Connect(settings.net_address, port, false)) {
+            return true;
+        }
+
+        if (!IsProcessRunning(process_info.process_id)) {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+        }
+
+        SleepFor(ReadyPollMs);
+        waited_ms += ReadyPollMs;
+    }
+
+    std::cerr << "ProcessPool: sc2 process on port " << port << " did not become ready." << std::endl;
+    TerminateProcess(process_info.process_id);
+    return false;
+}
+
+}
@@ -65,11 +65,14 @@ ProtoInterface::ProtoInterface() :
     port_(5000),
     default_timeout_ms_(kDefaultProtoInterfaceTimeout),
     latest_status_(SC2APIProtocol::Status::unknown),
-    response_pending_(SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+    response_pending_(SC2APIProtocol::Response::RESPONSE_NOT_SET),
+    allow_requests_during_step_(false),
+    step_response_held_(false) {
 }
 
 bool ProtoInterface::ConnectToGame(const std::string& address, int port, int timeout_ms) {
     latest_status_ = SC2APIProtocol::Status::unknown;
+    deferred_responses_.clear();
     address_ = address;
     port_ = port;
     default_timeout_ms_ = timeout_ms;
@@ -85,7 +88,19 @@ bool ProtoInterface::ConnectToGame(const std::string& address, int port, int tim
 }
 
 GameRequestPtr ProtoInterface::MakeRequest() {
-    return std::make_shared<SC2APIProtocol::Request>(SC2APIProtocol::Request());
+    return std::make_shared<SC2APIProtocol::Request>();
+}
+
+GameRequestPtr& ProtoInterface::ReuseRequest(GameRequestPtr& request) {
+    // Someone else may still look at a shared request.
+    if (!request || request.use_count() > 1) {
+        request = MakeRequest();
+    }
+    else {
+        request->Clear();
+    }
+
+    return request;
 }
 
 #if SC2API_MESSAGE_LOGGING
@@ -119,9 +134,15 @@ bool ProtoInterface::SendRequest(GameRequestPtr& request, bool ignore_pending_re
 
     // Technically there can be new requests while responses are pending, but this library is not written for that.
     // For now, make everything purely sequential.
-    if (!ignore_pending_requests && HasResponsePending()) {
-        control_->Error(ClientError::ResponseNotConsumed);
-        return false;
+    if (!ignore_pending_requests && response_pending_ != SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+        if (!allow_requests_during_step_ || response_pending_ != SC2APIProtocol::Response::kStep || step_response_held_) {
+            control_->Error(ClientError::ResponseNotConsumed);
+            return false;
+        }
+
+        // SC2 answers in order, so the step has to finish before this request is answered anyway.
+        held_step_response_ = WaitForResponseInternal();
+        step_response_held_ = true;
     }
 
 #if SC2API_MESSAGE_LOGGING
@@ -138,12 +159,103 @@ bool ProtoInterface::SendRequest(GameRequestPtr& request, bool ignore_pending_re
     return true;
 }
 
+bool ProtoInterface::SendRequestDeferred(GameRequestPtr& request, std::function<void(const GameResponsePtr& response)> on_response) {
+    // The response would arrive after the pending one, wait for it instead.
+    if (response_pending_ != SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+        if (!SendRequest(request)) {
+            return false;
+        }
+
+        GameResponsePtr response = WaitForResponseInternal();
+        if (on_response) {
+            on_response(response);
+        }
+        return response.get() != nullptr;
+    }
+
+    if (!SendRequest(request)) {
+        return false;
+    }
+
+    deferred_responses_.push_back(DeferredResponse{ response_pending_, on_response });
+    response_pending_ = SC2APIProtocol::Response::RESPONSE_NOT_SET;
+    return true;
+}
+
+bool ProtoInterface::ReceiveDeferredResponses() {
+    while (!deferred_responses_.empty()) {
+        if (!ReceiveDeferredResponse()) {
+            // Nothing more is coming, don't wait for each of the rest to time out.
+            for (const DeferredResponse& deferred : deferred_responses_) {
+                OnDeferredResponse(deferred, nullptr);
+            }
+            deferred_responses_.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ProtoInterface::ReceiveDeferredResponse() {
+    DeferredResponse deferred = deferred_responses_.front();
+    deferred_responses_.pop_front();
+
+    GameResponsePtr response;
+    bool received = ReceiveResponse(deferred.response_case, response);
+    OnDeferredResponse(deferred, response);
+    return received;
+}
+
+void ProtoInterface::OnDeferredResponse(const DeferredResponse& deferred, const GameResponsePtr& response) {
+    if (!response.get() || response->error_size() > 0) {
+        size_t index = static_cast<size_t>(deferred.response_case);
+        if (index >= deferred_failures_.size()) {
+            deferred_failures_.resize(index + 1, 0);
+        }
+        ++deferred_failures_[index];
+    }
+
+    if (deferred.on_response) {
+        deferred.on_response(response);
+    }
+}
+
+uint32_t ProtoInterface::GetDeferredFailures(SC2APIProtocol::Response::ResponseCase response_case) const {
+    size_t index = static_cast<size_t>(response_case);
+    return index < deferred_failures_.size() ? deferred_failures_[index] : 0;
+}
+
 GameResponsePtr ProtoInterface::WaitForResponseInternal() {
+    if (step_response_held_ && response_pending_ == SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+        step_response_held_ = false;
+        allow_requests_during_step_ = false;
+        GameResponsePtr response = held_step_response_;
+        held_step_response_ = nullptr;
+        return response;
+    }
+
+    GameResponsePtr response;
+    if (!ReceiveDeferredResponses() || !ReceiveResponse(response_pending_, response)) {
+        return nullptr;
+    }
+
+    // The step the requests were allowed during is over, the next one has to allow them again.
+    if (response_pending_ == SC2APIProtocol::Response::kStep) {
+        allow_requests_during_step_ = false;
+    }
+
+    // No longer expecting a specific response.
+    response_pending_ = SC2APIProtocol::Response::RESPONSE_NOT_SET;
+    return response;
+}
+
+bool ProtoInterface::ReceiveResponse(SC2APIProtocol::Response::ResponseCase expected, GameResponsePtr& response_ptr) {
     latest_status_ = SC2APIProtocol::Status::unknown;
     SC2APIProtocol::Response* response = nullptr;
     if (!connection_.Receive(response, default_timeout_ms_)) {
         // If the receive fails, it means a timeout has occurred.
-        return nullptr;
+        return false;
     }
 
     for (int i = 0; error_callback_ && response && i < response->error_size(); ++i) {
@@ -155,23 +267,22 @@ GameResponsePtr ProtoInterface::WaitForResponseInternal() {
             latest_status_ = response->status();
         }
         if (response->error_size() > 0) {
-            std::cerr << "While waiting for Response" << RequestResponseIDToName(response_pending_) << " received an error." << std::endl;
+            std::cerr << "While waiting for Response" << RequestResponseIDToName(expected) << " received an error." << std::endl;
             for (int i = 0; i < response->error_size(); ++i) {
                 std::cerr << "Error: " << response->error(i) << std::endl;
             }
         }
         else {
             SC2APIProtocol::Response::ResponseCase actual_response = response->response_case();
-            if (response_pending_ != actual_response) {
+            if (expected != actual_response) {
                 // This is bad, it means we did not get the response that matches the last request.
                 control_->Error(ClientError::ResponseMismatch);
             }
         }
     }
 
-    // No longer expecting a specific response.
-    response_pending_ = SC2APIProtocol::Response::RESPONSE_NOT_SET;
-    return GameResponsePtr(response);
+    response_ptr = GameResponsePtr(response);
+    return true;
 }
 
 bool ProtoInterface::PingGame() {
@@ -211,11 +322,31 @@ void ProtoInterface::SetErrorCallback(std::function<void(const std::string& erro
 }
 
 bool ProtoInterface::PollResponse() {
+    if (step_response_held_ && response_pending_ == SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+        return true;
+    }
+
+    // The responses of deferred requests come first.
+    while (!deferred_responses_.empty() && connection_.PollResponse()) {
+        ReceiveDeferredResponse();
+    }
+    if (!deferred_responses_.empty()) {
+        return false;
+    }
+
     return connection_.PollResponse();
 }
 
 bool ProtoInterface::HasResponsePending() const {
-    return response_pending_ != SC2APIProtocol::Response::ResponseCase::RESPONSE_NOT_SET;
+    return response_pending_ != SC2APIProtocol::Response::ResponseCase::RESPONSE_NOT_SET || step_response_held_;
+}
+
+SC2APIProtocol::Response::ResponseCase ProtoInterface::GetResponsePending() const {
+    if (step_response_held_ && response_pending_ == SC2APIProtocol::Response::RESPONSE_NOT_SET) {
+        return SC2APIProtocol::Response::kStep;
+    }
+
+    return response_pending_;
 }
 
 }
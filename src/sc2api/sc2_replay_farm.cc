@@ -0,0 +1,268 @@
+#include "sc2api/sc2_replay_farm.h"
+#include "sc2api/sc2_replay_observer.h"
+#include "sc2api/sc2_control_interfaces.h"
+#include "sc2api/sc2_game_settings.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <numeric>
+
+namespace sc2 {
+
+ReplayFarm::ReplayFarm(std::vector<std::string> replays, const std::vector<ReplayObserver*>& info_clients, size_t worker_count, size_t prefetch_depth) :
+    replays_(std::move(replays)),
+    queues_(std::max<size_t>(worker_count, 1)),
+    worker_builds_(queues_.size(), 0),
+    prefetch_depth_(std::max<size_t>(prefetch_depth, 1)),
+    gathering_(0),
+    gatherers_(info_clients.size()),
+    stopping_(false) {
+    assert(worker_count > 0);
+
+    replays_.erase(std::remove(replays_.begin(), replays_.end(), std::string()), replays_.end());
+
+    for (ReplayObserver* client : info_clients) {
+        assert(client);
+        threads_.emplace_back(&ReplayFarm::GatherLoop, this, client);
+    }
+}
+
+ReplayFarm::~ReplayFarm() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+template<typename Match>
+static bool TakeMatching(std::deque<ReplayJob>& queue, bool from_front, Match match, ReplayJob& job) {
+    if (from_front) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (match(*it)) {
+                job = std::move(*it);
+                queue.erase(it);
+                return true;
+            }
+        }
+    }
+    else {
+        for (auto it = queue.rbegin(); it != queue.rend(); ++it) {
+            if (match(*it)) {
+                job = std::move(*it);
+                queue.erase(std::next(it).base());
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool ReplayFarm::TakeJob(size_t worker, uint32_t base_build, ReplayJob& job) {
+    if (QueuedCount() == 0) {
+        return false;
+    }
+
+    // Busiest queues are stolen from first.
+    std::vector<size_t> order(queues_.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return queues_[a].size() > queues_[b].size(); });
+
+    // Own queue first, in order, then steal the newest replay of another worker.
+    uint32_t build = base_build;
+    auto on_build = [&build](const ReplayJob& queued) {
+        return build == 0 || !queued.has_info || queued.info.base_build == build;
+    };
+    auto take = [&]() {
+        if (TakeMatching(queues_[worker], true, on_build, job)) {
+            return true;
+        }
+        for (size_t i : order) {
+            if (i != worker && TakeMatching(queues_[i], false, on_build, job)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if (take()) {
+        return true;
+    }
+
+    build = ChooseBuildToSwitchTo();
+    return build != 0 && take();
+}
+
+uint32_t ReplayFarm::ChooseBuildToSwitchTo() const {
+    std::map<uint32_t, size_t> waiting;
+    for (const std::deque<ReplayJob>& queue : queues_) {
+        for (const ReplayJob& job : queue) {
+            if (job.has_info) {
+                ++waiting[job.info.base_build];
+            }
+        }
+    }
+
+    std::map<uint32_t, size_t> workers;
+    for (uint32_t build : worker_builds_) {
+        ++workers[build];
+    }
+
+    // Switch to the build whose workers can't keep up with its replays. At the end of the run anything goes.
+    bool more_coming = !replays_.empty() || gathering_ > 0;
+    uint32_t best_build = 0;
+    size_t best_excess = 0;
+    for (const auto& build : waiting) {
+        size_t kept = prefetch_depth_ * workers[build.first];
+        size_t excess = more_coming ? (build.second > kept ? build.second - kept : 0) : build.second;
+        if (excess > best_excess) {
+            best_build = build.first;
+            best_excess = excess;
+        }
+    }
+
+    return best_build;
+}
+
+std::deque<ReplayJob>& ReplayFarm::ChooseQueue(uint32_t base_build) {
+    // The shortest queue of a worker on the build, if there is one.
+    std::deque<ReplayJob>* best = nullptr;
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        if (worker_builds_[i] == base_build && (!best || queues_[i].size() < best->size())) {
+            best = &queues_[i];
+        }
+    }
+
+    if (!best) {
+        best = &*std::min_element(queues_.begin(), queues_.end(),
+            [](const std::deque<ReplayJob>& a, const std::deque<ReplayJob>& b) { return a.size() < b.size(); });
+    }
+
+    return *best;
+}
+
+bool ReplayFarm::Next(size_t worker, uint32_t base_build, ReplayJob& job) {
+    assert(worker < queues_.size());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    worker_builds_[worker] = base_build;
+    for (;;) {
+        if (stopping_) {
+            return false;
+        }
+
+        if (TakeJob(worker, base_build, job)) {
+            // Wakes the info threads to refill.
+            changed_.notify_all();
+            return true;
+        }
+
+        if (replays_.empty() && gathering_ == 0) {
+            return false;
+        }
+
+        // No info client left, the worker has to gather the info itself.
+        if (gatherers_ == 0 && !replays_.empty()) {
+            job = ReplayJob();
+            job.path = replays_.back();
+            replays_.pop_back();
+            return true;
+        }
+
+        changed_.wait(lock);
+    }
+}
+
+void ReplayFarm::Retry(size_t worker, const ReplayJob& job) {
+    assert(worker < queues_.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queues_[worker].push_front(job);
+    }
+    changed_.notify_all();
+}
+
+bool ReplayFarm::HasReplays() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !replays_.empty() || gathering_ > 0 || QueuedCount() > 0;
+}
+
+std::vector<std::string> ReplayFarm::GetRemainingReplays() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> remaining = replays_;
+    for (const std::deque<ReplayJob>& queue : queues_) {
+        for (const ReplayJob& job : queue) {
+            remaining.push_back(job.path);
+        }
+    }
+
+    return remaining;
+}
+
+size_t ReplayFarm::QueuedCount() const {
+    size_t count = 0;
+    for (const std::deque<ReplayJob>& queue : queues_) {
+        count += queue.size();
+    }
+
+    return count;
+}
+
+void ReplayFarm::GatherLoop(ReplayObserver* client) {
+    const size_t max_ready = prefetch_depth_ * queues_.size();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [this, max_ready]() {
+            return stopping_ || replays_.empty() || QueuedCount() + gathering_ < max_ready;
+        });
+
+        if (stopping_ || replays_.empty()) {
+            break;
+        }
+
+        ReplayJob job;
+        job.path = replays_.back();
+        replays_.pop_back();
+        ++gathering_;
+
+        lock.unlock();
+        bool gathered = client->ReplayControl()->GatherReplayInfo(job.path, true);
+        ControlInterface* control = client->Control();
+        bool client_alive = control->GetAppState() == AppState::normal && control->GetClientErrors().empty();
+        lock.lock();
+
+        --gathering_;
+        if (gathered) {
+            job.info = client->ReplayControl()->GetReplayInfo();
+            job.has_info = true;
+
+            ChooseQueue(job.info.base_build).push_back(std::move(job));
+        }
+        else if (!client_alive) {
+            // The replay isn't at fault, leave it to the other info clients or the workers.
+            std::cerr << "ReplayFarm: info client failed, " << --gatherers_ << " left." << std::endl;
+            replays_.push_back(job.path);
+            changed_.notify_all();
+            return;
+        }
+        else {
+            std::cerr << "ReplayFarm: could not read replay info, skipping: " << job.path << std::endl;
+        }
+
+        changed_.notify_all();
+    }
+
+    --gatherers_;
+    changed_.notify_all();
+}
+
+}
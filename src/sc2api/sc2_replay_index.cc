@@ -0,0 +1,314 @@
+#include "sc2api/sc2_replay_index.h"
+
+#include "sc2utils/sc2_simple_serialization.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace sc2 {
+
+static const uint32_t ReplayIndexFileMagic = 0x58495253; // "SRIX"
+static const uint32_t ReplayIndexFileVersion = 1;
+
+bool ReplayFilter::Matches(const ReplayInfo& replay_info) const {
+    if (!base_builds.empty() &&
+        std::find(base_builds.begin(), base_builds.end(), replay_info.base_build) == base_builds.end()) {
+        return false;
+    }
+
+    if (replay_info.duration < min_duration) {
+        return false;
+    }
+
+    if (!map_name.empty() && replay_info.map_name != map_name) {
+        return false;
+    }
+
+    if (num_players > 0 && replay_info.num_players != num_players) {
+        return false;
+    }
+
+    for (int i = 0; i < replay_info.num_players; ++i) {
+        const ReplayPlayerInfo& player = replay_info.players[i];
+        if (min_mmr > 0 && player.mmr < min_mmr) {
+            return false;
+        }
+        if (max_mmr > 0 && player.mmr > max_mmr) {
+            return false;
+        }
+        if (player.apm < min_apm) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ReplayIndex::HashReplayFile(const std::string& path, uint64_t& hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // FNV-1a, replays are small enough that hashing all of it costs far less than a replay info request.
+    hash = 14695981039346656037ULL;
+    char buffer[64 * 1024];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        std::streamsize count = file.gcount();
+        for (std::streamsize i = 0; i < count; ++i) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return file.eof();
+}
+
+static void WriteEntry(std::ofstream& file, const std::string& path, uint64_t hash, const ReplayInfo& info) {
+    WriteBinary(file, path);
+    WriteBinary(file, hash);
+    WriteBinary(file, info.duration);
+    WriteBinary(file, static_cast<uint32_t>(info.duration_gameloops));
+    WriteBinary(file, info.data_build);
+    WriteBinary(file, info.base_build);
+    WriteBinary(file, info.map_name);
+    WriteBinary(file, info.map_path);
+    WriteBinary(file, info.version);
+    WriteBinary(file, info.data_version);
+
+    WriteBinary(file, info.num_players);
+    for (int i = 0; i < info.num_players; ++i) {
+        const ReplayPlayerInfo& player = info.players[i];
+        WriteBinary(file, static_cast<int32_t>(player.player_id));
+        WriteBinary(file, static_cast<int32_t>(player.mmr));
+        WriteBinary(file, static_cast<int32_t>(player.apm));
+        WriteBinary(file, static_cast<int32_t>(player.race));
+        WriteBinary(file, static_cast<int32_t>(player.race_selected));
+        WriteBinary(file, static_cast<int32_t>(player.game_result));
+    }
+}
+
+static bool ReadEntry(std::ifstream& file, std::string& path, uint64_t& hash, ReplayInfo& info) {
+    uint32_t duration_gameloops = 0;
+    if (!ReadBinary(file, path) ||
+        !ReadBinary(file, hash) ||
+        !ReadBinary(file, info.duration) ||
+        !ReadBinary(file, duration_gameloops) ||
+        !ReadBinary(file, info.data_build) ||
+        !ReadBinary(file, info.base_build) ||
+        !ReadBinary(file, info.map_name) ||
+        !ReadBinary(file, info.map_path) ||
+        !ReadBinary(file, info.version) ||
+        !ReadBinary(file, info.data_version) ||
+        !ReadBinary(file, info.num_players)) {
+        return false;
+    }
+
+    if (info.num_players < 0 || info.num_players > max_num_players) {
+        return false;
+    }
+
+    info.duration_gameloops = duration_gameloops;
+    info.replay_path = path;
+    for (int i = 0; i < info.num_players; ++i) {
+        int32_t values[6];
+        for (int32_t& value : values) {
+            if (!ReadBinary(file, value)) {
+                return false;
+            }
+        }
+
+        ReplayPlayerInfo& player = info.players[i];
+        player.player_id = values[0];
+        player.mmr = values[1];
+        player.apm = values[2];
+        player.race = static_cast<Race>(values[3]);
+        player.race_selected = static_cast<Race>(values[4]);
+        player.game_result = static_cast<GameResult>(values[5]);
+    }
+
+    return true;
+}
+
+// Moves a file over another. On POSIX the rename is atomic, a reader sees either the old or the new file.
+static bool ReplaceFileWith(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool ReplayIndex::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (!ReadBinary(file, magic) || magic != ReplayIndexFileMagic ||
+        !ReadBinary(file, version) || version != ReplayIndexFileVersion ||
+        !ReadBinary(file, count) || count > MaxBinaryElements) {
+        return false;
+    }
+
+    // Read in full before touching the index, so a corrupt file adds nothing.
+    std::unordered_map<std::string, Entry> loaded;
+    loaded.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string replay_path;
+        Entry entry;
+        if (!ReadEntry(file, replay_path, entry.hash, entry.info)) {
+            return false;
+        }
+
+        loaded[replay_path] = entry;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.empty()) {
+        entries_.swap(loaded);
+        return true;
+    }
+
+    entries_.reserve(entries_.size() + loaded.size());
+    for (auto& entry : loaded) {
+        entries_[entry.first] = std::move(entry.second);
+    }
+
+    return true;
+}
+
+bool ReplayIndex::Save(const std::string& path) const {
+    // Written next to the index and moved over it once complete, so a crash while saving keeps the previous index.
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WriteBinary(file, ReplayIndexFileMagic);
+        WriteBinary(file, ReplayIndexFileVersion);
+        WriteBinary(file, static_cast<uint32_t>(entries_.size()));
+        for (const auto& entry : entries_) {
+            WriteEntry(file, entry.first, entry.second.hash, entry.second.info);
+        }
+    }
+
+    file.close();
+    if (!file || !ReplaceFileWith(temp_path, path)) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ReplayIndex::Find(const std::string& replay_path, ReplayInfo& replay_info) const {
+    {
+        // Don't hash files that aren't indexed.
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.find(replay_path) == entries_.end()) {
+            return false;
+        }
+    }
+
+    uint64_t hash = 0;
+    if (!HashReplayFile(replay_path, hash)) {
+        return false;
+    }
+
+    return Find(replay_path, hash, replay_info);
+}
+
+bool ReplayIndex::Find(const std::string& replay_path, uint64_t hash, ReplayInfo& replay_info) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = entries_.find(replay_path);
+    if (found == entries_.end() || found->second.hash != hash) {
+        return false;
+    }
+
+    replay_info = found->second.info;
+    return true;
+}
+
+void ReplayIndex::Add(const ReplayInfo& replay_info, uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[replay_info.replay_path];
+    entry.hash = hash;
+    entry.info = replay_info;
+}
+
+bool ReplayIndex::Add(const ReplayInfo& replay_info) {
+    uint64_t hash = 0;
+    if (!HashReplayFile(replay_info.replay_path, hash)) {
+        return false;
+    }
+
+    Add(replay_info, hash);
+    return true;
+}
+
+void ReplayIndex::Remove(const std::string& replay_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(replay_path);
+}
+
+void ReplayIndex::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+size_t ReplayIndex::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::vector<std::string> ReplayIndex::Filter(const std::function<bool(const ReplayInfo&)>& keep) const {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : entries_) {
+            if (keep(entry.second.info)) {
+                paths.push_back(entry.first);
+            }
+        }
+    }
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::vector<std::string> ReplayIndex::Filter(const ReplayFilter& filter) const {
+    return Filter([&filter](const ReplayInfo& replay_info) { return filter.Matches(replay_info); });
+}
+
+std::map<uint32_t, std::vector<std::string>> ReplayIndex::GroupByBaseBuild(const std::vector<std::string>& replay_paths, std::vector<std::string>* unindexed) const {
+    std::map<uint32_t, std::vector<std::string>> groups;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::string& replay_path : replay_paths) {
+        auto found = entries_.find(replay_path);
+        if (found == entries_.end()) {
+            if (unindexed) {
+                unindexed->push_back(replay_path);
+            }
+            continue;
+        }
+
+        groups[found->second.info.base_build].push_back(replay_path);
+    }
+
+    return groups;
+}
+
+}
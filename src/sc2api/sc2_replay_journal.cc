@@ -0,0 +1,293 @@
+#include "sc2api/sc2_replay_journal.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace sc2 {
+
+static const char* StatusName(ReplayJobStatus status) {
+    switch (status) {
+        case ReplayJobStatus::Started:  return "started";
+        case ReplayJobStatus::Finished: return "finished";
+        case ReplayJobStatus::Failed:   return "failed";
+        case ReplayJobStatus::Ignored:  return "ignored";
+        default:                        return "pending";
+    }
+}
+
+static bool ParseStatus(const std::string& name, ReplayJobStatus& status) {
+    static const ReplayJobStatus statuses[] = {
+        ReplayJobStatus::Started,
+        ReplayJobStatus::Finished,
+        ReplayJobStatus::Failed,
+        ReplayJobStatus::Ignored
+    };
+
+    for (ReplayJobStatus candidate : statuses) {
+        if (name == StatusName(candidate)) {
+            status = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Checksum closing each record, so a record cut short by a crash is told apart from a complete one.
+static uint32_t RecordChecksum(const std::string& record) {
+    uint32_t hash = 2166136261u;
+    for (char c : record) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Splits off and checks the checksum after the last tab. False for torn or corrupt lines.
+static bool ReadChecksummedRecord(const std::string& line, std::string& record) {
+    size_t tab = line.rfind('\t');
+    if (tab == std::string::npos || line.size() - tab - 1 != 8) {
+        return false;
+    }
+
+    char* end = nullptr;
+    std::string checksum = line.substr(tab + 1);
+    unsigned long value = std::strtoul(checksum.c_str(), &end, 16);
+    if (*end != '\0') {
+        return false;
+    }
+
+    record = line.substr(0, tab);
+    return static_cast<uint32_t>(value) == RecordChecksum(record);
+}
+
+ReplayJournal::ReplayJournal() :
+    file_(nullptr),
+    sync_interval_(1),
+    unsynced_(0),
+    max_failures_(3) {
+}
+
+ReplayJournal::~ReplayJournal() {
+    Close();
+}
+
+bool ReplayJournal::Open(const std::string& path, size_t sync_interval) {
+    Close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.clear();
+
+    std::ifstream existing(path);
+    std::stringstream contents;
+    contents << existing.rdbuf();
+    existing.close();
+
+    std::string line;
+    while (std::getline(contents, line)) {
+        // A line torn by a crash, or a record appended to one, fails its checksum.
+        std::string checked;
+        if (!ReadChecksummedRecord(line, checked)) {
+            continue;
+        }
+
+        std::istringstream record(checked);
+        std::string status_name;
+        long long time_ms = 0;
+        long long duration_ms = 0;
+        if (!(record >> status_name >> time_ms >> duration_ms)) {
+            continue;
+        }
+
+        // The path is the rest of the record, it may contain spaces.
+        std::string replay_path;
+        std::getline(record >> std::ws, replay_path);
+        ReplayJobStatus status;
+        if (replay_path.empty() || !ParseStatus(status_name, status)) {
+            continue;
+        }
+
+        Apply(jobs_[replay_path], status);
+    }
+
+    // Whatever was running when the journal was last written didn't survive. Earlier crashes were counted by the
+    // started record that followed them.
+    for (auto& job : jobs_) {
+        if (job.second.status == ReplayJobStatus::Started) {
+            Apply(job.second, ReplayJobStatus::Failed);
+        }
+    }
+
+    file_ = std::fopen(path.c_str(), "a");
+    if (!file_) {
+        std::cerr << "ReplayJournal: unable to open " << path << std::endl;
+        return false;
+    }
+
+    // Start on a line of its own after a torn last line, or the first new record would be lost with it.
+    const std::string& text = contents.str();
+    if (!text.empty() && text.back() != '\n') {
+        std::fputc('\n', file_);
+        std::fflush(file_);
+    }
+
+    sync_interval_ = std::max<size_t>(sync_interval, 1);
+    unsynced_ = 0;
+    return true;
+}
+
+void ReplayJournal::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+
+    SyncLocked();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool ReplayJournal::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ != nullptr;
+}
+
+void ReplayJournal::SetMaxFailures(uint32_t max_failures) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_failures_ = std::max<uint32_t>(max_failures, 1);
+}
+
+void ReplayJournal::RecordStarted(const std::string& replay_path) {
+    Record(replay_path, ReplayJobStatus::Started);
+}
+
+void ReplayJournal::RecordFinished(const std::string& replay_path) {
+    Record(replay_path, ReplayJobStatus::Finished);
+}
+
+void ReplayJournal::RecordFailed(const std::string& replay_path) {
+    Record(replay_path, ReplayJobStatus::Failed);
+}
+
+void ReplayJournal::RecordIgnored(const std::string& replay_path) {
+    Record(replay_path, ReplayJobStatus::Ignored);
+}
+
+void ReplayJournal::Sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncLocked();
+}
+
+ReplayJobStatus ReplayJournal::GetStatus(const std::string& replay_path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = jobs_.find(replay_path);
+    return found != jobs_.end() ? found->second.status : ReplayJobStatus::Pending;
+}
+
+uint32_t ReplayJournal::GetFailureCount(const std::string& replay_path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = jobs_.find(replay_path);
+    return found != jobs_.end() ? found->second.failures : 0;
+}
+
+bool ReplayJournal::ShouldRun(const std::string& replay_path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ShouldRunLocked(replay_path);
+}
+
+std::vector<std::string> ReplayJournal::GetPending(const std::vector<std::string>& replay_paths) const {
+    std::vector<std::string> pending;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::string& replay_path : replay_paths) {
+        if (ShouldRunLocked(replay_path)) {
+            pending.push_back(replay_path);
+        }
+    }
+
+    return pending;
+}
+
+bool ReplayJournal::ShouldRunLocked(const std::string& replay_path) const {
+    auto found = jobs_.find(replay_path);
+    if (found == jobs_.end()) {
+        return true;
+    }
+
+    const Job& job = found->second;
+    if (job.status == ReplayJobStatus::Finished || job.status == ReplayJobStatus::Ignored) {
+        return false;
+    }
+
+    return job.failures < max_failures_;
+}
+
+void ReplayJournal::Apply(Job& job, ReplayJobStatus status) {
+    // Started again without an outcome in between, the previous attempt died with the process.
+    if (status == ReplayJobStatus::Started && job.status == ReplayJobStatus::Started) {
+        ++job.failures;
+    }
+
+    job.status = status;
+    if (status == ReplayJobStatus::Failed) {
+        ++job.failures;
+    }
+}
+
+void ReplayJournal::Record(const std::string& replay_path, ReplayJobStatus status) {
+    auto now = std::chrono::steady_clock::now();
+    long long time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Job& job = jobs_[replay_path];
+
+    // Finished and failed records carry how long the attempt took.
+    long long duration_ms = 0;
+    if (job.status == ReplayJobStatus::Started && status != ReplayJobStatus::Started) {
+        duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - job.start_time).count();
+    }
+    if (status == ReplayJobStatus::Started) {
+        job.start_time = now;
+    }
+
+    Apply(job, status);
+
+    if (!file_) {
+        return;
+    }
+
+    char fields[64];
+    std::snprintf(fields, sizeof(fields), "%s %lld %lld ", StatusName(status), time_ms, duration_ms);
+    std::string record = fields + replay_path;
+    std::fprintf(file_, "%s\t%08x\n", record.c_str(), static_cast<unsigned int>(RecordChecksum(record)));
+    std::fflush(file_);
+    if (++unsynced_ >= sync_interval_) {
+        SyncLocked();
+    }
+}
+
+void ReplayJournal::SyncLocked() {
+    if (!file_ || unsynced_ == 0) {
+        return;
+    }
+
+    std::fflush(file_);
+#if defined(_WIN32)
+    _commit(_fileno(file_));
+#else
+    fsync(fileno(file_));
+#endif
+    unsynced_ = 0;
+}
+
+}
@@ -3,6 +3,7 @@
 #include "sc2api/sc2_control_interfaces.h"
 #include "sc2api/sc2_proto_to_pods.h"
 #include "sc2api/sc2_game_settings.h"
+#include "sc2api/sc2_replay_index.h"
 
 #include <iostream>
 
@@ -17,6 +18,7 @@ public:
     ReplayInfo replay_info_;
     ControlInterface* control_interface_;
     ReplayObserver* replay_observer_;
+    ReplayIndex* replay_index_;
 
     ReplayControlImp(ControlInterface* control_interface, ReplayObserver* replay_observer);
 
@@ -26,16 +28,27 @@ public:
     virtual void UseGeneralizedAbility(bool value) override;
 
     virtual const ReplayInfo& GetReplayInfo() const override;
+    virtual void SetReplayInfo(const ReplayInfo& replay_info) override;
+    virtual void SetReplayIndex(ReplayIndex* replay_index) override;
 };
 
 ReplayControlImp::ReplayControlImp(ControlInterface* control_interface, ReplayObserver* replay_observer) :
     control_interface_(control_interface),
-    replay_observer_(replay_observer) {
+    replay_observer_(replay_observer),
+    replay_index_(nullptr) {
 }
 
 bool ReplayControlImp::GatherReplayInfo(const std::string& path, bool download_data) {
     replay_info_.num_players = 0;
 
+    // Replays already indexed don't need a request.
+    uint64_t hash = 0;
+    bool hashed = replay_index_ && ReplayIndex::HashReplayFile(path, hash);
+    if (hashed && replay_index_->Find(path, hash, replay_info_)) {
+        replay_info_.replay_path = path;
+        return true;
+    }
+
     // Request the replay info.
     GameRequestPtr request = control_interface_->Proto().MakeRequest();
     SC2APIProtocol::RequestReplayInfo* request_replay_info = request->mutable_replay_info();
@@ -125,6 +138,10 @@ bool ReplayControlImp::GatherReplayInfo(const std::string& path, bool download_d
         ++replay_info_.num_players;
     }
 
+    if (hashed) {
+        replay_index_->Add(replay_info_, hash);
+    }
+
     return true;
 }
 
@@ -220,6 +237,14 @@ const ReplayInfo& ReplayControlImp::GetReplayInfo() const {
     return replay_info_;
 }
 
+void ReplayControlImp::SetReplayInfo(const ReplayInfo& replay_info) {
+    replay_info_ = replay_info;
+}
+
+void ReplayControlImp::SetReplayIndex(ReplayIndex* replay_index) {
+    replay_index_ = replay_index;
+}
+
 //-------------------------------------------------------------------------------------------------
 // ObserverActionImp: an implementation of an ObserverActionInterface.
 //-------------------------------------------------------------------------------------------------
@@ -227,7 +252,9 @@ const ReplayInfo& ReplayControlImp::GetReplayInfo() const {
 class ObserverActionImp : public ObserverActionInterface {
 public:
     ControlInterface& control_;
+    // Reused every step, holds actions to send if has_actions_ is set.
     GameRequestPtr request_;
+    bool has_actions_;
 
     ObserverActionImp(ControlInterface& control);
 
@@ -241,12 +268,14 @@ public:
 };
 
 ObserverActionImp::ObserverActionImp(ControlInterface& control) :
-    control_(control) {
+    control_(control),
+    has_actions_(false) {
 }
 
 SC2APIProtocol::RequestObserverAction* ObserverActionImp::GetRequest() {
-    if (request_ == nullptr) {
-        request_ = control_.Proto().MakeRequest();
+    if (!has_actions_) {
+        control_.Proto().ReuseRequest(request_);
+        has_actions_ = true;
     }
     return request_->mutable_obs_action();
 }
@@ -267,7 +296,13 @@ void ObserverActionImp::CameraFollowPlayer() {
 }
 
 void ObserverActionImp::SendActions() {
-    if (request_ == nullptr) {
+    // Replays don't take raw actions, a debug camera move becomes an observer one.
+    Point2D camera;
+    if (control_.TakeCameraMove(camera)) {
+        CameraMove(camera);
+    }
+
+    if (!has_actions_) {
         return;
     }
 
@@ -275,7 +310,7 @@ void ObserverActionImp::SendActions() {
         return;
     }
 
-    request_ = nullptr;
+    has_actions_ = false;
     control_.WaitForResponse();
 }
 
@@ -0,0 +1,186 @@
+#include "sc2api/sc2_step_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace sc2 {
+
+const char* StepPhaseToName(StepPhase phase) {
+    switch (phase) {
+        case StepPhase::Update:            return "Update";
+        case StepPhase::Step:              return "Step";
+        case StepPhase::WaitStep:          return "WaitStep";
+        case StepPhase::GetObservation:    return "GetObservation";
+        case StepPhase::UpdateObservation: return "UpdateObservation";
+        case StepPhase::IssueEvents:       return "IssueEvents";
+        case StepPhase::OnStep:            return "OnStep";
+        case StepPhase::SendActions:       return "SendActions";
+    }
+    return "Unknown";
+}
+
+StepPhaseStats::StepPhaseStats() :
+    count(0),
+    mean(0.0),
+    p50(0.0),
+    p90(0.0),
+    p99(0.0),
+    max(0.0) {
+}
+
+StepProfiler::StepProfiler(size_t window, size_t max_trace_events) :
+    window_(std::max<size_t>(window, 1)),
+    max_trace_events_(max_trace_events),
+    tracing_(false),
+    origin_(std::chrono::steady_clock::now()) {
+}
+
+void StepProfiler::SetTracing(bool value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tracing_ = value;
+}
+
+void StepProfiler::SetClientName(int client, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    client_names_[client] = name;
+}
+
+void StepProfiler::Record(int client, StepPhase phase, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    float duration_ms = std::chrono::duration<float, std::milli>(end - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Samples>& phases = clients_[client];
+    if (phases.empty()) {
+        phases.resize(StepPhaseCount);
+    }
+
+    Samples& samples = phases[static_cast<int>(phase)];
+    if (samples.durations.size() < window_) {
+        samples.durations.push_back(duration_ms);
+    }
+    else {
+        samples.durations[samples.next] = duration_ms;
+    }
+    samples.next = (samples.next + 1) % window_;
+    ++samples.count;
+
+    if (tracing_ && trace_events_.size() < max_trace_events_) {
+        TraceEvent event;
+        event.client = client;
+        event.phase = phase;
+        event.start_us = std::chrono::duration_cast<std::chrono::microseconds>(start - origin_).count();
+        event.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        trace_events_.push_back(event);
+    }
+}
+
+StepPhaseStats StepProfiler::GetStats(int client, StepPhase phase) const {
+    StepPhaseStats stats;
+    std::vector<float> durations;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = clients_.find(client);
+        if (found == clients_.end()) {
+            return stats;
+        }
+
+        const Samples& samples = found->second[static_cast<int>(phase)];
+        stats.count = samples.count;
+        durations = samples.durations;
+    }
+
+    if (durations.empty()) {
+        return stats;
+    }
+
+    std::sort(durations.begin(), durations.end());
+    auto percentile = [&durations](double p) {
+        size_t index = static_cast<size_t>(p * (durations.size() - 1) + 0.5);
+        return static_cast<double>(durations[index]);
+    };
+
+    double sum = 0.0;
+    for (float duration : durations) {
+        sum += duration;
+    }
+
+    stats.mean = sum / durations.size();
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.max = durations.back();
+    return stats;
+}
+
+std::vector<int> StepProfiler::GetClients() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> clients;
+    for (const auto& client : clients_) {
+        clients.push_back(client.first);
+    }
+
+    return clients;
+}
+
+static void WriteJsonString(std::ofstream& file, const std::string& value) {
+    file << '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            file << '\\';
+        }
+        file << c;
+    }
+    file << '"';
+}
+
+bool StepProfiler::WriteChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file << "{\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& name : client_names_) {
+        file << (first ? "\n" : ",\n");
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << name.first << ",\"args\":{\"name\":";
+        WriteJsonString(file, name.second);
+        file << "}}";
+        first = false;
+    }
+
+    for (const TraceEvent& event : trace_events_) {
+        file << (first ? "\n" : ",\n");
+        file << "{\"name\":\"" << StepPhaseToName(event.phase) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.client
+            << ",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us << "}";
+        first = false;
+    }
+
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+void StepProfiler::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.clear();
+    trace_events_.clear();
+}
+
+StepProfiler::Scope::Scope(StepProfiler* profiler, int client, StepPhase phase) :
+    profiler_(profiler),
+    client_(client),
+    phase_(phase) {
+    if (profiler_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+StepProfiler::Scope::~Scope() {
+    if (profiler_) {
+        profiler_->Record(client_, phase_, start_, std::chrono::steady_clock::now());
+    }
+}
+
+}
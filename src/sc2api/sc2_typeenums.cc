@@ -1,5 +1,7 @@
 #include "sc2api/sc2_typeenums.h"
 
+#include <cstring>
+
 namespace sc2 {
 
     const char* UnitTypeToName(UnitTypeID unit_type) {
@@ -684,6 +686,21 @@ namespace sc2 {
         return "UNKNOWN";
     };
 
+    bool IsQueueAbility(AbilityID ability_type) {
+        switch ((ABILITY_ID)ability_type) {
+        case ABILITY_ID::BUILD_INTERCEPTORS:
+        case ABILITY_ID::BUILD_NUKE:
+            return true;
+        default:
+            break;
+        }
+
+        // Training, warping in and research abilities are all named after what they do.
+        const char* name = AbilityTypeToName(ability_type);
+        return std::strncmp(name, "TRAIN_", 6) == 0 || std::strncmp(name, "TRAINWARP_", 10) == 0 ||
+            std::strncmp(name, "RESEARCH_", 9) == 0;
+    }
+
     const char* UpgradeIDToName(UpgradeID upgrade_id) {
         switch ((UPGRADE_ID)upgrade_id) {
         case UPGRADE_ID::CARRIERLAUNCHSPEEDUPGRADE:         return "CARRIERLAUNCHSPEEDUPGRADE";
@@ -0,0 +1,290 @@
+#include "sc2lib/sc2_action_scheduler.h"
+
+#include "sc2api/sc2_data.h"
+#include "sc2api/sc2_typeenums.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace sc2 {
+
+// Game loops per second at faster speed.
+static const float LoopsPerSecond = 22.4f;
+// Issue loop of a command no Flush has seen yet.
+static const uint32_t UnscheduledLoop = std::numeric_limits<uint32_t>::max();
+
+ActionScheduler::ActionScheduler() :
+    next_sequence_(0),
+    budget_(0.0f),
+    last_loop_(0),
+    started_(false) {
+}
+
+ActionScheduler::ActionScheduler(const ActionSchedulerParameters& parameters) :
+    parameters_(parameters),
+    next_sequence_(0),
+    budget_(0.0f),
+    last_loop_(0),
+    started_(false) {
+}
+
+void ActionScheduler::SetParameters(const ActionSchedulerParameters& parameters) {
+    parameters_ = parameters;
+}
+
+void ActionScheduler::UnitCommand(const Unit* unit, AbilityID ability, bool queued_command, ActionPriority priority) {
+    UnitCommand(Units{ unit }, ability, queued_command, priority);
+}
+
+void ActionScheduler::UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command, ActionPriority priority) {
+    UnitCommand(Units{ unit }, ability, point, queued_command, priority);
+}
+
+void ActionScheduler::UnitCommand(const Unit* unit, AbilityID ability, const Unit* target, bool queued_command, ActionPriority priority) {
+    UnitCommand(Units{ unit }, ability, target, queued_command, priority);
+}
+
+void ActionScheduler::UnitCommand(const Units& units, AbilityID ability, bool queued_command, ActionPriority priority) {
+    Add(units, ability, TargetType::None, Point2D(), NullTag, queued_command, priority);
+}
+
+void ActionScheduler::UnitCommand(const Units& units, AbilityID ability, const Point2D& point, bool queued_command, ActionPriority priority) {
+    Add(units, ability, TargetType::Position, point, NullTag, queued_command, priority);
+}
+
+void ActionScheduler::UnitCommand(const Units& units, AbilityID ability, const Unit* target, bool queued_command, ActionPriority priority) {
+    if (!target) {
+        return;
+    }
+
+    Add(units, ability, TargetType::Unit, Point2D(), target->tag, queued_command, priority);
+}
+
+void ActionScheduler::Add(const Units& units, AbilityID ability, TargetType target_type, const Point2D& point, Tag target_tag, bool queued, ActionPriority priority) {
+    Command command;
+    command.ability = ability;
+    command.target_type = target_type;
+    command.point = point;
+    command.target_tag = target_tag;
+    command.queued = queued;
+    command.priority = priority;
+    command.send_priority = priority;
+    command.issued_loop = UnscheduledLoop;
+    command.sequence = next_sequence_++;
+    for (const Unit* unit : units) {
+        if (unit) {
+            command.unit_tags.push_back(unit->tag);
+        }
+    }
+
+    if (command.unit_tags.empty()) {
+        return;
+    }
+    ++stats_.issued;
+
+    // A new order replaces whatever the units were waiting to do, a queued one goes after it. Training and research
+    // add to the queue of the building whether queued or not.
+    if (!queued && !IsQueueAbility(ability)) {
+        std::unordered_set<Tag> tags(command.unit_tags.begin(), command.unit_tags.end());
+        for (Command& waiting : pending_) {
+            waiting.unit_tags.erase(std::remove_if(waiting.unit_tags.begin(), waiting.unit_tags.end(), [&tags](Tag tag) {
+                return tags.count(tag) > 0;
+            }), waiting.unit_tags.end());
+        }
+
+        auto superseded = std::remove_if(pending_.begin(), pending_.end(), [](const Command& waiting) {
+            return waiting.unit_tags.empty();
+        });
+        stats_.superseded += std::distance(superseded, pending_.end());
+        pending_.erase(superseded, pending_.end());
+    }
+
+    pending_.push_back(std::move(command));
+}
+
+void ActionScheduler::Flush(const ObservationInterface* observation, ActionInterface* actions) {
+    if (!observation || !actions) {
+        return;
+    }
+
+    uint32_t game_loop = observation->GetGameLoop();
+    float capacity = parameters_.actions_per_minute_ / 60.0f * std::max(parameters_.burst_seconds_, 0.0f);
+    // One action is always allowed at a time, or a budget below one per burst would never send anything.
+    capacity = std::max(capacity, 1.0f);
+    if (!started_ || game_loop < last_loop_) {
+        budget_ = capacity;
+        started_ = true;
+    }
+    else {
+        budget_ += (game_loop - last_loop_) / LoopsPerSecond * parameters_.actions_per_minute_ / 60.0f;
+        budget_ = std::min(budget_, capacity);
+    }
+    last_loop_ = game_loop;
+
+    // Filter against the latest orders first, a redundant command shouldn't take budget from a useful one.
+    std::vector<Command> due;
+    due.swap(pending_);
+    for (Command& command : due) {
+        if (command.issued_loop == UnscheduledLoop) {
+            command.issued_loop = game_loop;
+        }
+
+        if (command.queued) {
+            continue;
+        }
+
+        command.unit_tags.erase(std::remove_if(command.unit_tags.begin(), command.unit_tags.end(), [&](Tag tag) {
+            const Unit* unit = observation->GetUnit(tag);
+            return unit && HasOrder(observation, *unit, command);
+        }), command.unit_tags.end());
+    }
+
+    auto redundant = std::remove_if(due.begin(), due.end(), [](const Command& command) {
+        return command.unit_tags.empty();
+    });
+    stats_.redundant += std::distance(redundant, due.end());
+    due.erase(redundant, due.end());
+
+    // Commands of a unit go out in the order they were issued, a queued command can't overtake the one before it. An
+    // earlier command of a unit is sent with the priority of its later ones, so it's never behind them, and a
+    // critical command never waits behind a deferred one. due is in issue order.
+    std::unordered_map<Tag, ActionPriority> later_priority;
+    for (auto command = due.rbegin(); command != due.rend(); ++command) {
+        command->send_priority = command->priority;
+        for (Tag tag : command->unit_tags) {
+            auto later = later_priority.find(tag);
+            if (later != later_priority.end()) {
+                command->send_priority = std::max(command->send_priority, later->second);
+            }
+        }
+        for (Tag tag : command->unit_tags) {
+            ActionPriority& priority = later_priority[tag];
+            priority = std::max(priority, command->send_priority);
+        }
+    }
+
+    std::stable_sort(due.begin(), due.end(), [](const Command& a, const Command& b) {
+        if (a.send_priority != b.send_priority) {
+            return a.send_priority > b.send_priority;
+        }
+        return a.sequence < b.sequence;
+    });
+
+    std::unordered_set<Tag> held;
+    bool unlimited = parameters_.actions_per_minute_ <= 0.0f;
+    for (Command& command : due) {
+        bool after_held = false;
+        for (Tag tag : command.unit_tags) {
+            if (held.count(tag) > 0) {
+                after_held = true;
+                break;
+            }
+        }
+
+        bool affordable = unlimited || budget_ >= 1.0f || command.send_priority == ActionPriority::Critical;
+        if (!after_held && affordable) {
+            Send(actions, observation, command);
+            budget_ -= unlimited ? 0.0f : 1.0f;
+            ++stats_.sent;
+            continue;
+        }
+
+        if (game_loop - command.issued_loop > parameters_.max_defer_loops_) {
+            ++stats_.expired;
+            continue;
+        }
+
+        ++stats_.deferred;
+        held.insert(command.unit_tags.begin(), command.unit_tags.end());
+        pending_.push_back(std::move(command));
+    }
+
+    std::sort(pending_.begin(), pending_.end(), [](const Command& a, const Command& b) {
+        return a.sequence < b.sequence;
+    });
+}
+
+void ActionScheduler::Clear() {
+    pending_.clear();
+    budget_ = 0.0f;
+    last_loop_ = 0;
+    started_ = false;
+}
+
+bool ActionScheduler::SameAbility(const ObservationInterface* observation, AbilityID order, AbilityID command) const {
+    if (order == command) {
+        return true;
+    }
+
+    // Orders report the specific ability, commands are often given with the general one, e.g. ATTACK for
+    // ATTACK_ATTACK.
+    const Abilities& abilities = observation->GetAbilityData();
+    auto general = [&abilities](AbilityID ability) -> uint32_t {
+        uint32_t id = static_cast<uint32_t>(ability);
+        if (id < abilities.size() && abilities[id].remaps_to_ability_id != 0) {
+            return abilities[id].remaps_to_ability_id;
+        }
+        return id;
+    };
+
+    return general(order) == general(command);
+}
+
+bool ActionScheduler::HasOrder(const ObservationInterface* observation, const Unit& unit, const Command& command) const {
+    // Training the same unit again adds another one, it's never the order the building already has. A command that
+    // isn't queued also clears the orders queued after the current one, so it's only redundant if there are none.
+    if (unit.orders.size() != 1 || IsQueueAbility(command.ability)) {
+        return false;
+    }
+
+    const UnitOrder& order = unit.orders.front();
+    if (!SameAbility(observation, order.ability_id, command.ability)) {
+        return false;
+    }
+
+    switch (command.target_type) {
+        case TargetType::None:
+            return order.target_unit_tag == NullTag;
+        case TargetType::Position:
+            return order.target_unit_tag == NullTag &&
+                DistanceSquared2D(order.target_pos, command.point) <= parameters_.target_tolerance_ * parameters_.target_tolerance_;
+        case TargetType::Unit:
+            return order.target_unit_tag == command.target_tag;
+    }
+
+    return false;
+}
+
+void ActionScheduler::Send(ActionInterface* actions, const ObservationInterface* observation, const Command& command) const {
+    Units units;
+    for (Tag tag : command.unit_tags) {
+        const Unit* unit = observation->GetUnit(tag);
+        if (unit) {
+            units.push_back(unit);
+        }
+    }
+
+    if (units.empty()) {
+        return;
+    }
+
+    switch (command.target_type) {
+        case TargetType::None:
+            actions->UnitCommand(units, command.ability, command.queued);
+            break;
+        case TargetType::Position:
+            actions->UnitCommand(units, command.ability, command.point, command.queued);
+            break;
+        case TargetType::Unit: {
+            const Unit* target = observation->GetUnit(command.target_tag);
+            if (target) {
+                actions->UnitCommand(units, command.ability, target, command.queued);
+            }
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,162 @@
+#include "sc2lib/sc2_coordinate_transform.h"
+
+#include <algorithm>
+
+namespace sc2 {
+
+// Same as int(std::floor(value)) for values in range of an int, without the call std::floor compiles to where
+// SSE4.1 isn't available.
+static inline int FloorToInt(float value) {
+    int truncated = int(value);
+    return truncated - (float(truncated) > value ? 1 : 0);
+}
+
+CoordinateTransform::CoordinateTransform() :
+    camera_width_(0.0f) {
+    for (Mapping& mapping : mappings_) {
+        mapping = Mapping{ 0.0f, 0.0f, 1.0f, 0, 0 };
+    }
+}
+
+CoordinateTransform::CoordinateTransform(const GameInfo& game_info, const Point2D& camera) :
+    CoordinateTransform() {
+    camera_ = camera;
+    SetGameInfo(game_info);
+}
+
+CoordinateTransform::Mapping CoordinateTransform::MakeMinimapMapping(const GameInfo& game_info, int width, int height) {
+    Mapping mapping{ 0.0f, 0.0f, 1.0f, 0, 0 };
+    if (width <= 0 || height <= 0) {
+        return mapping;
+    }
+
+    // The scale is determined by the largest axis of the map. The upper left corner of the map corresponds to the
+    // upper left corner of the upper left pixel.
+    mapping.pixel_size = std::max(float(game_info.width) / float(width), float(game_info.height) / float(height));
+    mapping.origin_x = 0.0f;
+    mapping.origin_y = float(game_info.height);
+    mapping.width = width;
+    mapping.height = height;
+    return mapping;
+}
+
+void CoordinateTransform::SetGameInfo(const GameInfo& game_info) {
+    const SpatialSetup& feature_layer = game_info.options.feature_layer;
+    const SpatialSetup& render = game_info.options.render;
+
+    Mapping& map = mappings_[int(Space::FeatureMap)];
+    camera_width_ = feature_layer.camera_width;
+    if (feature_layer.map_resolution_x > 0 && feature_layer.map_resolution_y > 0 && camera_width_ > 0.0f) {
+        // The scale is determined by making the shortest axis of the camera match camera_width.
+        map.pixel_size = camera_width_ / float(std::min(feature_layer.map_resolution_x, feature_layer.map_resolution_y));
+        map.width = feature_layer.map_resolution_x;
+        map.height = feature_layer.map_resolution_y;
+    }
+    else {
+        map = Mapping{ 0.0f, 0.0f, 1.0f, 0, 0 };
+    }
+    SetCamera(camera_);
+
+    mappings_[int(Space::FeatureMinimap)] = MakeMinimapMapping(game_info, feature_layer.minimap_resolution_x, feature_layer.minimap_resolution_y);
+    mappings_[int(Space::RenderMinimap)] = MakeMinimapMapping(game_info, render.minimap_resolution_x, render.minimap_resolution_y);
+}
+
+void CoordinateTransform::SetCamera(const Point2D& camera) {
+    camera_ = camera;
+
+    // The feature layer is centered around the camera target position.
+    Mapping& map = mappings_[int(Space::FeatureMap)];
+    map.origin_x = camera.x - map.pixel_size * float(map.width) / 2.0f;
+    map.origin_y = camera.y + map.pixel_size * float(map.height) / 2.0f;
+}
+
+Point2DI CoordinateTransform::GetResolution(Space space) const {
+    return Point2DI(Get(space).width, Get(space).height);
+}
+
+float CoordinateTransform::GetPixelSize(Space space) const {
+    return Get(space).pixel_size;
+}
+
+bool CoordinateTransform::IsInBounds(Space space, const Point2DI& pixel) const {
+    const Mapping& mapping = Get(space);
+    return pixel.x >= 0 && pixel.y >= 0 && pixel.x < mapping.width && pixel.y < mapping.height;
+}
+
+Point2DI CoordinateTransform::WorldToPixel(Space space, const Point2D& world) const {
+    // Divides rather than multiplying by the inverse, which can land on the other side of a pixel edge.
+    const Mapping& mapping = Get(space);
+    return Point2DI(
+        FloorToInt((world.x - mapping.origin_x) / mapping.pixel_size),
+        FloorToInt((mapping.origin_y - world.y) / mapping.pixel_size));
+}
+
+Point2D CoordinateTransform::PixelToWorld(Space space, const Point2DI& pixel) const {
+    const Mapping& mapping = Get(space);
+    return Point2D(
+        mapping.origin_x + (float(pixel.x) + 0.5f) * mapping.pixel_size,
+        mapping.origin_y - (float(pixel.y) + 0.5f) * mapping.pixel_size);
+}
+
+Point2DI CoordinateTransform::PixelToPixel(Space from, const Point2DI& pixel, Space to) const {
+    return WorldToPixel(to, PixelToWorld(from, pixel));
+}
+
+// The batched versions copy the mapping into locals and keep the loop bodies to arithmetic and conversions, so
+// compilers can vectorize them with plain SSE2. They use the same arithmetic as the single point versions, so the
+// results match exactly.
+
+void CoordinateTransform::WorldToPixel(Space space, const std::vector<Point2D>& world, std::vector<Point2DI>& pixels) const {
+    const float origin_x = Get(space).origin_x;
+    const float origin_y = Get(space).origin_y;
+    const float pixel_size = Get(space).pixel_size;
+    const size_t count = world.size();
+
+    pixels.resize(count);
+    const Point2D* in = world.data();
+    Point2DI* out = pixels.data();
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = FloorToInt((in[i].x - origin_x) / pixel_size);
+        out[i].y = FloorToInt((origin_y - in[i].y) / pixel_size);
+    }
+}
+
+void CoordinateTransform::PixelToWorld(Space space, const std::vector<Point2DI>& pixels, std::vector<Point2D>& world) const {
+    const float origin_x = Get(space).origin_x;
+    const float origin_y = Get(space).origin_y;
+    const float pixel_size = Get(space).pixel_size;
+    const size_t count = pixels.size();
+
+    world.resize(count);
+    const Point2DI* in = pixels.data();
+    Point2D* out = world.data();
+    for (size_t i = 0; i < count; ++i) {
+        out[i].x = origin_x + (float(in[i].x) + 0.5f) * pixel_size;
+        out[i].y = origin_y - (float(in[i].y) + 0.5f) * pixel_size;
+    }
+}
+
+void CoordinateTransform::PixelToPixel(Space from, const std::vector<Point2DI>& pixels, Space to, std::vector<Point2DI>& result) const {
+    const Mapping& source = Get(from);
+    const Mapping& target = Get(to);
+    const float source_x = source.origin_x;
+    const float source_y = source.origin_y;
+    const float source_size = source.pixel_size;
+    const float target_x = target.origin_x;
+    const float target_y = target.origin_y;
+    const float target_size = target.pixel_size;
+    const size_t count = pixels.size();
+
+    result.resize(count);
+    const Point2DI* in = pixels.data();
+    Point2DI* out = result.data();
+    for (size_t i = 0; i < count; ++i) {
+        // Same arithmetic as PixelToWorld then WorldToPixel so the results match the single point versions exactly.
+        float world_x = source_x + (float(in[i].x) + 0.5f) * source_size;
+        float world_y = source_y - (float(in[i].y) + 0.5f) * source_size;
+        out[i].x = FloorToInt((world_x - target_x) / target_size);
+        out[i].y = FloorToInt((target_y - world_y) / target_size);
+    }
+}
+
+}
@@ -0,0 +1,181 @@
+#include "sc2lib/sc2_influence_map.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sc2 {
+
+InfluenceMap::InfluenceMap() :
+    width_(0),
+    height_(0),
+    update_count_(0) {
+}
+
+InfluenceMap::InfluenceMap(const InfluenceParameters& parameters) :
+    parameters_(parameters),
+    width_(0),
+    height_(0),
+    update_count_(0) {
+}
+
+void InfluenceMap::Reset(const GameInfo& game_info) {
+    Reset(game_info.width, game_info.height);
+}
+
+void InfluenceMap::Reset(int width, int height) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    for (std::vector<float>& layer : layers_) {
+        layer.assign(size_t(width_) * size_t(height_), 0.0f);
+    }
+    stamps_.clear();
+}
+
+bool InfluenceMap::MakeStamp(const Unit& unit, const UnitTypes& unit_types, Stamp& stamp) const {
+    if (unit.unit_type >= unit_types.size() || unit.build_progress < 1.0f) {
+        return false;
+    }
+
+    stamp.pos = unit.pos;
+    stamp.ground_dps = 0.0f;
+    stamp.ground_range = 0.0f;
+    stamp.air_dps = 0.0f;
+    stamp.air_range = 0.0f;
+    stamp.last_update = update_count_;
+
+    // With several weapons hitting the same layer only the strongest one is counted, a unit fires one at a time.
+    for (const Weapon& weapon : unit_types[unit.unit_type].weapons) {
+        if (weapon.speed <= 0.0f) {
+            continue;
+        }
+
+        float dps = weapon.damage_ * float(weapon.attacks) / weapon.speed;
+        float range = weapon.range + unit.radius + parameters_.range_buffer_;
+        if (weapon.type == Weapon::TargetType::Ground || weapon.type == Weapon::TargetType::Any) {
+            stamp.ground_dps = std::max(stamp.ground_dps, dps);
+            stamp.ground_range = std::max(stamp.ground_range, range);
+        }
+        if (weapon.type == Weapon::TargetType::Air || weapon.type == Weapon::TargetType::Any) {
+            stamp.air_dps = std::max(stamp.air_dps, dps);
+            stamp.air_range = std::max(stamp.air_range, range);
+        }
+    }
+
+    return stamp.ground_dps > 0.0f || stamp.air_dps > 0.0f;
+}
+
+bool InfluenceMap::NeedsRestamp(const Stamp& previous, const Stamp& next) const {
+    return DistanceSquared2D(previous.pos, next.pos) >= parameters_.move_threshold_ * parameters_.move_threshold_ ||
+        previous.ground_dps != next.ground_dps || previous.ground_range != next.ground_range ||
+        previous.air_dps != next.air_dps || previous.air_range != next.air_range;
+}
+
+void InfluenceMap::ApplyKernel(std::vector<float>& layer, const Point2D& center, float range, float value) {
+    if (value == 0.0f || layer.empty()) {
+        return;
+    }
+
+    const float outer = range + parameters_.falloff_;
+    const float inverse_falloff = parameters_.falloff_ > 0.0f ? 1.0f / parameters_.falloff_ : 1.0e6f;
+    const int min_x = std::max(0, int(std::floor(center.x - outer)));
+    const int max_x = std::min(width_ - 1, int(std::ceil(center.x + outer)));
+    const int min_y = std::max(0, int(std::floor(center.y - outer)));
+    const int max_y = std::min(height_ - 1, int(std::ceil(center.y + outer)));
+    const float center_x = center.x;
+    const float center_y = center.y;
+
+    for (int y = min_y; y <= max_y; ++y) {
+        const float dy = float(y) + 0.5f - center_y;
+        const float dy_squared = dy * dy;
+        float* row = layer.data() + size_t(y) * size_t(width_);
+
+        // Kept free of branches and of loads through center so the compiler can vectorize it.
+        for (int x = min_x; x <= max_x; ++x) {
+            const float dx = float(x) + 0.5f - center_x;
+            float weight = (outer - std::sqrt(dx * dx + dy_squared)) * inverse_falloff;
+            weight = weight < 0.0f ? 0.0f : weight;
+            weight = weight > 1.0f ? 1.0f : weight;
+            row[x] += value * weight;
+        }
+    }
+}
+
+void InfluenceMap::Apply(const Stamp& stamp, float sign) {
+    ApplyKernel(layers_[int(Layer::Ground)], stamp.pos, stamp.ground_range, sign * stamp.ground_dps);
+    ApplyKernel(layers_[int(Layer::Air)], stamp.pos, stamp.air_range, sign * stamp.air_dps);
+}
+
+bool InfluenceMap::AddUnit(const Unit& unit, const UnitTypes& unit_types) {
+    Stamp stamp;
+    if (!MakeStamp(unit, unit_types, stamp)) {
+        RemoveUnit(unit.tag);
+        return false;
+    }
+
+    auto found = stamps_.find(unit.tag);
+    if (found == stamps_.end()) {
+        Apply(stamp, 1.0f);
+        stamps_[unit.tag] = stamp;
+        return true;
+    }
+
+    found->second.last_update = stamp.last_update;
+    if (NeedsRestamp(found->second, stamp)) {
+        Apply(found->second, -1.0f);
+        Apply(stamp, 1.0f);
+        found->second = stamp;
+    }
+    return true;
+}
+
+void InfluenceMap::RemoveUnit(Tag tag) {
+    auto found = stamps_.find(tag);
+    if (found == stamps_.end()) {
+        return;
+    }
+
+    Apply(found->second, -1.0f);
+    stamps_.erase(found);
+}
+
+void InfluenceMap::Update(const Units& units, const UnitTypes& unit_types) {
+    ++update_count_;
+    for (const Unit* unit : units) {
+        AddUnit(*unit, unit_types);
+    }
+
+    for (auto it = stamps_.begin(); it != stamps_.end();) {
+        if (it->second.last_update != update_count_) {
+            Apply(it->second, -1.0f);
+            it = stamps_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void InfluenceMap::Rebuild() {
+    for (std::vector<float>& layer : layers_) {
+        std::fill(layer.begin(), layer.end(), 0.0f);
+    }
+    for (const auto& stamp : stamps_) {
+        Apply(stamp.second, 1.0f);
+    }
+}
+
+float InfluenceMap::GetValue(Layer layer, const Point2D& point) const {
+    int x = int(point.x);
+    int y = int(point.y);
+    if (point.x < 0.0f || point.y < 0.0f || x >= width_ || y >= height_) {
+        return 0.0f;
+    }
+
+    return layers_[int(layer)][x + y * width_];
+}
+
+const std::vector<float>& InfluenceMap::GetLayer(Layer layer) const {
+    return layers_[int(layer)];
+}
+
+}
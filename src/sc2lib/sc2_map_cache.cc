@@ -0,0 +1,265 @@
+#include "sc2lib/sc2_map_cache.h"
+#include "sc2lib/sc2_utils.h"
+#include "sc2api/sc2_map_info.h"
+#include "sc2utils/sc2_simple_serialization.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace sc2 {
+
+static const uint32_t MapCacheFileMagic = 0x4D524353; // "SCRM"
+static const uint32_t MapCacheFileVersion = 2;
+
+MapStaticData::MapStaticData() :
+    grid_hash(0) {
+}
+
+float MapStaticData::GetExpansionDistance(size_t a, size_t b) const {
+    size_t count = expansion_locations.size();
+    if (a >= count || b >= count || expansion_distances.size() != count * count) {
+        return 0.0f;
+    }
+
+    return expansion_distances[a * count + b];
+}
+
+static uint64_t GetMapCacheKey(const GameInfo& game_info) {
+    // The grids identify the map version, the path tells apart local copies of a map with the same name.
+    uint64_t key = HashGameInfoGrids(game_info);
+    for (char c : game_info.local_map_path) {
+        key ^= static_cast<unsigned char>(c);
+        key *= 1099511628211ULL;
+    }
+    return key;
+}
+
+std::string GetMapStaticDataPath(const GameInfo& game_info, const MapCacheParameters& parameters) {
+    return GetMapCachePath(parameters.cache_directory_, game_info.map_name, GetMapCacheKey(game_info), ".mapcache");
+}
+
+// The data depends on what was asked for as well as on the map, so the file records the parameters it was worked out
+// with and is only used for the same ones.
+static void WriteParameters(std::ofstream& file, const MapCacheParameters& parameters) {
+    WriteBinary(file, parameters.expansion_parameters_.radiuses_);
+    WriteBinary(file, parameters.expansion_parameters_.circle_step_size_);
+    WriteBinary(file, parameters.expansion_parameters_.cluster_distance_);
+    WriteBinary(file, static_cast<uint8_t>(parameters.calculate_distances_ ? 1 : 0));
+}
+
+static bool ReadParameters(std::ifstream& file, const MapCacheParameters& parameters) {
+    search::ExpansionParameters stored;
+    uint8_t calculate_distances = 0;
+    if (!ReadBinary(file, stored.radiuses_) ||
+        !ReadBinary(file, stored.circle_step_size_) ||
+        !ReadBinary(file, stored.cluster_distance_) ||
+        !ReadBinary(file, calculate_distances)) {
+        return false;
+    }
+
+    const search::ExpansionParameters& expected = parameters.expansion_parameters_;
+    return stored.radiuses_ == expected.radiuses_ &&
+        stored.circle_step_size_ == expected.circle_step_size_ &&
+        stored.cluster_distance_ == expected.cluster_distance_ &&
+        (calculate_distances != 0) == parameters.calculate_distances_;
+}
+
+bool SaveMapStaticData(const std::string& path, const MapStaticData& data, const MapCacheParameters& parameters) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    WriteBinary(file, MapCacheFileMagic);
+    WriteBinary(file, MapCacheFileVersion);
+    WriteParameters(file, parameters);
+    WriteBinary(file, data.map_name);
+    WriteBinary(file, data.local_map_path);
+    WriteBinary(file, data.grid_hash);
+    WriteBinary(file, data.start_locations);
+
+    WriteBinary(file, static_cast<uint32_t>(data.resource_clusters.size()));
+    for (const ResourceCluster& cluster : data.resource_clusters) {
+        WriteBinary(file, cluster.center);
+        WriteBinary(file, cluster.minerals);
+        WriteBinary(file, cluster.geysers);
+    }
+
+    WriteBinary(file, data.expansion_locations);
+    WriteBinary(file, data.expansion_distances);
+    return file.good();
+}
+
+bool LoadMapStaticData(const std::string& path, MapStaticData& data, const MapCacheParameters& parameters) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!ReadBinary(file, magic) || magic != MapCacheFileMagic ||
+        !ReadBinary(file, version) || version != MapCacheFileVersion ||
+        !ReadParameters(file, parameters)) {
+        return false;
+    }
+
+    MapStaticData result;
+    uint32_t cluster_count = 0;
+    if (!ReadBinary(file, result.map_name) ||
+        !ReadBinary(file, result.local_map_path) ||
+        !ReadBinary(file, result.grid_hash) ||
+        !ReadBinary(file, result.start_locations) ||
+        !ReadBinary(file, cluster_count) ||
+        cluster_count > MaxBinaryElements) {
+        return false;
+    }
+
+    result.resource_clusters.resize(cluster_count);
+    for (ResourceCluster& cluster : result.resource_clusters) {
+        if (!ReadBinary(file, cluster.center) ||
+            !ReadBinary(file, cluster.minerals) ||
+            !ReadBinary(file, cluster.geysers)) {
+            return false;
+        }
+    }
+
+    if (!ReadBinary(file, result.expansion_locations) || !ReadBinary(file, result.expansion_distances)) {
+        return false;
+    }
+
+    data = std::move(result);
+    return true;
+}
+
+static bool IsGeyser(const Unit& unit) {
+    return unit.unit_type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER || unit.unit_type == UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER;
+}
+
+static bool ComparePoints(const Point2D& a, const Point2D& b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+MapStaticData GetMapStaticData(const ObservationInterface* observation, QueryInterface* query, const MapCacheParameters& parameters) {
+    const GameInfo& game_info = observation->GetGameInfo();
+
+    MapStaticData data;
+    data.map_name = game_info.map_name;
+    data.local_map_path = game_info.local_map_path;
+    data.grid_hash = HashGameInfoGrids(game_info);
+
+    std::string cache_path;
+    if (parameters.use_cache_) {
+        cache_path = GetMapStaticDataPath(game_info, parameters);
+        MapStaticData cached;
+        if (LoadMapStaticData(cache_path, cached, parameters) &&
+            cached.grid_hash == data.grid_hash &&
+            cached.map_name == data.map_name &&
+            cached.local_map_path == data.local_map_path) {
+            return cached;
+        }
+    }
+
+    // GameInfo only lists our own start location in start_locations once the game has started.
+    data.start_locations = game_info.enemy_start_locations;
+    for (const Point2D& start : game_info.start_locations) {
+        data.start_locations.push_back(start);
+    }
+    std::sort(data.start_locations.begin(), data.start_locations.end(), ComparePoints);
+
+    // CalculateExpansionLocations clusters the same units in the same order, so its results line up with these.
+    Units resources = observation->GetUnits(search::IsResource);
+    std::vector<std::pair<Point3D, Units> > clusters = search::Cluster(resources, parameters.expansion_parameters_.cluster_distance_);
+    for (const auto& cluster : clusters) {
+        ResourceCluster resource_cluster;
+        resource_cluster.center = cluster.first;
+        for (const Unit* unit : cluster.second) {
+            if (IsGeyser(*unit)) {
+                resource_cluster.geysers.push_back(unit->pos);
+            }
+            else {
+                resource_cluster.minerals.push_back(unit->pos);
+            }
+        }
+        data.resource_clusters.push_back(resource_cluster);
+    }
+
+    data.expansion_locations = search::CalculateExpansionLocations(observation, query, parameters.expansion_parameters_);
+
+    if (parameters.calculate_distances_ && !data.expansion_locations.empty()) {
+        // Query each unordered pair once and mirror the result.
+        size_t count = data.expansion_locations.size();
+        std::vector<QueryInterface::PathingQuery> queries;
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t j = i + 1; j < count; ++j) {
+                QueryInterface::PathingQuery pathing_query;
+                pathing_query.start_ = data.expansion_locations[i];
+                pathing_query.end_ = data.expansion_locations[j];
+                queries.push_back(pathing_query);
+            }
+        }
+
+        std::vector<float> distances = query->PathingDistance(queries);
+        if (distances.size() == queries.size()) {
+            data.expansion_distances.assign(count * count, 0.0f);
+            size_t index = 0;
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t j = i + 1; j < count; ++j) {
+                    data.expansion_distances[i * count + j] = distances[index];
+                    data.expansion_distances[j * count + i] = distances[index];
+                    ++index;
+                }
+            }
+        }
+    }
+
+    if (parameters.use_cache_ && !SaveMapStaticData(cache_path, data, parameters)) {
+        std::cerr << "GetMapStaticData: could not write cache file " << cache_path << std::endl;
+    }
+
+    return data;
+}
+
+MapAnalysisCache::MapAnalysisCache(const MapCacheParameters& map_parameters, const terrain::TerrainParameters& terrain_parameters) :
+    map_parameters_(map_parameters),
+    terrain_parameters_(terrain_parameters) {
+}
+
+template<typename T>
+std::shared_ptr<MapAnalysisCache::Entry<T> > MapAnalysisCache::FindOrAddEntry(std::mutex& mutex, std::unordered_map<uint64_t, std::shared_ptr<Entry<T> > >& entries, uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Entry<T> >& entry = entries[key];
+    if (!entry) {
+        entry = std::make_shared<Entry<T> >();
+    }
+    return entry;
+}
+
+std::shared_ptr<const MapStaticData> MapAnalysisCache::GetMapStaticData(const ObservationInterface* observation, QueryInterface* query) {
+    std::shared_ptr<Entry<MapStaticData> > entry = FindOrAddEntry(mutex_, map_data_, GetMapCacheKey(observation->GetGameInfo()));
+
+    // Only the entry is locked while the data is worked out, games on other maps don't wait for it.
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (!entry->data) {
+        entry->data = std::make_shared<MapStaticData>(sc2::GetMapStaticData(observation, query, map_parameters_));
+    }
+    return entry->data;
+}
+
+std::shared_ptr<const terrain::TerrainAnalysis> MapAnalysisCache::GetTerrainAnalysis(const GameInfo& game_info) {
+    std::shared_ptr<Entry<terrain::TerrainAnalysis> > entry = FindOrAddEntry(mutex_, terrain_analyses_, GetMapCacheKey(game_info));
+
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (!entry->data) {
+        entry->data = std::make_shared<terrain::TerrainAnalysis>(terrain::AnalyzeTerrain(game_info, terrain_parameters_));
+    }
+    return entry->data;
+}
+
+void MapAnalysisCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    map_data_.clear();
+    terrain_analyses_.clear();
+}
+
+}
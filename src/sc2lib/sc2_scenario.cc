@@ -0,0 +1,309 @@
+#include "sc2lib/sc2_scenario.h"
+
+#include "sc2api/sc2_typeenums.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace sc2 {
+
+// Unit type ids are below this, names are looked up by trying each.
+static const uint32_t MaxUnitTypeId = 4096;
+
+ScenarioUnit::ScenarioUnit() :
+    unit_type(UNIT_TYPEID::INVALID),
+    player_id(1),
+    count(1),
+    life(-1.0f),
+    energy(-1.0f),
+    shields(-1.0f) {
+}
+
+Scenario::Scenario() :
+    kill_existing(false),
+    give_all_upgrades(false),
+    give_all_tech(false),
+    show_map(false) {
+}
+
+static bool ParseUnitType(const std::string& value, UnitTypeID& unit_type) {
+    char* end = nullptr;
+    unsigned long id = std::strtoul(value.c_str(), &end, 10);
+    if (!value.empty() && *end == '\0') {
+        unit_type = static_cast<uint32_t>(id);
+        return true;
+    }
+
+    static const std::unordered_map<std::string, uint32_t> ids_by_name = []() {
+        std::unordered_map<std::string, uint32_t> ids;
+        for (uint32_t i = 1; i < MaxUnitTypeId; ++i) {
+            ids.emplace(UnitTypeToName(i), i);
+        }
+        ids.erase("UNKNOWN");
+        return ids;
+    }();
+
+    auto found = ids_by_name.find(value);
+    if (found == ids_by_name.end()) {
+        return false;
+    }
+
+    unit_type = found->second;
+    return true;
+}
+
+static bool ParseNumber(const std::string& value, float& number) {
+    char* end = nullptr;
+    number = std::strtof(value.c_str(), &end);
+    return !value.empty() && *end == '\0';
+}
+
+static bool ParseUnit(std::istringstream& line, ScenarioUnit& unit) {
+    std::string type;
+    std::string x;
+    std::string y;
+    if (!(line >> type >> x >> y) || !ParseUnitType(type, unit.unit_type) ||
+        !ParseNumber(x, unit.pos.x) || !ParseNumber(y, unit.pos.y)) {
+        return false;
+    }
+
+    std::string option;
+    while (line >> option) {
+        size_t equals = option.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+
+        std::string name = option.substr(0, equals);
+        float value = 0.0f;
+        if (!ParseNumber(option.substr(equals + 1), value)) {
+            return false;
+        }
+
+        if (name == "player" && value >= 0.0f) {
+            unit.player_id = static_cast<uint32_t>(value);
+        }
+        else if (name == "count" && value >= 1.0f) {
+            unit.count = static_cast<uint32_t>(value);
+        }
+        else if (name == "life") {
+            unit.life = value;
+        }
+        else if (name == "energy") {
+            unit.energy = value;
+        }
+        else if (name == "shields") {
+            unit.shields = value;
+        }
+        else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParseScenario(const std::string& text, Scenario& scenario, std::string* error) {
+    Scenario result;
+    std::istringstream input(text);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        std::istringstream statement(line);
+        std::string keyword;
+        if (!(statement >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+
+        bool valid = true;
+        if (keyword == "unit") {
+            ScenarioUnit unit;
+            valid = ParseUnit(statement, unit);
+            result.units.push_back(unit);
+        }
+        else if (keyword == "kill_existing") {
+            result.kill_existing = true;
+        }
+        else if (keyword == "upgrades") {
+            result.give_all_upgrades = true;
+        }
+        else if (keyword == "tech") {
+            result.give_all_tech = true;
+        }
+        else if (keyword == "show_map") {
+            result.show_map = true;
+        }
+        else {
+            valid = false;
+        }
+
+        if (!valid) {
+            if (error) {
+                *error = "line " + std::to_string(line_number) + ": " + line;
+            }
+            return false;
+        }
+    }
+
+    scenario = result;
+    return true;
+}
+
+bool LoadScenarioFile(const std::string& path, Scenario& scenario) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "LoadScenarioFile: could not open " << path << std::endl;
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::string error;
+    if (!ParseScenario(text.str(), scenario, &error)) {
+        std::cerr << "LoadScenarioFile: " << path << " " << error << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+ScenarioLoader::ScenarioLoader(uint32_t timeout_loops) :
+    timeout_loops_(timeout_loops),
+    state_(State::Idle),
+    start_loop_(0) {
+}
+
+void ScenarioLoader::Start(const Scenario& scenario, const ObservationInterface* observation, DebugInterface* debug) {
+    scenario_ = scenario;
+    start_loop_ = observation->GetGameLoop();
+    existing_tags_.clear();
+    unit_tags_.clear();
+
+    for (const Unit* unit : observation->GetUnits()) {
+        existing_tags_.push_back(unit->tag);
+        if (scenario.kill_existing && unit->alliance != Unit::Alliance::Neutral) {
+            debug->DebugKillUnit(unit);
+            for (const PassengerUnit& passenger : unit->passengers) {
+                debug->DebugKillUnit(observation->GetUnit(passenger.tag));
+            }
+        }
+    }
+    std::sort(existing_tags_.begin(), existing_tags_.end());
+
+    if (scenario.give_all_upgrades) {
+        debug->DebugGiveAllUpgrades();
+    }
+    if (scenario.give_all_tech) {
+        debug->DebugGiveAllTech();
+    }
+    if (scenario.show_map) {
+        debug->DebugShowMap();
+    }
+
+    // One create command for all the units of a type and owner at the same position.
+    std::vector<ScenarioUnit> creates;
+    for (const ScenarioUnit& unit : scenario.units) {
+        auto same = std::find_if(creates.begin(), creates.end(), [&unit](const ScenarioUnit& create) {
+            return create.unit_type == unit.unit_type && create.player_id == unit.player_id &&
+                create.pos.x == unit.pos.x && create.pos.y == unit.pos.y;
+        });
+
+        if (same != creates.end()) {
+            same->count += unit.count;
+        }
+        else {
+            creates.push_back(unit);
+        }
+    }
+
+    for (const ScenarioUnit& create : creates) {
+        debug->DebugCreateUnit(create.unit_type, create.pos, create.player_id, create.count);
+    }
+
+    debug->SendDebug();
+    state_ = State::Spawning;
+}
+
+bool ScenarioLoader::AssignUnits(const ObservationInterface* observation, std::vector<std::vector<const Unit*>>& assigned) const {
+    Units created = observation->GetUnits([this](const Unit& unit) {
+        return !std::binary_search(existing_tags_.begin(), existing_tags_.end(), unit.tag);
+    });
+
+    // Each scenario unit takes the closest of the new units of its type and owner.
+    assigned.assign(scenario_.units.size(), std::vector<const Unit*>());
+    std::vector<bool> taken(created.size(), false);
+    for (size_t i = 0; i < scenario_.units.size(); ++i) {
+        const ScenarioUnit& unit = scenario_.units[i];
+        std::vector<size_t> candidates;
+        for (size_t j = 0; j < created.size(); ++j) {
+            if (!taken[j] && created[j]->unit_type == unit.unit_type && created[j]->owner == static_cast<int>(unit.player_id)) {
+                candidates.push_back(j);
+            }
+        }
+
+        if (candidates.size() < unit.count) {
+            return false;
+        }
+
+        std::partial_sort(candidates.begin(), candidates.begin() + unit.count, candidates.end(), [&](size_t a, size_t b) {
+            return DistanceSquared2D(created[a]->pos, unit.pos) < DistanceSquared2D(created[b]->pos, unit.pos);
+        });
+
+        for (uint32_t k = 0; k < unit.count; ++k) {
+            taken[candidates[k]] = true;
+            assigned[i].push_back(created[candidates[k]]);
+        }
+    }
+
+    return true;
+}
+
+ScenarioLoader::State ScenarioLoader::Update(const ObservationInterface* observation, DebugInterface* debug) {
+    if (state_ != State::Spawning) {
+        return state_;
+    }
+
+    std::vector<std::vector<const Unit*>> assigned;
+    if (!AssignUnits(observation, assigned)) {
+        if (observation->GetGameLoop() - start_loop_ > timeout_loops_) {
+            std::cerr << "ScenarioLoader: not all units appeared within " << timeout_loops_ << " game loops." << std::endl;
+            state_ = State::Failed;
+        }
+        return state_;
+    }
+
+    bool has_values = false;
+    for (size_t i = 0; i < assigned.size(); ++i) {
+        const ScenarioUnit& unit = scenario_.units[i];
+        for (const Unit* created : assigned[i]) {
+            unit_tags_.push_back(created->tag);
+            if (unit.life >= 0.0f) {
+                debug->DebugSetLife(unit.life, created);
+                has_values = true;
+            }
+            if (unit.energy >= 0.0f) {
+                debug->DebugSetEnergy(unit.energy, created);
+                has_values = true;
+            }
+            if (unit.shields >= 0.0f) {
+                debug->DebugSetShields(unit.shields, created);
+                has_values = true;
+            }
+        }
+    }
+
+    if (has_values) {
+        debug->SendDebug();
+    }
+
+    state_ = State::Done;
+    return state_;
+}
+
+}
@@ -1,5 +1,9 @@
 #include "sc2lib/sc2_search.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace sc2 {
 
 namespace search {
@@ -32,55 +36,240 @@ size_t CalculateQueries(float radius, float step_size, const Point2D& center, st
     return valid_queries;
 }
 
-std::vector<std::pair<Point3D, std::vector<Unit> > > Cluster(const Units& units, float distance_apart) {
+bool IsResource(const Unit& unit) {
+    return unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750 ||
+        unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD || unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750 ||
+        unit.unit_type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER || unit.unit_type == UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER;
+}
+
+namespace {
+
+// Buckets items by the grid cell their position falls in, as linked lists threaded through a flat array. With cells at
+// least as large as the search radius every item within that radius of a point is in the 3x3 block of cells around it.
+class SpatialGrid {
+public:
+    SpatialGrid(const Units& units, float min_cell_size) :
+        min_x_(0.0f),
+        min_y_(0.0f),
+        inverse_cell_size_(1.0f),
+        width_(1),
+        height_(1) {
+        if (!units.empty()) {
+            min_x_ = units.front()->pos.x;
+            min_y_ = units.front()->pos.y;
+            float max_x = min_x_;
+            float max_y = min_y_;
+            for (const Unit* unit : units) {
+                min_x_ = std::min(min_x_, unit->pos.x);
+                min_y_ = std::min(min_y_, unit->pos.y);
+                max_x = std::max(max_x, unit->pos.x);
+                max_y = std::max(max_y, unit->pos.y);
+            }
+
+            // Larger cells are still correct, they only mean more comparisons. Grow them to bound the grid size.
+            float cell_size = std::max(min_cell_size, 1.0f);
+            float max_cells = float(4 * units.size() + 1024);
+            cell_size = std::max(cell_size, std::sqrt((max_x - min_x_ + 1.0f) * (max_y - min_y_ + 1.0f) / max_cells));
+            inverse_cell_size_ = 1.0f / cell_size;
+            width_ = static_cast<int>((max_x - min_x_) * inverse_cell_size_) + 1;
+            height_ = static_cast<int>((max_y - min_y_) * inverse_cell_size_) + 1;
+        }
+        heads_.assign(size_t(width_) * size_t(height_), -1);
+        next_.reserve(units.size());
+    }
+
+    int CellOf(const Point3D& pos) const {
+        return CellX(pos.x) + CellY(pos.y) * width_;
+    }
+
+    void Insert(int cell, int item) {
+        if (item >= static_cast<int>(next_.size())) {
+            next_.resize(item + 1, -1);
+        }
+        next_[item] = heads_[cell];
+        heads_[cell] = item;
+    }
+
+    void Remove(int cell, int item) {
+        int* link = &heads_[cell];
+        while (*link != item) {
+            link = &next_[*link];
+        }
+        *link = next_[item];
+    }
+
+    template<typename Function> void ForEachNear(const Point3D& pos, Function function) const {
+        int cx = CellX(pos.x);
+        int cy = CellY(pos.y);
+        for (int y = std::max(cy - 1, 0), ey = std::min(cy + 1, height_ - 1); y <= ey; ++y) {
+            for (int x = std::max(cx - 1, 0), ex = std::min(cx + 1, width_ - 1); x <= ex; ++x) {
+                for (int item = heads_[x + y * width_]; item >= 0; item = next_[item]) {
+                    function(size_t(item));
+                }
+            }
+        }
+    }
+
+private:
+    int CellX(float x) const {
+        return std::min(std::max(static_cast<int>((x - min_x_) * inverse_cell_size_), 0), width_ - 1);
+    }
+
+    int CellY(float y) const {
+        return std::min(std::max(static_cast<int>((y - min_y_) * inverse_cell_size_), 0), height_ - 1);
+    }
+
+    float min_x_;
+    float min_y_;
+    float inverse_cell_size_;
+    int width_;
+    int height_;
+    std::vector<int> heads_;
+    std::vector<int> next_;
+};
+
+std::vector<std::pair<Point3D, Units> > ClusterGreedy(const Units& units, float distance_apart) {
     float squared_distance_apart = distance_apart * distance_apart;
-    std::vector<std::pair<Point3D, std::vector<Unit> > > clusters;
-    for (size_t i = 0, e = units.size(); i < e; ++i) {
-        const Unit& u = *units[i];
+    std::vector<std::pair<Point3D, Units> > clusters;
+    std::vector<int> cluster_cells;
+    SpatialGrid grid(units, distance_apart);
+    for (const Unit* unit : units) {
+        const Unit& u = *unit;
 
+        // Find the cluster this unit is closest to, ties go to the oldest cluster.
         float distance = std::numeric_limits<float>::max();
-        std::pair<Point3D, std::vector<Unit> >* target_cluster = nullptr;
-        // Find the cluster this mineral patch is closest to.
-        for (auto& cluster : clusters) {
-            float d = DistanceSquared3D(u.pos, cluster.first);
-            if (d < distance) {
+        size_t target_cluster = clusters.size();
+        grid.ForEachNear(u.pos, [&](size_t cluster) {
+            float d = DistanceSquared3D(u.pos, clusters[cluster].first);
+            if (d < distance || (d == distance && cluster < target_cluster)) {
                 distance = d;
-                target_cluster = &cluster;
+                target_cluster = cluster;
             }
-        }
+        });
 
         // If the target cluster is some distance away don't use it.
         if (distance > squared_distance_apart) {
-            clusters.push_back(std::pair<Point3D, std::vector<Unit> >(u.pos, std::vector<Unit>{u}));
+            clusters.push_back(std::pair<Point3D, Units>(u.pos, Units{ unit }));
+            cluster_cells.push_back(grid.CellOf(u.pos));
+            grid.Insert(cluster_cells.back(), static_cast<int>(clusters.size() - 1));
             continue;
         }
 
         // Otherwise append to that cluster and update it's center of mass.
-        target_cluster->second.push_back(u);
-        size_t size = target_cluster->second.size();
-        target_cluster->first = ((target_cluster->first * (float(size) - 1)) + u.pos) / float(size);
+        std::pair<Point3D, Units>& cluster = clusters[target_cluster];
+        cluster.second.push_back(unit);
+        size_t size = cluster.second.size();
+        cluster.first = ((cluster.first * (float(size) - 1)) + u.pos) / float(size);
+
+        int cell = grid.CellOf(cluster.first);
+        if (cell != cluster_cells[target_cluster]) {
+            grid.Remove(cluster_cells[target_cluster], static_cast<int>(target_cluster));
+            grid.Insert(cell, static_cast<int>(target_cluster));
+            cluster_cells[target_cluster] = cell;
+        }
+    }
+
+    return clusters;
+}
+
+std::vector<std::pair<Point3D, Units> > ClusterDBSCAN(const Units& units, float distance_apart, size_t min_points) {
+    float squared_distance_apart = distance_apart * distance_apart;
+    SpatialGrid grid(units, distance_apart);
+    for (size_t i = 0; i < units.size(); ++i) {
+        grid.Insert(grid.CellOf(units[i]->pos), static_cast<int>(i));
+    }
+
+    auto find_neighbors = [&](size_t index, std::vector<size_t>& neighbors) {
+        neighbors.clear();
+        const Point3D& pos = units[index]->pos;
+        grid.ForEachNear(pos, [&](size_t other) {
+            if (DistanceSquared3D(pos, units[other]->pos) <= squared_distance_apart) {
+                neighbors.push_back(other);
+            }
+        });
+    };
+
+    static const int Unvisited = -1;
+    static const int Noise = -2;
+    std::vector<int> assignment(units.size(), Unvisited);
+    std::vector<std::pair<Point3D, Units> > clusters;
+    std::vector<size_t> neighbors;
+    std::vector<size_t> frontier;
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (assignment[i] != Unvisited) {
+            continue;
+        }
+
+        find_neighbors(i, neighbors);
+        if (neighbors.size() < min_points) {
+            assignment[i] = Noise;
+            continue;
+        }
+
+        int cluster_index = static_cast<int>(clusters.size());
+        clusters.push_back(std::pair<Point3D, Units>(Point3D(), Units()));
+        assignment[i] = cluster_index;
+        frontier.assign(neighbors.begin(), neighbors.end());
+        while (!frontier.empty()) {
+            size_t current = frontier.back();
+            frontier.pop_back();
+            if (assignment[current] == Noise) {
+                // Border unit, reachable from a core unit but not dense enough to extend the cluster itself.
+                assignment[current] = cluster_index;
+                continue;
+            }
+            if (assignment[current] != Unvisited && current != i) {
+                continue;
+            }
+
+            assignment[current] = cluster_index;
+            find_neighbors(current, neighbors);
+            if (neighbors.size() >= min_points) {
+                for (size_t neighbor : neighbors) {
+                    if (assignment[neighbor] == Unvisited || assignment[neighbor] == Noise) {
+                        frontier.push_back(neighbor);
+                    }
+                }
+            }
+        }
+    }
+
+    // Keep the units of each cluster in input order.
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (assignment[i] >= 0) {
+            std::pair<Point3D, Units>& cluster = clusters[assignment[i]];
+            cluster.first += units[i]->pos;
+            cluster.second.push_back(units[i]);
+        }
+    }
+    for (auto& cluster : clusters) {
+        cluster.first /= float(cluster.second.size());
     }
 
     return clusters;
 }
 
+}
+
+std::vector<std::pair<Point3D, Units> > Cluster(const Units& units, float distance_apart, ClusterMode mode, size_t min_points) {
+    if (mode == ClusterMode::DBSCAN) {
+        return ClusterDBSCAN(units, distance_apart, min_points);
+    }
+
+    return ClusterGreedy(units, distance_apart);
+}
+
 
 std::vector<Point3D> CalculateExpansionLocations(const ObservationInterface* observation, QueryInterface* query, ExpansionParameters parameters) {
-    Units resources = observation->GetUnits(
-        [](const Unit& unit) {
-            return unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750 ||
-                unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD || unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750 ||
-                unit.unit_type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER || unit.unit_type == UNIT_TYPEID::NEUTRAL_PROTOSSVESPENEGEYSER;
-        }
-    );
+    Units resources = observation->GetUnits(IsResource);
 
     std::vector<Point3D> expansion_locations;
-    std::vector<std::pair<Point3D, std::vector<Unit> > > clusters = Cluster(resources, parameters.cluster_distance_);
+    std::vector<std::pair<Point3D, Units> > clusters = Cluster(resources, parameters.cluster_distance_);
 
     std::vector<size_t> query_size;
     std::vector<QueryInterface::PlacementQuery> queries;
     for (size_t i = 0; i < clusters.size(); ++i) {
-        std::pair<Point3D, std::vector<Unit> >& cluster = clusters[i];
+        std::pair<Point3D, Units>& cluster = clusters[i];
         if (parameters.debug_) {
             for (auto r : parameters.radiuses_) {
                 parameters.debug_->DebugSphereOut(cluster.first, r, Colors::Green);
@@ -99,7 +288,7 @@ std::vector<Point3D> CalculateExpansionLocations(const ObservationInterface* obs
     std::vector<bool> results = query->Placement(queries);
     size_t start_index = 0;
     for (int i = 0; i < clusters.size(); ++i) {
-        std::pair<Point3D, std::vector<Unit> >& cluster = clusters[i];
+        std::pair<Point3D, Units>& cluster = clusters[i];
         float distance = std::numeric_limits<float>::max();
         Point2D closest;
 
@@ -118,7 +307,7 @@ std::vector<Point3D> CalculateExpansionLocations(const ObservationInterface* obs
             }
         }
 
-        Point3D expansion(closest.x, closest.y, cluster.second.begin()->pos.z);
+        Point3D expansion(closest.x, closest.y, cluster.second.front()->pos.z);
 
         if (parameters.debug_) {
             parameters.debug_->DebugSphereOut(expansion, 0.35f, Colors::Red);
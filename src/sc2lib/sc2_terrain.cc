@@ -0,0 +1,770 @@
+#include "sc2lib/sc2_terrain.h"
+#include "sc2lib/sc2_utils.h"
+#include "sc2utils/sc2_simple_serialization.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+
+namespace sc2 {
+
+namespace terrain {
+
+static const uint32_t TerrainFileMagic = 0x54524353; // "SCRT"
+static const uint32_t TerrainFileVersion = 1;
+
+// Chamfer weights for the distance transform, an orthogonal step costs 3 and a diagonal step 4.
+static const uint16_t ChamferOrthogonal = 3;
+static const uint16_t ChamferDiagonal = 4;
+
+static const int NeighborDX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+static const int NeighborDY[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+TerrainAnalysis::TerrainAnalysis() :
+    grid_hash(0),
+    width(0),
+    height(0) {
+}
+
+RegionId TerrainAnalysis::GetRegionId(const Point2D& point) const {
+    int x = int(point.x);
+    int y = int(point.y);
+    if (point.x < 0.0f || point.y < 0.0f || x >= width || y >= height) {
+        return NullRegion;
+    }
+
+    return region_map[x + y * width];
+}
+
+const Region* TerrainAnalysis::GetRegion(const Point2D& point) const {
+    RegionId id = GetRegionId(point);
+    if (id == NullRegion || id >= regions.size()) {
+        return nullptr;
+    }
+
+    return &regions[id];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Analysis.
+//-------------------------------------------------------------------------------------------------
+
+namespace {
+
+// Grids decoded into world order (lower left origin) so cell indices match TerrainAnalysis::region_map.
+struct Grids {
+    int width;
+    int height;
+    std::vector<bool> pathable;
+    std::vector<bool> placeable;
+    std::vector<float> height_map;
+};
+
+bool DecodeGrids(const GameInfo& game_info, Grids& grids) {
+    const ImageData& pathing = game_info.pathing_grid;
+    const ImageData& placement = game_info.placement_grid;
+    const ImageData& terrain = game_info.terrain_height;
+
+    int width = pathing.width;
+    int height = pathing.height;
+    size_t size = size_t(width) * size_t(height);
+    if (width <= 0 || height <= 0 || pathing.data.size() != size) {
+        return false;
+    }
+
+    bool has_placement = placement.width == width && placement.height == height && placement.data.size() == size;
+    bool has_height = terrain.width == width && terrain.height == height && terrain.data.size() == size;
+
+    grids.width = width;
+    grids.height = height;
+    grids.pathable.assign(size, false);
+    grids.placeable.assign(size, false);
+    grids.height_map.assign(size, 0.0f);
+    for (int y = 0; y < height; ++y) {
+        // Image data is stored with an upper left origin.
+        size_t image_row = size_t(height - 1 - y) * size_t(width);
+        size_t world_row = size_t(y) * size_t(width);
+        for (int x = 0; x < width; ++x) {
+            size_t image_index = image_row + x;
+            size_t world_index = world_row + x;
+            grids.pathable[world_index] = static_cast<unsigned char>(pathing.data[image_index]) != 255;
+            if (has_placement) {
+                grids.placeable[world_index] = static_cast<unsigned char>(placement.data[image_index]) == 255;
+            }
+            if (has_height) {
+                float value = static_cast<unsigned char>(terrain.data[image_index]);
+                grids.height_map[world_index] = -100.0f + 200.0f * value / 255.0f;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Chamfer distance from every pathable cell to the nearest unpathable cell or map edge.
+std::vector<uint16_t> DistanceTransform(const Grids& grids) {
+    const int w = grids.width;
+    const int h = grids.height;
+    std::vector<uint16_t> distance(size_t(w) * size_t(h), 0);
+
+    auto at = [&](int x, int y) -> uint16_t {
+        if (x < 0 || y < 0 || x >= w || y >= h) {
+            return 0;
+        }
+        return distance[x + y * w];
+    };
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int i = x + y * w;
+            if (!grids.pathable[i]) {
+                continue;
+            }
+
+            int d = std::numeric_limits<uint16_t>::max();
+            d = std::min(d, at(x - 1, y) + ChamferOrthogonal);
+            d = std::min(d, at(x, y - 1) + ChamferOrthogonal);
+            d = std::min(d, at(x - 1, y - 1) + ChamferDiagonal);
+            d = std::min(d, at(x + 1, y - 1) + ChamferDiagonal);
+            distance[i] = static_cast<uint16_t>(d);
+        }
+    }
+
+    for (int y = h - 1; y >= 0; --y) {
+        for (int x = w - 1; x >= 0; --x) {
+            int i = x + y * w;
+            if (!grids.pathable[i]) {
+                continue;
+            }
+
+            int d = distance[i];
+            d = std::min(d, at(x + 1, y) + ChamferOrthogonal);
+            d = std::min(d, at(x, y + 1) + ChamferOrthogonal);
+            d = std::min(d, at(x + 1, y + 1) + ChamferDiagonal);
+            d = std::min(d, at(x - 1, y + 1) + ChamferDiagonal);
+            distance[i] = static_cast<uint16_t>(d);
+        }
+    }
+
+    return distance;
+}
+
+class BasinSet {
+public:
+    int Add(uint16_t peak) {
+        parent_.push_back(static_cast<int>(parent_.size()));
+        peak_.push_back(peak);
+        return parent_.back();
+    }
+
+    int Find(int basin) {
+        while (parent_[basin] != basin) {
+            parent_[basin] = parent_[parent_[basin]];
+            basin = parent_[basin];
+        }
+        return basin;
+    }
+
+    // Merges two roots, the one with the higher peak survives.
+    int Merge(int a, int b) {
+        if (peak_[a] < peak_[b]) {
+            std::swap(a, b);
+        }
+        parent_[b] = a;
+        return a;
+    }
+
+    uint16_t Peak(int root) const { return peak_[root]; }
+    size_t Size() const { return parent_.size(); }
+
+private:
+    std::vector<int> parent_;
+    std::vector<uint16_t> peak_;
+};
+
+uint64_t PairKey(int a, int b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+}
+
+// Floods the distance transform from its maxima down. Basins meeting through a passage nearly as wide as the
+// narrower basin are merged, the others stay apart and the passage between them becomes a chokepoint.
+std::vector<int> Watershed(const Grids& grids, const std::vector<uint16_t>& distance, const TerrainParameters& parameters) {
+    const int w = grids.width;
+    const int h = grids.height;
+    const size_t size = distance.size();
+
+    // Counting sort of pathable cells by distance, descending.
+    uint16_t max_distance = 0;
+    for (size_t i = 0; i < size; ++i) {
+        max_distance = std::max(max_distance, distance[i]);
+    }
+    std::vector<int> bucket_start(size_t(max_distance) + 2, 0);
+    for (size_t i = 0; i < size; ++i) {
+        if (distance[i] > 0) {
+            ++bucket_start[max_distance - distance[i] + 1];
+        }
+    }
+    for (size_t i = 1; i < bucket_start.size(); ++i) {
+        bucket_start[i] += bucket_start[i - 1];
+    }
+    std::vector<int> order(bucket_start.back());
+    for (size_t i = 0; i < size; ++i) {
+        if (distance[i] > 0) {
+            order[bucket_start[max_distance - distance[i]]++] = static_cast<int>(i);
+        }
+    }
+
+    BasinSet basins;
+    std::vector<int> label(size, -1);
+    // Highest saddle seen between each pair of basins that were kept apart.
+    std::map<uint64_t, uint16_t> saddles;
+
+    int roots[8];
+    for (int cell : order) {
+        int x = cell % w;
+        int y = cell / w;
+        uint16_t d = distance[cell];
+
+        // The cell joins the basin of its steepest uphill neighbor.
+        int root_count = 0;
+        int best = -1;
+        uint16_t steepest = 0;
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + NeighborDX[n];
+            int ny = y + NeighborDY[n];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                continue;
+            }
+            int neighbor = nx + ny * w;
+            if (label[neighbor] < 0) {
+                continue;
+            }
+            int root = basins.Find(label[neighbor]);
+            if (std::find(roots, roots + root_count, root) == roots + root_count) {
+                roots[root_count++] = root;
+            }
+            if (best < 0 || distance[neighbor] > steepest) {
+                best = root;
+                steepest = distance[neighbor];
+            }
+        }
+
+        if (root_count == 0) {
+            label[cell] = basins.Add(d);
+            continue;
+        }
+
+        for (int r = 0; r < root_count; ++r) {
+            int other = basins.Find(roots[r]);
+            best = basins.Find(best);
+            if (other == best) {
+                continue;
+            }
+
+            float narrower = float(std::min(basins.Peak(other), basins.Peak(best)));
+            if (float(d) >= parameters.merge_ratio_ * narrower) {
+                best = basins.Merge(best, other);
+            }
+            else {
+                uint16_t& saddle = saddles[PairKey(best, other)];
+                saddle = std::max(saddle, d);
+            }
+        }
+
+        label[cell] = best;
+    }
+
+    // Fold small basins into the neighbor they share the widest passage with.
+    std::vector<uint32_t> area(basins.Size(), 0);
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        std::fill(area.begin(), area.end(), 0);
+        for (size_t i = 0; i < size; ++i) {
+            if (label[i] >= 0) {
+                ++area[basins.Find(label[i])];
+            }
+        }
+
+        for (size_t basin = 0; basin < basins.Size(); ++basin) {
+            int root = basins.Find(static_cast<int>(basin));
+            if (root != static_cast<int>(basin) || area[root] == 0 || area[root] >= parameters.min_region_area_) {
+                continue;
+            }
+
+            int target = -1;
+            uint16_t widest = 0;
+            for (const auto& saddle : saddles) {
+                int a = basins.Find(static_cast<int>(saddle.first >> 32));
+                int b = basins.Find(static_cast<int>(saddle.first & 0xFFFFFFFF));
+                if (a == b || (a != root && b != root)) {
+                    continue;
+                }
+                if (target < 0 || saddle.second > widest) {
+                    target = a == root ? b : a;
+                    widest = saddle.second;
+                }
+            }
+
+            if (target >= 0) {
+                int survivor = basins.Merge(root, target);
+                area[survivor] = area[root] + area[target];
+                merged = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < size; ++i) {
+        if (label[i] >= 0) {
+            label[i] = basins.Find(label[i]);
+        }
+    }
+
+    return label;
+}
+
+void BuildRegions(const Grids& grids, const std::vector<int>& label, TerrainAnalysis& analysis) {
+    const int w = grids.width;
+    const size_t size = label.size();
+
+    std::map<int, RegionId> ids;
+    analysis.region_map.assign(size, NullRegion);
+    for (size_t i = 0; i < size; ++i) {
+        if (label[i] < 0) {
+            continue;
+        }
+
+        auto found = ids.find(label[i]);
+        if (found == ids.end()) {
+            if (analysis.regions.size() >= NullRegion) {
+                continue;
+            }
+            RegionId id = static_cast<RegionId>(analysis.regions.size());
+            found = ids.insert(std::make_pair(label[i], id)).first;
+
+            Region region;
+            region.id = id;
+            region.height = 0.0f;
+            region.area = 0;
+            analysis.regions.push_back(region);
+        }
+
+        Region& region = analysis.regions[found->second];
+        analysis.region_map[i] = region.id;
+        region.center += Point2D(float(int(i) % w) + 0.5f, float(int(i) / w) + 0.5f);
+        region.height += grids.height_map[i];
+        ++region.area;
+    }
+
+    for (Region& region : analysis.regions) {
+        region.center /= float(region.area);
+        region.height /= float(region.area);
+    }
+}
+
+void BuildRamps(const Grids& grids, TerrainAnalysis& analysis, const TerrainParameters& parameters, std::vector<int32_t>& ramp_map) {
+    const int w = grids.width;
+    const int h = grids.height;
+    const size_t size = grids.pathable.size();
+
+    ramp_map.assign(size, -1);
+    std::vector<bool> visited(size, false);
+    std::vector<int> component;
+    std::vector<int> stack;
+    for (size_t start = 0; start < size; ++start) {
+        if (visited[start] || !grids.pathable[start] || grids.placeable[start]) {
+            continue;
+        }
+
+        // Flood the connected non-placeable area.
+        component.clear();
+        stack.push_back(static_cast<int>(start));
+        visited[start] = true;
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            component.push_back(cell);
+            int x = cell % w;
+            int y = cell / w;
+            for (int n = 0; n < 8; ++n) {
+                int nx = x + NeighborDX[n];
+                int ny = y + NeighborDY[n];
+                if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                    continue;
+                }
+                int next = nx + ny * w;
+                if (!visited[next] && grids.pathable[next] && !grids.placeable[next]) {
+                    visited[next] = true;
+                    stack.push_back(next);
+                }
+            }
+        }
+
+        int top = component.front();
+        int bottom = component.front();
+        Point2D center;
+        for (int cell : component) {
+            if (grids.height_map[cell] > grids.height_map[top]) {
+                top = cell;
+            }
+            if (grids.height_map[cell] < grids.height_map[bottom]) {
+                bottom = cell;
+            }
+            center += Point2D(float(cell % w) + 0.5f, float(cell / w) + 0.5f);
+        }
+
+        if (grids.height_map[top] - grids.height_map[bottom] < parameters.ramp_height_delta_) {
+            continue;
+        }
+
+        Ramp ramp;
+        ramp.center = center / float(component.size());
+        ramp.top = Point2D(float(top % w) + 0.5f, float(top / w) + 0.5f);
+        ramp.bottom = Point2D(float(bottom % w) + 0.5f, float(bottom / w) + 0.5f);
+        ramp.top_height = grids.height_map[top];
+        ramp.bottom_height = grids.height_map[bottom];
+        ramp.area = static_cast<uint32_t>(component.size());
+        ramp.region_top = NullRegion;
+        ramp.region_bottom = NullRegion;
+
+        // The regions at either end are the ones touching the ramp at its highest and lowest points.
+        float highest = std::numeric_limits<float>::lowest();
+        float lowest = std::numeric_limits<float>::max();
+        int32_t ramp_index = static_cast<int32_t>(analysis.ramps.size());
+        for (int cell : component) {
+            ramp_map[cell] = ramp_index;
+            int x = cell % w;
+            int y = cell / w;
+            for (int n = 0; n < 8; ++n) {
+                int nx = x + NeighborDX[n];
+                int ny = y + NeighborDY[n];
+                if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                    continue;
+                }
+                int next = nx + ny * w;
+                if (!grids.placeable[next] || analysis.region_map[next] == NullRegion) {
+                    continue;
+                }
+                if (grids.height_map[next] > highest) {
+                    highest = grids.height_map[next];
+                    ramp.region_top = analysis.region_map[next];
+                }
+                if (grids.height_map[next] < lowest) {
+                    lowest = grids.height_map[next];
+                    ramp.region_bottom = analysis.region_map[next];
+                }
+            }
+        }
+
+        analysis.ramps.push_back(ramp);
+    }
+}
+
+void BuildChokepoints(const Grids& grids, const std::vector<uint16_t>& distance, const std::vector<int32_t>& ramp_map, TerrainAnalysis& analysis) {
+    const int w = grids.width;
+    const int h = grids.height;
+    const size_t size = analysis.region_map.size();
+
+    // Border cells are pathable cells with an orthogonal neighbor in a different region.
+    auto other_region = [&](int cell) -> RegionId {
+        int x = cell % w;
+        int y = cell / w;
+        RegionId own = analysis.region_map[cell];
+        RegionId result = NullRegion;
+        for (int n = 0; n < 8; ++n) {
+            if (NeighborDX[n] != 0 && NeighborDY[n] != 0) {
+                continue;
+            }
+            int nx = x + NeighborDX[n];
+            int ny = y + NeighborDY[n];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                continue;
+            }
+            RegionId id = analysis.region_map[nx + ny * w];
+            if (id != NullRegion && id != own) {
+                result = std::min(result, id);
+            }
+        }
+        return result;
+    };
+
+    std::vector<RegionId> border(size, NullRegion);
+    for (size_t i = 0; i < size; ++i) {
+        if (analysis.region_map[i] != NullRegion) {
+            border[i] = other_region(static_cast<int>(i));
+        }
+    }
+
+    // Each connected run of border cells between the same pair of regions is one chokepoint.
+    std::vector<bool> visited(size, false);
+    std::vector<int> component;
+    std::vector<int> stack;
+    for (size_t start = 0; start < size; ++start) {
+        if (visited[start] || border[start] == NullRegion) {
+            continue;
+        }
+
+        RegionId a = std::min(analysis.region_map[start], border[start]);
+        RegionId b = std::max(analysis.region_map[start], border[start]);
+        auto same_pair = [&](int cell) {
+            RegionId ca = std::min(analysis.region_map[cell], border[cell]);
+            RegionId cb = std::max(analysis.region_map[cell], border[cell]);
+            return border[cell] != NullRegion && ca == a && cb == b;
+        };
+
+        component.clear();
+        stack.push_back(static_cast<int>(start));
+        visited[start] = true;
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            component.push_back(cell);
+            int x = cell % w;
+            int y = cell / w;
+            for (int n = 0; n < 8; ++n) {
+                int nx = x + NeighborDX[n];
+                int ny = y + NeighborDY[n];
+                if (nx < 0 || ny < 0 || nx >= w || ny >= h) {
+                    continue;
+                }
+                int next = nx + ny * w;
+                if (!visited[next] && same_pair(next)) {
+                    visited[next] = true;
+                    stack.push_back(next);
+                }
+            }
+        }
+
+        int center = component.front();
+        int32_t ramp = -1;
+        for (int cell : component) {
+            if (distance[cell] > distance[center]) {
+                center = cell;
+            }
+            if (ramp < 0) {
+                ramp = ramp_map[cell];
+            }
+        }
+
+        // The two border cells furthest apart sit against the walls.
+        int side_a = center;
+        int side_b = center;
+        int best = -1;
+        for (size_t i = 0; i < component.size(); ++i) {
+            for (size_t j = i + 1; j < component.size(); ++j) {
+                int dx = component[i] % w - component[j] % w;
+                int dy = component[i] / w - component[j] / w;
+                int d = dx * dx + dy * dy;
+                if (d > best) {
+                    best = d;
+                    side_a = component[i];
+                    side_b = component[j];
+                }
+            }
+        }
+
+        Chokepoint chokepoint;
+        chokepoint.center = Point2D(float(center % w) + 0.5f, float(center / w) + 0.5f);
+        chokepoint.side_a = Point2D(float(side_a % w) + 0.5f, float(side_a / w) + 0.5f);
+        chokepoint.side_b = Point2D(float(side_b % w) + 0.5f, float(side_b / w) + 0.5f);
+        chokepoint.width = std::max(Distance2D(chokepoint.side_a, chokepoint.side_b),
+            2.0f * float(distance[center]) / float(ChamferOrthogonal));
+        chokepoint.region_a = a;
+        chokepoint.region_b = b;
+        chokepoint.ramp = ramp;
+
+        uint32_t index = static_cast<uint32_t>(analysis.chokepoints.size());
+        analysis.regions[a].chokepoints.push_back(index);
+        analysis.regions[b].chokepoints.push_back(index);
+        analysis.chokepoints.push_back(chokepoint);
+    }
+}
+
+void WriteParameters(std::ofstream& file, const TerrainParameters& parameters) {
+    WriteBinary(file, parameters.merge_ratio_);
+    WriteBinary(file, parameters.min_region_area_);
+    WriteBinary(file, parameters.ramp_height_delta_);
+}
+
+bool ReadParameters(std::ifstream& file, const TerrainParameters& parameters) {
+    TerrainParameters stored;
+    if (!ReadBinary(file, stored.merge_ratio_) ||
+        !ReadBinary(file, stored.min_region_area_) ||
+        !ReadBinary(file, stored.ramp_height_delta_)) {
+        return false;
+    }
+
+    return stored.merge_ratio_ == parameters.merge_ratio_ &&
+        stored.min_region_area_ == parameters.min_region_area_ &&
+        stored.ramp_height_delta_ == parameters.ramp_height_delta_;
+}
+
+// Checks the indices between the parts of a loaded analysis, consumers index with them without checking.
+bool IsConsistent(const TerrainAnalysis& analysis) {
+    size_t region_count = analysis.regions.size();
+    auto valid_region = [region_count](RegionId region) {
+        return region == NullRegion || region < region_count;
+    };
+
+    for (RegionId region : analysis.region_map) {
+        if (!valid_region(region)) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < region_count; ++i) {
+        const Region& region = analysis.regions[i];
+        if (region.id != i) {
+            return false;
+        }
+        for (uint32_t chokepoint : region.chokepoints) {
+            if (chokepoint >= analysis.chokepoints.size()) {
+                return false;
+            }
+        }
+    }
+
+    for (const Chokepoint& chokepoint : analysis.chokepoints) {
+        if (chokepoint.region_a >= region_count || chokepoint.region_b >= region_count ||
+            chokepoint.ramp < -1 || (chokepoint.ramp >= 0 && size_t(chokepoint.ramp) >= analysis.ramps.size())) {
+            return false;
+        }
+    }
+
+    for (const Ramp& ramp : analysis.ramps) {
+        if (!valid_region(ramp.region_top) || !valid_region(ramp.region_bottom)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+std::string GetTerrainCachePath(const GameInfo& game_info, const TerrainParameters& parameters) {
+    return GetMapCachePath(parameters.cache_directory_, game_info.map_name, HashGameInfoGrids(game_info), ".terrain");
+}
+
+bool SaveTerrainAnalysis(const std::string& path, const TerrainAnalysis& analysis, const TerrainParameters& parameters) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    WriteBinary(file, TerrainFileMagic);
+    WriteBinary(file, TerrainFileVersion);
+    WriteParameters(file, parameters);
+    WriteBinary(file, analysis.map_name);
+    WriteBinary(file, analysis.grid_hash);
+    WriteBinary(file, analysis.width);
+    WriteBinary(file, analysis.height);
+    WriteBinary(file, analysis.region_map);
+
+    WriteBinary(file, static_cast<uint32_t>(analysis.regions.size()));
+    for (const Region& region : analysis.regions) {
+        WriteBinary(file, region.id);
+        WriteBinary(file, region.center);
+        WriteBinary(file, region.height);
+        WriteBinary(file, region.area);
+        WriteBinary(file, region.chokepoints);
+    }
+
+    WriteBinary(file, analysis.chokepoints);
+    WriteBinary(file, analysis.ramps);
+    return file.good();
+}
+
+bool LoadTerrainAnalysis(const std::string& path, TerrainAnalysis& analysis, const TerrainParameters& parameters) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!ReadBinary(file, magic) || magic != TerrainFileMagic ||
+        !ReadBinary(file, version) || version != TerrainFileVersion ||
+        !ReadParameters(file, parameters)) {
+        return false;
+    }
+
+    TerrainAnalysis result;
+    uint32_t region_count = 0;
+    if (!ReadBinary(file, result.map_name) ||
+        !ReadBinary(file, result.grid_hash) ||
+        !ReadBinary(file, result.width) ||
+        !ReadBinary(file, result.height) ||
+        !ReadBinary(file, result.region_map) ||
+        !ReadBinary(file, region_count) ||
+        region_count > NullRegion) {
+        return false;
+    }
+
+    if (result.width < 0 || result.height < 0 || result.region_map.size() != size_t(result.width) * size_t(result.height)) {
+        return false;
+    }
+
+    result.regions.resize(region_count);
+    for (Region& region : result.regions) {
+        if (!ReadBinary(file, region.id) ||
+            !ReadBinary(file, region.center) ||
+            !ReadBinary(file, region.height) ||
+            !ReadBinary(file, region.area) ||
+            !ReadBinary(file, region.chokepoints)) {
+            return false;
+        }
+    }
+
+    if (!ReadBinary(file, result.chokepoints) || !ReadBinary(file, result.ramps) || !IsConsistent(result)) {
+        return false;
+    }
+
+    analysis = std::move(result);
+    return true;
+}
+
+TerrainAnalysis AnalyzeTerrain(const GameInfo& game_info, const TerrainParameters& parameters) {
+    TerrainAnalysis analysis;
+    analysis.map_name = game_info.map_name;
+    analysis.grid_hash = HashGameInfoGrids(game_info);
+
+    std::string cache_path;
+    if (parameters.use_cache_) {
+        cache_path = GetTerrainCachePath(game_info, parameters);
+        TerrainAnalysis cached;
+        if (LoadTerrainAnalysis(cache_path, cached, parameters) && cached.grid_hash == analysis.grid_hash) {
+            return cached;
+        }
+    }
+
+    Grids grids;
+    if (!DecodeGrids(game_info, grids)) {
+        std::cerr << "AnalyzeTerrain: map " << game_info.map_name << " has no usable pathing grid." << std::endl;
+        return analysis;
+    }
+    analysis.width = grids.width;
+    analysis.height = grids.height;
+
+    std::vector<uint16_t> distance = DistanceTransform(grids);
+    std::vector<int> label = Watershed(grids, distance, parameters);
+    BuildRegions(grids, label, analysis);
+
+    std::vector<int32_t> ramp_map;
+    BuildRamps(grids, analysis, parameters, ramp_map);
+    BuildChokepoints(grids, distance, ramp_map, analysis);
+
+    if (parameters.use_cache_ && !SaveTerrainAnalysis(cache_path, analysis, parameters)) {
+        std::cerr << "AnalyzeTerrain: could not write cache file " << cache_path << std::endl;
+    }
+
+    return analysis;
+}
+
+}
+
+}
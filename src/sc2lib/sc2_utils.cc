@@ -1,6 +1,8 @@
 #include "sc2api/sc2_api.h"
 #include "sc2lib/sc2_utils.h"
 
+#include <cstdio>
+
 namespace sc2 {
 
 Point2D FindRandomLocation(const Point2D& min, const Point2D& max) {
@@ -23,4 +25,42 @@ Point2D FindCenterOfMap(const GameInfo& game_info) {
     return target_pos;
 }
 
-}
\ No newline at end of file
+static void HashBytes(uint64_t& hash, const void* data, size_t size) {
+    // FNV-1a.
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+uint64_t HashGameInfoGrids(const GameInfo& game_info) {
+    uint64_t hash = 14695981039346656037ULL;
+    HashBytes(hash, &game_info.width, sizeof(game_info.width));
+    HashBytes(hash, &game_info.height, sizeof(game_info.height));
+    const ImageData* grids[] = { &game_info.pathing_grid, &game_info.terrain_height, &game_info.placement_grid };
+    for (const ImageData* grid : grids) {
+        HashBytes(hash, &grid->width, sizeof(grid->width));
+        HashBytes(hash, &grid->height, sizeof(grid->height));
+        HashBytes(hash, grid->data.data(), grid->data.size());
+    }
+    return hash;
+}
+
+std::string GetMapCachePath(const std::string& directory, const std::string& map_name, uint64_t key, const std::string& extension) {
+    std::string path = directory;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+        path += "/";
+    }
+
+    for (char c : map_name) {
+        bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+        path.push_back(keep ? c : '_');
+    }
+
+    char key_text[17];
+    snprintf(key_text, sizeof(key_text), "%016llx", static_cast<unsigned long long>(key));
+    return path + "_" + key_text + extension;
+}
+
+}
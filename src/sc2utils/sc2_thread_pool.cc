@@ -0,0 +1,174 @@
+#include "sc2utils/sc2_thread_pool.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sc2 {
+
+// Cores past what the affinity mask can hold, e.g. beyond the first processor group on Windows, are left unpinned.
+static void PinCurrentThread(size_t core) {
+#if defined(_WIN32)
+    if (core >= sizeof(DWORD_PTR) * 8) {
+        return;
+    }
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) {
+        return;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+    // Mac only offers affinity hints between threads, not pinning to a core.
+    (void)core;
+#endif
+}
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_threads) :
+    pin_threads_(pin_threads),
+    stopping_(false) {
+    size_t cores = std::thread::hardware_concurrency();
+    if (cores == 0) {
+        cores = 1;
+    }
+    if (thread_count == 0) {
+        thread_count = cores;
+    }
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&ThreadPool::WorkerLoop, this, i % cores);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    task_available_.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    if (count == 1 || threads_.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (size_t i = 1; i < count; ++i) {
+        group.Run([&task, i]() { task(i); });
+    }
+
+    // The calling thread takes the first task and then helps with the rest, so nested calls can't deadlock.
+    task(0);
+    group.Wait();
+}
+
+void ThreadPool::WorkerLoop(size_t core) {
+    if (pin_threads_) {
+        PinCurrentThread(core);
+    }
+
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
+
+struct TaskGroup::State {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    // Tasks queued or running.
+    size_t unfinished = 0;
+    std::condition_variable finished;
+
+    bool RunOne() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) {
+                return false;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--unfinished == 0) {
+            finished.notify_all();
+        }
+        return true;
+    }
+};
+
+TaskGroup::TaskGroup(ThreadPool& thread_pool) :
+    thread_pool_(thread_pool),
+    state_(std::make_shared<State>()) {
+}
+
+TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+void TaskGroup::Run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->tasks.push_back(std::move(task));
+        ++state_->unfinished;
+    }
+
+    // A worker runs whichever task of the group is next, if the waiting thread hasn't taken them all by then.
+    std::shared_ptr<State> state = state_;
+    thread_pool_.Submit([state]() { state->RunOne(); });
+}
+
+bool TaskGroup::RunPendingTask() {
+    return state_->RunOne();
+}
+
+void TaskGroup::Wait() {
+    while (state_->RunOne()) {
+    }
+
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->finished.wait(lock, [this]() { return state_->unfinished == 0; });
+}
+
+}
@@ -18,6 +18,17 @@
 // Tests. Easier to extern than create a .h for a single function prototype.
 namespace sc2 {
 bool TestAbilityRemap(int argc, char** argv);
+bool TestSearch(int argc, char** argv);
+bool TestScenario(int argc, char** argv);
+bool TestSpatialActions(int argc, char** argv);
+bool TestTerrain(int argc, char** argv);
+bool TestMapCache(int argc, char** argv);
+bool TestInfluenceMap(int argc, char** argv);
+bool TestCoordinateTransform(int argc, char** argv);
+bool TestThreadPool(int argc, char** argv);
+bool TestReplayIndex(int argc, char** argv);
+bool TestReplayJournal(int argc, char** argv);
+bool TestActionScheduler(int argc, char** argv);
 }
 
 
@@ -36,6 +47,17 @@ int main(int argc, char* argv[]) {
     bool success = true;
 
     // Add tests here.
+    TEST(sc2::TestSearch);
+    TEST(sc2::TestScenario);
+    TEST(sc2::TestSpatialActions);
+    TEST(sc2::TestTerrain);
+    TEST(sc2::TestMapCache);
+    TEST(sc2::TestInfluenceMap);
+    TEST(sc2::TestCoordinateTransform);
+    TEST(sc2::TestThreadPool);
+    TEST(sc2::TestReplayIndex);
+    TEST(sc2::TestReplayJournal);
+    TEST(sc2::TestActionScheduler);
     TEST(sc2::TestRequestRestartGame);
     TEST(sc2::TestAbilityRemap);
     TEST(sc2::TestSnapshots);
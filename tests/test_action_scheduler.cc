@@ -0,0 +1,298 @@
+#include "sc2api/sc2_interfaces.h"
+#include "sc2api/sc2_map_info.h"
+#include "sc2api/sc2_score.h"
+#include "sc2api/sc2_typeenums.h"
+#include "sc2lib/sc2_action_scheduler.h"
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sc2 {
+
+// Holds units and their orders, the game loop and the ability remaps, which is all the scheduler looks at.
+class SchedulerObservation : public ObservationInterface {
+public:
+    uint32_t game_loop = 0;
+    std::unordered_map<Tag, Unit> units;
+    Abilities abilities;
+
+    SchedulerObservation() {
+        abilities.resize(static_cast<size_t>(ABILITY_ID::ATTACK) + 1);
+        abilities[static_cast<size_t>(ABILITY_ID::ATTACK_ATTACK)].remaps_to_ability_id = static_cast<uint32_t>(ABILITY_ID::ATTACK);
+    }
+
+    Unit& AddUnit(Tag tag) {
+        Unit& unit = units[tag];
+        unit.tag = tag;
+        return unit;
+    }
+
+    uint32_t GetPlayerID() const override { return 1; }
+    uint32_t GetGameLoop() const override { return game_loop; }
+    Units GetUnits() const override { return Units(); }
+    Units GetUnits(Unit::Alliance, Filter) const override { return Units(); }
+    Units GetUnits(Filter) const override { return Units(); }
+    const Unit* GetUnit(Tag tag) const override {
+        auto found = units.find(tag);
+        return found != units.end() ? &found->second : nullptr;
+    }
+    const RawActions& GetRawActions() const override { return raw_actions_; }
+    const SpatialActions& GetFeatureLayerActions() const override { return spatial_actions_; }
+    const SpatialActions& GetRenderedActions() const override { return spatial_actions_; }
+    const std::vector<ChatMessage>& GetChatMessages() const override { return chat_; }
+    const std::vector<PowerSource>& GetPowerSources() const override { return power_sources_; }
+    const std::vector<Effect>& GetEffects() const override { return effects_; }
+    const std::vector<UpgradeID>& GetUpgrades() const override { return upgrades_; }
+    const Score& GetScore() const override { return score_; }
+    const Abilities& GetAbilityData(bool) const override { return abilities; }
+    const UnitTypes& GetUnitTypeData(bool) const override { return unit_types_; }
+    const Upgrades& GetUpgradeData(bool) const override { return upgrade_data_; }
+    const Buffs& GetBuffData(bool) const override { return buff_data_; }
+    const Effects& GetEffectData(bool) const override { return effect_data_; }
+    const GameInfo& GetGameInfo() const override { return game_info_; }
+    int32_t GetMinerals() const override { return 0; }
+    int32_t GetVespene() const override { return 0; }
+    int32_t GetFoodCap() const override { return 0; }
+    int32_t GetFoodUsed() const override { return 0; }
+    int32_t GetFoodArmy() const override { return 0; }
+    int32_t GetFoodWorkers() const override { return 0; }
+    int32_t GetIdleWorkerCount() const override { return 0; }
+    int32_t GetArmyCount() const override { return 0; }
+    int32_t GetWarpGateCount() const override { return 0; }
+    Point2D GetCameraPos() const override { return Point2D(); }
+    Point3D GetStartLocation() const override { return Point3D(); }
+    const std::vector<PlayerResult>& GetResults() const override { return results_; }
+    bool HasCreep(const Point2D&) const override { return false; }
+    Visibility GetVisibility(const Point2D&) const override { return Visibility::Visible; }
+    bool IsPathable(const Point2D&) const override { return true; }
+    bool IsPlacable(const Point2D&) const override { return true; }
+    float TerrainHeight(const Point2D&) const override { return 0.0f; }
+    const SC2APIProtocol::Observation* GetRawObservation() const override { return nullptr; }
+
+private:
+    RawActions raw_actions_;
+    SpatialActions spatial_actions_;
+    std::vector<ChatMessage> chat_;
+    std::vector<PowerSource> power_sources_;
+    std::vector<Effect> effects_;
+    std::vector<UpgradeID> upgrades_;
+    Score score_;
+    UnitTypes unit_types_;
+    Upgrades upgrade_data_;
+    Buffs buff_data_;
+    Effects effect_data_;
+    GameInfo game_info_;
+    std::vector<PlayerResult> results_;
+};
+
+// Writes down the commands the scheduler sends, one string per command.
+class SchedulerActions : public ActionInterface {
+public:
+    std::vector<std::string> sent;
+
+    void UnitCommand(const Unit* unit, AbilityID ability, bool queued_command) override {
+        UnitCommand(Units{ unit }, ability, queued_command);
+    }
+    void UnitCommand(const Unit* unit, AbilityID ability, const Point2D& point, bool queued_command) override {
+        UnitCommand(Units{ unit }, ability, point, queued_command);
+    }
+    void UnitCommand(const Unit* unit, AbilityID ability, const Unit* target, bool queued_command) override {
+        UnitCommand(Units{ unit }, ability, target, queued_command);
+    }
+    void UnitCommand(const Units& units, AbilityID ability, bool queued_command) override {
+        Record(units, ability, "", queued_command);
+    }
+    void UnitCommand(const Units& units, AbilityID ability, const Point2D& point, bool queued_command) override {
+        Record(units, ability, " at " + std::to_string(static_cast<int>(point.x)) + "," + std::to_string(static_cast<int>(point.y)), queued_command);
+    }
+    void UnitCommand(const Units& units, AbilityID ability, const Unit* target, bool queued_command) override {
+        Record(units, ability, " on " + std::to_string(target->tag), queued_command);
+    }
+
+    const std::vector<Tag>& Commands() const override { return commands_; }
+    void ToggleAutocast(Tag, AbilityID) override {}
+    void ToggleAutocast(const std::vector<Tag>&, AbilityID) override {}
+    void SendChat(const std::string&, ChatChannel) override {}
+    void SendActions() override {}
+    void SetDeferredResponses(bool) override {}
+    const std::vector<uint32_t>& GetActionResults() const override { return results_; }
+
+private:
+    void Record(const Units& units, AbilityID ability, const std::string& target, bool queued_command) {
+        std::string command = AbilityTypeToName(ability);
+        for (const Unit* unit : units) {
+            command += " " + std::to_string(unit->tag);
+        }
+        sent.push_back(command + target + (queued_command ? " queued" : ""));
+    }
+
+    std::vector<Tag> commands_;
+    std::vector<uint32_t> results_;
+};
+
+static UnitOrder MakeOrder(ABILITY_ID ability, const Point2D& point, Tag target = NullTag) {
+    UnitOrder order;
+    order.ability_id = ability;
+    order.target_pos = point;
+    order.target_unit_tag = target;
+    return order;
+}
+
+static bool CheckSent(const SchedulerActions& actions, const std::vector<std::string>& expected, const char* what) {
+    if (actions.sent == expected) {
+        return true;
+    }
+
+    std::cerr << what << ", sent:" << std::endl;
+    for (const std::string& command : actions.sent) {
+        std::cerr << "    " << command << std::endl;
+    }
+    return false;
+}
+
+static bool TestRedundant() {
+    SchedulerObservation observation;
+    // Already moving there, the only order.
+    observation.AddUnit(1).orders = { MakeOrder(ABILITY_ID::MOVE, Point2D(10.0f, 10.0f)) };
+    // Moving there with an attack queued after, which a new move would clear.
+    observation.AddUnit(2).orders = { MakeOrder(ABILITY_ID::MOVE, Point2D(10.0f, 10.0f)), MakeOrder(ABILITY_ID::ATTACK, Point2D(20.0f, 20.0f)) };
+    // Attacking the unit, reported with the specific ability.
+    observation.AddUnit(3).orders = { MakeOrder(ABILITY_ID::ATTACK_ATTACK, Point2D(), 9) };
+    // Training a marine, another one adds to the queue.
+    observation.AddUnit(4).orders = { MakeOrder(ABILITY_ID::TRAIN_MARINE, Point2D()) };
+    observation.AddUnit(9);
+
+    ActionScheduler scheduler;
+    SchedulerActions actions;
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(10.2f, 10.0f));
+    scheduler.UnitCommand(observation.GetUnit(2), ABILITY_ID::MOVE, Point2D(10.0f, 10.0f));
+    scheduler.UnitCommand(observation.GetUnit(3), ABILITY_ID::ATTACK, observation.GetUnit(9));
+    scheduler.UnitCommand(observation.GetUnit(4), ABILITY_ID::TRAIN_MARINE);
+    // Queued commands are always sent.
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(10.0f, 10.0f), true);
+    scheduler.Flush(&observation, &actions);
+
+    if (!CheckSent(actions, { "MOVE 2 at 10,10", "TRAIN_MARINE 4", "MOVE 1 at 10,10 queued" }, "Redundant commands weren't dropped")) {
+        return false;
+    }
+    if (scheduler.GetStats().redundant != 2 || scheduler.GetStats().sent != 3 || scheduler.GetPendingCount() != 0) {
+        std::cerr << "Scheduler counted " << scheduler.GetStats().redundant << " redundant commands instead of 2" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestSuperseded() {
+    SchedulerObservation observation;
+    observation.AddUnit(1);
+    observation.AddUnit(2);
+    observation.AddUnit(3);
+
+    ActionScheduler scheduler;
+    SchedulerActions actions;
+    // The later move replaces the first of unit 1, unit 2 keeps it.
+    scheduler.UnitCommand(Units{ observation.GetUnit(1), observation.GetUnit(2) }, ABILITY_ID::MOVE, Point2D(5.0f, 5.0f));
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(6.0f, 6.0f));
+    // A queued move goes after the one before it, a whole command replaced is superseded.
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(7.0f, 7.0f), true);
+    scheduler.UnitCommand(observation.GetUnit(3), ABILITY_ID::HOLDPOSITION);
+    scheduler.UnitCommand(observation.GetUnit(3), ABILITY_ID::STOP);
+    scheduler.Flush(&observation, &actions);
+
+    if (!CheckSent(actions, { "MOVE 2 at 5,5", "MOVE 1 at 6,6", "MOVE 1 at 7,7 queued", "STOP 3" }, "Replaced commands weren't superseded")) {
+        return false;
+    }
+    if (scheduler.GetStats().superseded != 1) {
+        std::cerr << "Scheduler counted " << scheduler.GetStats().superseded << " superseded commands instead of 1" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestPriorities() {
+    SchedulerObservation observation;
+    for (Tag tag = 1; tag <= 4; ++tag) {
+        observation.AddUnit(tag);
+    }
+
+    // Unlimited, everything is sent in priority order. The low move of unit 4 goes with its later high command.
+    ActionScheduler scheduler;
+    SchedulerActions actions;
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(1.0f, 1.0f), false, ActionPriority::Low);
+    scheduler.UnitCommand(observation.GetUnit(2), ABILITY_ID::MOVE, Point2D(2.0f, 2.0f), false, ActionPriority::High);
+    scheduler.UnitCommand(observation.GetUnit(3), ABILITY_ID::MOVE, Point2D(3.0f, 3.0f), false, ActionPriority::Normal);
+    scheduler.UnitCommand(observation.GetUnit(4), ABILITY_ID::MOVE, Point2D(4.0f, 4.0f), false, ActionPriority::Low);
+    scheduler.UnitCommand(observation.GetUnit(4), ABILITY_ID::ATTACK, Point2D(5.0f, 5.0f), true, ActionPriority::High);
+    scheduler.Flush(&observation, &actions);
+
+    return CheckSent(actions, { "MOVE 2 at 2,2", "MOVE 4 at 4,4", "ATTACK 4 at 5,5 queued", "MOVE 3 at 3,3", "MOVE 1 at 1,1" },
+        "Commands weren't sent by priority");
+}
+
+static bool TestBudget() {
+    SchedulerObservation observation;
+    for (Tag tag = 1; tag <= 4; ++tag) {
+        observation.AddUnit(tag);
+    }
+
+    // One command a second, a burst of one.
+    ActionSchedulerParameters parameters;
+    parameters.actions_per_minute_ = 60.0f;
+    parameters.burst_seconds_ = 1.0f;
+    parameters.max_defer_loops_ = 40;
+    ActionScheduler scheduler(parameters);
+    SchedulerActions actions;
+
+    scheduler.UnitCommand(observation.GetUnit(1), ABILITY_ID::MOVE, Point2D(1.0f, 1.0f), false, ActionPriority::Low);
+    scheduler.UnitCommand(observation.GetUnit(2), ABILITY_ID::MOVE, Point2D(2.0f, 2.0f), false, ActionPriority::High);
+    scheduler.UnitCommand(observation.GetUnit(3), ABILITY_ID::MOVE, Point2D(3.0f, 3.0f), false, ActionPriority::Normal);
+    scheduler.Flush(&observation, &actions);
+    if (!CheckSent(actions, { "MOVE 2 at 2,2" }, "Budget of one didn't send the high priority command only") ||
+        scheduler.GetPendingCount() != 2) {
+        return false;
+    }
+
+    // Half the budget is back, not enough. A critical command goes out anyway.
+    observation.game_loop = 11;
+    scheduler.UnitCommand(observation.GetUnit(4), ABILITY_ID::STOP, false, ActionPriority::Critical);
+    scheduler.Flush(&observation, &actions);
+    if (!CheckSent(actions, { "MOVE 2 at 2,2", "STOP 4" }, "Critical command waited for budget")) {
+        return false;
+    }
+
+    // The critical command overdrew the budget, it takes until after the low command expired to send the normal one.
+    observation.game_loop = 40;
+    scheduler.Flush(&observation, &actions);
+    if (actions.sent.size() != 2 || scheduler.GetPendingCount() != 2) {
+        std::cerr << "Deferred command sent before the budget was back" << std::endl;
+        return false;
+    }
+    observation.game_loop = 56;
+    scheduler.Flush(&observation, &actions);
+    if (!CheckSent(actions, { "MOVE 2 at 2,2", "STOP 4", "MOVE 3 at 3,3" }, "Deferred commands weren't sent or expired")) {
+        return false;
+    }
+
+    const ActionSchedulerStats& stats = scheduler.GetStats();
+    if (stats.expired != 1 || scheduler.GetPendingCount() != 0 || stats.sent != 3 || stats.issued != 4) {
+        std::cerr << "Scheduler expired " << stats.expired << " and sent " << stats.sent << " commands instead of 1 and 3" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestActionScheduler(int, char**) {
+    bool success = true;
+    success = TestRedundant() && success;
+    success = TestSuperseded() && success;
+    success = TestPriorities() && success;
+    success = TestBudget() && success;
+    return success;
+}
+
+}
@@ -0,0 +1,174 @@
+#include "sc2api/sc2_map_info.h"
+#include "sc2lib/sc2_coordinate_transform.h"
+#include "feature_layers_shared.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace sc2 {
+
+typedef CoordinateTransform::Space Space;
+
+static const Space CoordinateTestSpaces[] = { Space::FeatureMap, Space::FeatureMinimap, Space::RenderMinimap };
+
+// A map that isn't square and resolutions whose pixel sizes aren't powers of two, so pixel edges aren't exact.
+static GameInfo MakeGameInfo() {
+    GameInfo game_info;
+    game_info.width = 176;
+    game_info.height = 144;
+    game_info.options.feature_layer.camera_width = 24.0f;
+    game_info.options.feature_layer.map_resolution_x = 84;
+    game_info.options.feature_layer.map_resolution_y = 63;
+    game_info.options.feature_layer.minimap_resolution_x = 64;
+    game_info.options.feature_layer.minimap_resolution_y = 64;
+    game_info.options.render.camera_width = 0.0f;
+    game_info.options.render.map_resolution_x = 0;
+    game_info.options.render.map_resolution_y = 0;
+    game_info.options.render.minimap_resolution_x = 128;
+    game_info.options.render.minimap_resolution_y = 96;
+    return game_info;
+}
+
+// World points on, just before and just after every pixel edge of a space, from one pixel outside the image to one
+// past its far side.
+static std::vector<Point2D> EdgePoints(const CoordinateTransform& transform, Space space) {
+    Point2DI resolution = transform.GetResolution(space);
+    Point2D upper_left = transform.PixelToWorld(space, Point2DI(0, 0));
+    float pixel_size = transform.GetPixelSize(space);
+    float origin_x = upper_left.x - pixel_size / 2.0f;
+    float origin_y = upper_left.y + pixel_size / 2.0f;
+
+    std::vector<float> xs;
+    for (int i = -1; i <= resolution.x + 1; ++i) {
+        float x = origin_x + float(i) * pixel_size;
+        xs.push_back(std::nextafter(x, -1.0e9f));
+        xs.push_back(x);
+        xs.push_back(std::nextafter(x, 1.0e9f));
+    }
+    std::vector<float> ys;
+    for (int i = -1; i <= resolution.y + 1; ++i) {
+        float y = origin_y - float(i) * pixel_size;
+        ys.push_back(std::nextafter(y, -1.0e9f));
+        ys.push_back(y);
+        ys.push_back(std::nextafter(y, 1.0e9f));
+    }
+
+    // Each x against the edge rows and each y against the edge columns, rather than every combination.
+    std::vector<Point2D> points;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        points.push_back(Point2D(xs[i], ys[i % ys.size()]));
+    }
+    for (size_t i = 0; i < ys.size(); ++i) {
+        points.push_back(Point2D(xs[(i * 7) % xs.size()], ys[i]));
+    }
+    return points;
+}
+
+static std::vector<Point2DI> EdgePixels(const CoordinateTransform& transform, Space space) {
+    Point2DI resolution = transform.GetResolution(space);
+    std::vector<Point2DI> pixels;
+    for (int x = -1; x <= resolution.x; ++x) {
+        pixels.push_back(Point2DI(x, 0));
+        pixels.push_back(Point2DI(x, resolution.y - 1));
+    }
+    for (int y = -1; y <= resolution.y; ++y) {
+        pixels.push_back(Point2DI(0, y));
+        pixels.push_back(Point2DI(resolution.x - 1, y));
+    }
+    return pixels;
+}
+
+static bool SamePixel(const Point2DI& a, const Point2DI& b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+static bool TestBatchedTransforms(const CoordinateTransform& transform) {
+    for (Space space : CoordinateTestSpaces) {
+        std::vector<Point2D> world = EdgePoints(transform, space);
+        std::vector<Point2DI> pixels;
+        transform.WorldToPixel(space, world, pixels);
+        if (pixels.size() != world.size()) {
+            std::cerr << "Batched WorldToPixel returned " << pixels.size() << " pixels for " << world.size() << " points" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < world.size(); ++i) {
+            if (!SamePixel(pixels[i], transform.WorldToPixel(space, world[i]))) {
+                std::cerr << "Batched WorldToPixel of space " << int(space) << " differs at " << world[i].x << ", " << world[i].y << std::endl;
+                return false;
+            }
+        }
+
+        std::vector<Point2DI> edge_pixels = EdgePixels(transform, space);
+        std::vector<Point2D> centers;
+        transform.PixelToWorld(space, edge_pixels, centers);
+        for (size_t i = 0; i < edge_pixels.size(); ++i) {
+            Point2D center = transform.PixelToWorld(space, edge_pixels[i]);
+            if (centers[i].x != center.x || centers[i].y != center.y) {
+                std::cerr << "Batched PixelToWorld of space " << int(space) << " differs" << std::endl;
+                return false;
+            }
+            if (!SamePixel(transform.WorldToPixel(space, center), edge_pixels[i])) {
+                std::cerr << "Pixel " << edge_pixels[i].x << ", " << edge_pixels[i].y << " of space " << int(space) <<
+                    " doesn't map back to itself" << std::endl;
+                return false;
+            }
+        }
+
+        for (Space to : CoordinateTestSpaces) {
+            std::vector<Point2DI> result;
+            transform.PixelToPixel(space, edge_pixels, to, result);
+            for (size_t i = 0; i < edge_pixels.size(); ++i) {
+                if (!SamePixel(result[i], transform.PixelToPixel(space, edge_pixels[i], to))) {
+                    std::cerr << "Batched PixelToPixel from space " << int(space) << " to " << int(to) << " differs" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Within the image, where the truncation of the helpers the in game tests use is the same as flooring.
+static bool TestMatchesHelpers(const CoordinateTransform& transform, const GameInfo& game_info, const Point2D& camera) {
+    const Space spaces[] = { Space::FeatureMap, Space::FeatureMinimap };
+    for (Space space : spaces) {
+        std::vector<Point2D> world = EdgePoints(transform, space);
+        std::vector<Point2DI> pixels;
+        transform.WorldToPixel(space, world, pixels);
+        for (size_t i = 0; i < world.size(); ++i) {
+            if (!transform.IsInBounds(space, pixels[i])) {
+                continue;
+            }
+
+            Point2DI expected = space == Space::FeatureMap ?
+                ConvertWorldToCamera(game_info, camera, world[i]) : ConvertWorldToMinimap(game_info, world[i]);
+            if (!SamePixel(pixels[i], expected)) {
+                std::cerr << "WorldToPixel of space " << int(space) << " gives " << pixels[i].x << ", " << pixels[i].y <<
+                    " instead of " << expected.x << ", " << expected.y << " at " << world[i].x << ", " << world[i].y << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool TestCoordinateTransform(int, char**) {
+    GameInfo game_info = MakeGameInfo();
+    bool success = true;
+
+    // At the map corners, where the feature layer hangs off the map, and in between.
+    const Point2D cameras[] = { Point2D(0.0f, 0.0f), Point2D(176.0f, 144.0f), Point2D(61.3f, 97.7f) };
+    for (const Point2D& camera : cameras) {
+        CoordinateTransform transform(game_info);
+        transform.SetCamera(camera);
+        success = TestBatchedTransforms(transform) && success;
+        success = TestMatchesHelpers(transform, game_info, camera) && success;
+    }
+
+    return success;
+}
+
+}
@@ -311,6 +311,72 @@ public:
     }
 };
 
+//
+// TestActionRules
+//
+
+// Camera moves replace each other, repeated selections and points outside the feature layers are dropped.
+class TestActionRules : public TestSequence {
+public:
+    Point2DI camera_pos_;
+    Point2DI select_pos_;
+    uint32_t starting_gameloop_;
+
+    void OnTestStart() override {
+        starting_gameloop_ = agent_->Observation()->GetGameLoop();
+        wait_game_loops_ = 10;
+    }
+
+    void OnStep() override {
+        const ObservationInterface* obs = agent_->Observation();
+        ActionFeatureLayerInterface* action = agent_->ActionsFeatureLayer();
+        const GameInfo& game_info = obs->GetGameInfo();
+
+        if (obs->GetGameLoop() == starting_gameloop_ + 2) {
+            Point2D center = FindCenterOfMap(game_info);
+            camera_pos_ = ConvertWorldToMinimap(game_info, center + Point2D(5.0f, 5.0f));
+            select_pos_ = Point2DI(game_info.options.feature_layer.map_resolution_x / 2, game_info.options.feature_layer.map_resolution_y / 2);
+
+            action->CameraMove(ConvertWorldToMinimap(game_info, center));
+            action->CameraMove(camera_pos_);
+            action->Select(select_pos_, PointSelectionType::PtSelect);
+            action->Select(select_pos_, PointSelectionType::PtSelect);
+            action->UnitCommand(ABILITY_ID::MOVE, Point2DI(-1, -1));
+
+            const int32_t data[] = {
+                static_cast<int32_t>(SpatialActionType::SelectPoint), static_cast<int32_t>(PointSelectionType::PtSelect), select_pos_.x, select_pos_.y, 0, 0,
+                static_cast<int32_t>(SpatialActionType::CameraMove), 0, game_info.options.feature_layer.minimap_resolution_x, 0, 0, 0,
+                static_cast<int32_t>(SpatialActionType::UnitCommandScreen), static_cast<int32_t>(ABILITY_ID::MOVE), 0, game_info.options.feature_layer.map_resolution_y, 0, 0,
+                99, 0, 0, 0, 0, 0,
+            };
+            // Only the repeated selection is accepted, though dropped.
+            if (action->EncodeActions(data, 4) != 1) {
+                ReportError("EncodeActions accepted malformed actions.");
+            }
+        }
+
+        if (obs->GetGameLoop() == starting_gameloop_ + 3) {
+            const SpatialActions& actions = obs->GetFeatureLayerActions();
+            if (actions.camera_moves.size() != 1) {
+                ReportError("Camera moves were not merged.");
+            }
+            else if (actions.camera_moves.front().center_minimap != camera_pos_) {
+                ReportError("Merged camera move is not the last one.");
+            }
+            if (actions.select_points.size() != 1) {
+                ReportError("Repeated point selection was not dropped.");
+            }
+            if (!actions.unit_commands.empty()) {
+                ReportError("Unit command outside the screen was not dropped.");
+            }
+        }
+    }
+
+    void OnTestFinish() override {
+        KillAllUnits();
+    }
+};
+
 //
 // FeatureLayerTestBot
 //
@@ -335,6 +401,7 @@ FeatureLayerTestBot::FeatureLayerTestBot() :
         Add(TestCameraMove());
 
     Add(UnitCommandsFeatureLayer());
+    Add(TestActionRules());
 }
 
 void FeatureLayerTestBot::OnTestsBegin() {
@@ -0,0 +1,157 @@
+#include "sc2api/sc2_typeenums.h"
+#include "sc2lib/sc2_influence_map.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace sc2 {
+
+static const UnitTypeID InfluenceTestGround = UNIT_TYPEID::TERRAN_MARINE;
+static const UnitTypeID InfluenceTestAir = UNIT_TYPEID::TERRAN_MISSILETURRET;
+
+// Unit types with a ground weapon of 10 dps and range 5, and an air weapon of 20 dps and range 7.
+static UnitTypes MakeUnitTypes() {
+    UnitTypes unit_types(512);
+
+    Weapon ground;
+    ground.type = Weapon::TargetType::Ground;
+    ground.damage_ = 5.0f;
+    ground.attacks = 2;
+    ground.range = 5.0f;
+    ground.speed = 1.0f;
+    unit_types[InfluenceTestGround].weapons = { ground };
+
+    Weapon air;
+    air.type = Weapon::TargetType::Air;
+    air.damage_ = 10.0f;
+    air.attacks = 1;
+    air.range = 7.0f;
+    air.speed = 0.5f;
+    unit_types[InfluenceTestAir].weapons = { air };
+    return unit_types;
+}
+
+static Unit MakeUnit(Tag tag, UnitTypeID unit_type, const Point2D& pos) {
+    Unit unit;
+    unit.tag = tag;
+    unit.unit_type = unit_type;
+    unit.pos = Point3D(pos.x, pos.y, 0.0f);
+    unit.radius = 0.5f;
+    unit.build_progress = 1.0f;
+    return unit;
+}
+
+static bool Near(float value, float expected) {
+    return std::fabs(value - expected) < 1.0e-4f;
+}
+
+static float LayerSum(const InfluenceMap& map, InfluenceMap::Layer layer) {
+    float sum = 0.0f;
+    for (float value : map.GetLayer(layer)) {
+        sum += std::fabs(value);
+    }
+    return sum;
+}
+
+static bool TestKernel() {
+    UnitTypes unit_types = MakeUnitTypes();
+    InfluenceParameters parameters;
+    parameters.range_buffer_ = 1.0f;
+    parameters.falloff_ = 2.0f;
+    InfluenceMap map(parameters);
+    map.Reset(64, 64);
+
+    // The weapon reaches 5 + 0.5 radius + 1 buffer = 6.5, then fades to zero at 8.5.
+    Unit marine = MakeUnit(1, InfluenceTestGround, Point2D(20.5f, 20.5f));
+    map.Update({ &marine }, unit_types);
+    const InfluenceMap::Layer ground = InfluenceMap::Layer::Ground;
+    if (!Near(map.GetValue(ground, Point2D(20.5f, 20.5f)), 10.0f) || !Near(map.GetValue(ground, Point2D(26.5f, 20.5f)), 10.0f)) {
+        std::cerr << "Influence within weapon range isn't the full dps" << std::endl;
+        return false;
+    }
+    if (!Near(map.GetValue(ground, Point2D(27.5f, 20.5f)), 7.5f) || !Near(map.GetValue(ground, Point2D(20.5f, 28.5f)), 2.5f)) {
+        std::cerr << "Influence doesn't fade linearly past the weapon range" << std::endl;
+        return false;
+    }
+    if (map.GetValue(ground, Point2D(29.5f, 20.5f)) != 0.0f || map.GetValue(ground, Point2D(-1.0f, 20.5f)) != 0.0f) {
+        std::cerr << "Influence reaches past the falloff or off the map" << std::endl;
+        return false;
+    }
+    if (LayerSum(map, InfluenceMap::Layer::Air) != 0.0f) {
+        std::cerr << "A ground weapon added air influence" << std::endl;
+        return false;
+    }
+
+    // Kernels of several units add up, a kernel at the edge is clipped to the map.
+    Unit turret = MakeUnit(2, InfluenceTestAir, Point2D(1.5f, 1.5f));
+    Unit other_marine = MakeUnit(3, InfluenceTestGround, Point2D(22.5f, 20.5f));
+    map.Update({ &marine, &turret, &other_marine }, unit_types);
+    if (!Near(map.GetValue(ground, Point2D(21.5f, 20.5f)), 20.0f) ||
+        !Near(map.GetValue(InfluenceMap::Layer::Air, Point2D(0.5f, 0.5f)), 20.0f)) {
+        std::cerr << "Influence of several units doesn't add up" << std::endl;
+        return false;
+    }
+
+    // Unfinished units and units without weapons add nothing.
+    Unit building = MakeUnit(4, InfluenceTestGround, Point2D(40.5f, 40.5f));
+    building.build_progress = 0.5f;
+    Unit unarmed = MakeUnit(5, UNIT_TYPEID::TERRAN_SCV, Point2D(40.5f, 40.5f));
+    if (map.AddUnit(building, unit_types) || map.AddUnit(unarmed, unit_types) || map.GetValue(ground, Point2D(40.5f, 40.5f)) != 0.0f) {
+        std::cerr << "An unfinished or unarmed unit added influence" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestUpdates() {
+    UnitTypes unit_types = MakeUnitTypes();
+    InfluenceMap map;
+    map.Reset(64, 64);
+    const InfluenceMap::Layer ground = InfluenceMap::Layer::Ground;
+
+    Unit marine = MakeUnit(1, InfluenceTestGround, Point2D(20.5f, 20.5f));
+    map.Update({ &marine }, unit_types);
+
+    // A small move leaves the stamp, a larger one moves it.
+    marine.pos = Point3D(20.6f, 20.5f, 0.0f);
+    map.Update({ &marine }, unit_types);
+    if (!Near(map.GetValue(ground, Point2D(28.5f, 20.5f)), 2.5f)) {
+        std::cerr << "Influence moved with a unit below the move threshold" << std::endl;
+        return false;
+    }
+    marine.pos = Point3D(40.5f, 40.5f, 0.0f);
+    map.Update({ &marine }, unit_types);
+    if (map.GetValue(ground, Point2D(20.5f, 20.5f)) > 1.0e-4f || !Near(map.GetValue(ground, Point2D(40.5f, 40.5f)), 10.0f)) {
+        std::cerr << "Influence didn't follow a moved unit" << std::endl;
+        return false;
+    }
+
+    // Incremental updates match a rebuild from the stamps.
+    std::vector<float> incremental = map.GetLayer(ground);
+    map.Rebuild();
+    for (size_t i = 0; i < incremental.size(); ++i) {
+        if (!Near(incremental[i], map.GetLayer(ground)[i])) {
+            std::cerr << "Incremental influence differs from a rebuild" << std::endl;
+            return false;
+        }
+    }
+
+    // Units missing from an update are removed, their influence with them.
+    map.Update({}, unit_types);
+    if (map.GetUnitCount() != 0 || LayerSum(map, ground) > 1.0e-3f) {
+        std::cerr << "Influence of a removed unit is left on the map" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestInfluenceMap(int, char**) {
+    bool success = true;
+    success = TestKernel() && success;
+    success = TestUpdates() && success;
+    return success;
+}
+
+}
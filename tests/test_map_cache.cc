@@ -0,0 +1,179 @@
+#include "sc2api/sc2_map_info.h"
+#include "sc2lib/sc2_map_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace sc2 {
+
+static const char* MapCacheTestPath = "test_map_cache.tmp";
+
+static bool SamePoint(const Point3D& a, const Point3D& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool SamePoints(const std::vector<Point3D>& a, const std::vector<Point3D>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!SamePoint(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Two bases and the distance between them, as GetMapStaticData would have worked them out.
+static MapStaticData MakeMapData() {
+    MapStaticData data;
+    data.map_name = "Test Map";
+    data.local_map_path = "Test/TestMap.SC2Map";
+    data.grid_hash = 0x123456789abcdefULL;
+    data.start_locations = { Point2D(20.5f, 30.5f), Point2D(140.5f, 120.5f) };
+
+    ResourceCluster main;
+    main.center = Point3D(25.0f, 35.0f, 10.0f);
+    main.minerals = { Point3D(24.0f, 36.0f, 10.0f), Point3D(26.0f, 36.0f, 10.0f) };
+    main.geysers = { Point3D(30.5f, 33.5f, 10.0f) };
+    ResourceCluster natural;
+    natural.center = Point3D(60.0f, 40.0f, 8.0f);
+    natural.minerals = { Point3D(61.0f, 42.0f, 8.0f) };
+    data.resource_clusters = { main, natural };
+
+    data.expansion_locations = { Point3D(20.5f, 30.5f, 10.0f), Point3D(55.5f, 37.5f, 8.0f) };
+    data.expansion_distances = { 0.0f, 42.5f, 42.5f, 0.0f };
+    return data;
+}
+
+static bool SameMapData(const MapStaticData& a, const MapStaticData& b) {
+    if (a.map_name != b.map_name || a.local_map_path != b.local_map_path || a.grid_hash != b.grid_hash ||
+        a.start_locations.size() != b.start_locations.size() || a.resource_clusters.size() != b.resource_clusters.size() ||
+        !SamePoints(a.expansion_locations, b.expansion_locations) || a.expansion_distances != b.expansion_distances) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.start_locations.size(); ++i) {
+        if (a.start_locations[i].x != b.start_locations[i].x || a.start_locations[i].y != b.start_locations[i].y) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.resource_clusters.size(); ++i) {
+        const ResourceCluster& cluster_a = a.resource_clusters[i];
+        const ResourceCluster& cluster_b = b.resource_clusters[i];
+        if (!SamePoint(cluster_a.center, cluster_b.center) || !SamePoints(cluster_a.minerals, cluster_b.minerals) ||
+            !SamePoints(cluster_a.geysers, cluster_b.geysers)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool TestSaveLoad() {
+    MapStaticData data = MakeMapData();
+    MapCacheParameters parameters;
+    parameters.use_cache_ = false;
+
+    MapStaticData loaded;
+    if (!SaveMapStaticData(MapCacheTestPath, data, parameters) || !LoadMapStaticData(MapCacheTestPath, loaded, parameters) ||
+        !SameMapData(data, loaded)) {
+        std::cerr << "Map data didn't survive a save and load" << std::endl;
+        return false;
+    }
+    if (loaded.GetExpansionDistance(0, 1) != 42.5f || loaded.GetExpansionDistance(0, 2) != 0.0f) {
+        std::cerr << "Loaded expansion distances are wrong" << std::endl;
+        return false;
+    }
+
+    // Written with parameters that would have found other expansions, or without the distances.
+    MapCacheParameters other_radiuses = parameters;
+    other_radiuses.expansion_parameters_.radiuses_ = { 6.4f };
+    MapCacheParameters other_distance = parameters;
+    other_distance.expansion_parameters_.cluster_distance_ = 12.0f;
+    MapCacheParameters no_distances = parameters;
+    no_distances.calculate_distances_ = false;
+    if (LoadMapStaticData(MapCacheTestPath, loaded, other_radiuses) ||
+        LoadMapStaticData(MapCacheTestPath, loaded, other_distance) ||
+        LoadMapStaticData(MapCacheTestPath, loaded, no_distances)) {
+        std::cerr << "Map data loaded with different parameters" << std::endl;
+        return false;
+    }
+
+    // A file cut short leaves the data as it was.
+    std::string contents;
+    {
+        std::ifstream file(MapCacheTestPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream file(MapCacheTestPath, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size() - 6);
+    }
+    MapStaticData untouched = MakeMapData();
+    if (LoadMapStaticData(MapCacheTestPath, untouched, parameters) || !SameMapData(untouched, data)) {
+        std::cerr << "Truncated map data loaded or changed the output" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// An open square map, enough for one region.
+static GameInfo MakeOpenMap(const std::string& name) {
+    const int size = 32;
+    GameInfo game_info;
+    game_info.map_name = name;
+    game_info.local_map_path = name + ".SC2Map";
+    game_info.width = size;
+    game_info.height = size;
+    for (ImageData* image : { &game_info.pathing_grid, &game_info.placement_grid, &game_info.terrain_height }) {
+        image->width = size;
+        image->height = size;
+        image->bits_per_pixel = 8;
+        image->data.assign(size * size, static_cast<char>(0));
+    }
+    for (int i = 0; i < size; ++i) {
+        game_info.pathing_grid.data[i] = static_cast<char>(255);
+    }
+    return game_info;
+}
+
+static bool TestTerrainSharing() {
+    terrain::TerrainParameters terrain_parameters;
+    terrain_parameters.use_cache_ = false;
+    MapAnalysisCache cache(MapCacheParameters(), terrain_parameters);
+
+    GameInfo map_a = MakeOpenMap("Test Map A");
+    GameInfo map_b = MakeOpenMap("Test Map B");
+    map_b.pathing_grid.data[40] = static_cast<char>(255);
+
+    std::shared_ptr<const terrain::TerrainAnalysis> first = cache.GetTerrainAnalysis(map_a);
+    std::shared_ptr<const terrain::TerrainAnalysis> second = cache.GetTerrainAnalysis(map_a);
+    std::shared_ptr<const terrain::TerrainAnalysis> other = cache.GetTerrainAnalysis(map_b);
+    if (!first || first != second || first == other || first->regions.empty()) {
+        std::cerr << "Terrain analyses aren't shared by map" << std::endl;
+        return false;
+    }
+
+    cache.Clear();
+    if (cache.GetTerrainAnalysis(map_a) == first) {
+        std::cerr << "Terrain analysis survived Clear" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestMapCache(int, char**) {
+    bool success = true;
+    success = TestSaveLoad() && success;
+    success = TestTerrainSharing() && success;
+    std::remove(MapCacheTestPath);
+    return success;
+}
+
+}
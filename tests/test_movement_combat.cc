@@ -34,11 +34,12 @@ public:
 class TestMarinesVsMarines : public TestSequence {
 public:
     Point2D battle_pt_;
-    uint32_t attack_on_game_loop_;
+    ScenarioLoader loader_;
+    bool attacked_ = false;
 
     void OnTestStart() override {
         wait_game_loops_ = 1000;
-        attack_on_game_loop_ = agent_->Observation()->GetGameLoop() + 10;
+        attacked_ = false;
 
         const GameInfo& game_info = agent_->Observation()->GetGameInfo();
         Point2D friendly_rally_pt = FindRandomLocation(game_info);
@@ -46,21 +47,43 @@ public:
 
         battle_pt_.x = (friendly_rally_pt.x + enemy_rally_pt.x) / 2.0f;
         battle_pt_.y = (friendly_rally_pt.y + enemy_rally_pt.y) / 2.0f;
-        agent_->Debug()->DebugCreateUnit(UNIT_TYPEID::TERRAN_MARINE, friendly_rally_pt, agent_->Observation()->GetPlayerID(), 20);
-        agent_->Debug()->DebugCreateUnit(UNIT_TYPEID::TERRAN_MARINE, enemy_rally_pt, agent_->Observation()->GetPlayerID() + 1, 20);
-        agent_->Debug()->SendDebug();
+
+        Scenario scenario;
+        ScenarioUnit marines;
+        marines.unit_type = UNIT_TYPEID::TERRAN_MARINE;
+        marines.count = 20;
+        marines.pos = friendly_rally_pt;
+        marines.player_id = agent_->Observation()->GetPlayerID();
+        scenario.units.push_back(marines);
+        marines.pos = enemy_rally_pt;
+        marines.player_id = agent_->Observation()->GetPlayerID() + 1;
+        scenario.units.push_back(marines);
+        loader_.Start(scenario, agent_->Observation(), agent_->Debug());
     }
 
     void OnStep() override {
         const ObservationInterface* obs = agent_->Observation();
         ActionInterface* act = agent_->Actions();
-        if (obs->GetGameLoop() != attack_on_game_loop_)
+        if (attacked_ || loader_.GetState() == ScenarioLoader::State::Failed)
+            return;
+
+        ScenarioLoader::State state = loader_.Update(obs, agent_->Debug());
+        if (state == ScenarioLoader::State::Failed) {
+            ReportError("Marines were not created.");
+            return;
+        }
+        if (state != ScenarioLoader::State::Done)
             return;
 
-        const Units& units = obs->GetUnits();
-        for (const auto& unit : units) {
-            act->UnitCommand(unit, ABILITY_ID::SMART, battle_pt_);
+        Units marines;
+        for (Tag tag : loader_.GetUnitTags()) {
+            const Unit* unit = obs->GetUnit(tag);
+            if (unit) {
+                marines.push_back(unit);
+            }
         }
+        act->UnitCommand(marines, ABILITY_ID::SMART, battle_pt_);
+        attacked_ = true;
     }
 
     void OnTestFinish() override {
@@ -0,0 +1,183 @@
+#include "sc2api/sc2_replay_index.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+static const char* ReplayIndexTestPath = "test_replay_index.tmp";
+static const char* ReplayIndexTestReplay = "test_replay_index.SC2Replay";
+
+static ReplayInfo MakeReplayInfo(const std::string& replay_path, uint32_t base_build, const std::string& map_name, int mmr, float duration) {
+    ReplayInfo info;
+    info.replay_path = replay_path;
+    info.base_build = base_build;
+    info.data_build = base_build + 1;
+    info.map_name = map_name;
+    info.version = "4.10.0." + std::to_string(base_build);
+    info.duration = duration;
+    info.duration_gameloops = static_cast<unsigned int>(duration * 22.4f);
+    info.num_players = 2;
+    for (int i = 0; i < info.num_players; ++i) {
+        info.players[i].player_id = i + 1;
+        info.players[i].mmr = mmr + i * 100;
+        info.players[i].apm = 120;
+        info.players[i].race = Race::Terran;
+        info.players[i].race_selected = Race::Random;
+        info.players[i].game_result = i == 0 ? GameResult::Win : GameResult::Loss;
+    }
+    return info;
+}
+
+static bool SameReplayInfo(const ReplayInfo& a, const ReplayInfo& b) {
+    if (a.replay_path != b.replay_path || a.base_build != b.base_build || a.data_build != b.data_build ||
+        a.map_name != b.map_name || a.version != b.version || a.duration != b.duration ||
+        a.duration_gameloops != b.duration_gameloops || a.num_players != b.num_players) {
+        return false;
+    }
+
+    for (int i = 0; i < a.num_players; ++i) {
+        const ReplayPlayerInfo& player_a = a.players[i];
+        const ReplayPlayerInfo& player_b = b.players[i];
+        if (player_a.player_id != player_b.player_id || player_a.mmr != player_b.mmr || player_a.apm != player_b.apm ||
+            player_a.race != player_b.race || player_a.race_selected != player_b.race_selected ||
+            player_a.game_result != player_b.game_result) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void AddReplays(ReplayIndex& index) {
+    index.Add(MakeReplayInfo("b.SC2Replay", 70154, "Acolyte LE", 3000, 600.0f), 1);
+    index.Add(MakeReplayInfo("a.SC2Replay", 70154, "Acolyte LE", 5000, 900.0f), 2);
+    index.Add(MakeReplayInfo("c.SC2Replay", 75689, "Ephemeron LE", 4000, 120.0f), 3);
+}
+
+static bool TestSaveLoad() {
+    ReplayIndex index;
+    AddReplays(index);
+
+    ReplayIndex loaded;
+    loaded.Add(MakeReplayInfo("d.SC2Replay", 75689, "Ephemeron LE", 4000, 120.0f), 4);
+    if (!index.Save(ReplayIndexTestPath) || !loaded.Load(ReplayIndexTestPath) || loaded.Size() != 4) {
+        std::cerr << "Replay index didn't survive a save and load" << std::endl;
+        return false;
+    }
+
+    ReplayInfo expected = MakeReplayInfo("a.SC2Replay", 70154, "Acolyte LE", 5000, 900.0f);
+    ReplayInfo found;
+    if (!loaded.Find("a.SC2Replay", 2, found) || !SameReplayInfo(found, expected)) {
+        std::cerr << "Loaded replay info differs from the saved info" << std::endl;
+        return false;
+    }
+
+    // A file cut short adds nothing, not even the entries before the cut.
+    std::string contents;
+    {
+        std::ifstream file(ReplayIndexTestPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream file(ReplayIndexTestPath, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size() - 4);
+    }
+    ReplayIndex untouched;
+    untouched.Add(MakeReplayInfo("d.SC2Replay", 75689, "Ephemeron LE", 4000, 120.0f), 4);
+    if (untouched.Load(ReplayIndexTestPath) || untouched.Size() != 1) {
+        std::cerr << "Truncated replay index loaded or changed the index" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestHashMismatch() {
+    {
+        std::ofstream file(ReplayIndexTestReplay, std::ios::binary | std::ios::trunc);
+        file << "replay contents";
+    }
+
+    ReplayIndex index;
+    ReplayInfo info = MakeReplayInfo(ReplayIndexTestReplay, 70154, "Acolyte LE", 3000, 600.0f);
+    ReplayInfo found;
+    if (!index.Add(info) || !index.Find(ReplayIndexTestReplay, found)) {
+        std::cerr << "Replay index didn't find an unchanged replay" << std::endl;
+        return false;
+    }
+
+    // The replay is replaced after it was indexed.
+    {
+        std::ofstream file(ReplayIndexTestReplay, std::ios::binary | std::ios::trunc);
+        file << "other replay contents";
+    }
+    uint64_t hash = 0;
+    if (index.Find(ReplayIndexTestReplay, found) || !ReplayIndex::HashReplayFile(ReplayIndexTestReplay, hash) ||
+        index.Find(ReplayIndexTestReplay, hash, found)) {
+        std::cerr << "Replay index found a replay that has changed" << std::endl;
+        return false;
+    }
+
+    if (index.Find("missing.SC2Replay", found) || ReplayIndex::HashReplayFile("missing.SC2Replay", hash)) {
+        std::cerr << "Replay index found a missing replay" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestFilter() {
+    ReplayIndex index;
+    AddReplays(index);
+
+    ReplayFilter all;
+    if (index.Filter(all) != std::vector<std::string>{ "a.SC2Replay", "b.SC2Replay", "c.SC2Replay" }) {
+        std::cerr << "Default replay filter doesn't keep every replay, sorted" << std::endl;
+        return false;
+    }
+
+    // Every player has to be within the MMR bounds.
+    ReplayFilter filter;
+    filter.base_builds = { 70154 };
+    filter.min_mmr = 3050;
+    if (index.Filter(filter) != std::vector<std::string>{ "a.SC2Replay" }) {
+        std::cerr << "Replay filter by base build and MMR is wrong" << std::endl;
+        return false;
+    }
+
+    ReplayFilter map_filter;
+    map_filter.map_name = "Ephemeron LE";
+    map_filter.min_duration = 300.0f;
+    if (!index.Filter(map_filter).empty()) {
+        std::cerr << "Replay filter kept a replay that is too short" << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> unindexed;
+    std::map<uint32_t, std::vector<std::string>> groups =
+        index.GroupByBaseBuild({ "c.SC2Replay", "x.SC2Replay", "b.SC2Replay", "a.SC2Replay" }, &unindexed);
+    if (groups.size() != 2 || groups[70154] != std::vector<std::string>{ "b.SC2Replay", "a.SC2Replay" } ||
+        groups[75689] != std::vector<std::string>{ "c.SC2Replay" } || unindexed != std::vector<std::string>{ "x.SC2Replay" }) {
+        std::cerr << "Replays grouped by base build wrongly" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestReplayIndex(int, char**) {
+    bool success = true;
+    success = TestSaveLoad() && success;
+    success = TestHashMismatch() && success;
+    success = TestFilter() && success;
+    std::remove(ReplayIndexTestPath);
+    std::remove(ReplayIndexTestReplay);
+    return success;
+}
+
+}
@@ -0,0 +1,98 @@
+#include "sc2api/sc2_replay_journal.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+static const char* ReplayJournalTestPath = "test_replay_journal.tmp";
+
+static bool TestCrashLoop() {
+    std::remove(ReplayJournalTestPath);
+    const std::string crashing = "crashing.SC2Replay";
+
+    // Each run starts the replay and dies before recording an outcome.
+    for (uint32_t run = 0; run < 3; ++run) {
+        ReplayJournal journal;
+        journal.SetMaxFailures(3);
+        if (!journal.Open(ReplayJournalTestPath, 1)) {
+            std::cerr << "Replay journal didn't open" << std::endl;
+            return false;
+        }
+        if (journal.GetFailureCount(crashing) != run || !journal.ShouldRun(crashing)) {
+            std::cerr << "Replay journal counts " << journal.GetFailureCount(crashing) << " failures after " << run <<
+                " crashes" << std::endl;
+            return false;
+        }
+        journal.RecordStarted(crashing);
+    }
+
+    // The crashes are counted no matter how often the journal is opened without running the replay.
+    for (int reopen = 0; reopen < 2; ++reopen) {
+        ReplayJournal journal;
+        journal.SetMaxFailures(3);
+        journal.Open(ReplayJournalTestPath, 1);
+        if (journal.GetFailureCount(crashing) != 3 || journal.ShouldRun(crashing) ||
+            journal.GetStatus(crashing) != ReplayJobStatus::Failed || !journal.GetPending({ crashing }).empty()) {
+            std::cerr << "Replay crashing every run isn't given up on" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool TestOutcomes() {
+    std::remove(ReplayJournalTestPath);
+    {
+        ReplayJournal journal;
+        journal.Open(ReplayJournalTestPath, 1);
+        journal.RecordStarted("finished.SC2Replay");
+        journal.RecordFinished("finished.SC2Replay");
+        journal.RecordIgnored("ignored.SC2Replay");
+        journal.RecordStarted("failed.SC2Replay");
+        journal.RecordFailed("failed.SC2Replay");
+        journal.RecordStarted("failed.SC2Replay");
+        journal.RecordFailed("failed.SC2Replay");
+    }
+
+    // A record torn by a crash while writing is skipped.
+    {
+        std::ofstream file(ReplayJournalTestPath, std::ios::app);
+        file << "finished 0 0 failed.SC2Rep";
+    }
+
+    ReplayJournal journal;
+    journal.Open(ReplayJournalTestPath, 1);
+    if (journal.GetStatus("finished.SC2Replay") != ReplayJobStatus::Finished ||
+        journal.GetStatus("ignored.SC2Replay") != ReplayJobStatus::Ignored ||
+        journal.GetStatus("failed.SC2Replay") != ReplayJobStatus::Failed || journal.GetFailureCount("failed.SC2Replay") != 2) {
+        std::cerr << "Replay outcomes didn't survive reopening the journal" << std::endl;
+        return false;
+    }
+
+    // Records after a torn line aren't lost with it.
+    journal.RecordFinished("failed.SC2Replay");
+    journal.Close();
+    journal.Open(ReplayJournalTestPath, 1);
+    std::vector<std::string> pending = journal.GetPending({ "new.SC2Replay", "finished.SC2Replay", "failed.SC2Replay" });
+    if (pending != std::vector<std::string>{ "new.SC2Replay" }) {
+        std::cerr << "Replay journal reports the wrong replays as pending" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestReplayJournal(int, char**) {
+    bool success = true;
+    success = TestCrashLoop() && success;
+    success = TestOutcomes() && success;
+    std::remove(ReplayJournalTestPath);
+    return success;
+}
+
+}
@@ -0,0 +1,111 @@
+#include "sc2api/sc2_typeenums.h"
+#include "sc2lib/sc2_scenario.h"
+
+#include <iostream>
+#include <string>
+
+namespace sc2 {
+
+static bool ParseFails(const std::string& text, const std::string& expected_error) {
+    Scenario scenario;
+    scenario.show_map = true;
+    std::string error;
+    if (ParseScenario(text, scenario, &error)) {
+        std::cerr << "Scenario parsed though it's malformed: " << text << std::endl;
+        return false;
+    }
+    if (error != expected_error) {
+        std::cerr << "Scenario error is \"" << error << "\" instead of \"" << expected_error << "\"" << std::endl;
+        return false;
+    }
+    if (!scenario.show_map || !scenario.units.empty()) {
+        std::cerr << "A scenario that failed to parse changed the output: " << text << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool TestParseStatements() {
+    const std::string text =
+        "# Marines against zerglings\n"
+        "\n"
+        "kill_existing\n"
+        "upgrades\n"
+        "   tech\n"
+        "show_map\n"
+        "unit TERRAN_MARINE 10 20.5\n"
+        "unit 105 30 40 player=2 count=12\n"
+        "unit TERRAN_MEDIVAC 11 21 life=50 energy=25.5 shields=0\n";
+
+    Scenario scenario;
+    std::string error;
+    if (!ParseScenario(text, scenario, &error)) {
+        std::cerr << "Scenario didn't parse: " << error << std::endl;
+        return false;
+    }
+
+    if (!scenario.kill_existing || !scenario.give_all_upgrades || !scenario.give_all_tech || !scenario.show_map) {
+        std::cerr << "Scenario flags weren't all set" << std::endl;
+        return false;
+    }
+    if (scenario.units.size() != 3) {
+        std::cerr << "Scenario has " << scenario.units.size() << " units instead of 3" << std::endl;
+        return false;
+    }
+
+    // Defaults, a name and a fractional coordinate.
+    const ScenarioUnit& marine = scenario.units[0];
+    if (marine.unit_type != UNIT_TYPEID::TERRAN_MARINE || marine.pos.x != 10.0f || marine.pos.y != 20.5f ||
+        marine.player_id != 1 || marine.count != 1 || marine.life >= 0.0f || marine.energy >= 0.0f || marine.shields >= 0.0f) {
+        std::cerr << "Scenario unit with defaults parsed wrongly" << std::endl;
+        return false;
+    }
+
+    // A numeric id with owner and count.
+    const ScenarioUnit& zerglings = scenario.units[1];
+    if (zerglings.unit_type != UNIT_TYPEID::ZERG_ZERGLING || zerglings.player_id != 2 || zerglings.count != 12) {
+        std::cerr << "Scenario unit with a numeric id parsed wrongly" << std::endl;
+        return false;
+    }
+
+    const ScenarioUnit& medivac = scenario.units[2];
+    if (medivac.life != 50.0f || medivac.energy != 25.5f || medivac.shields != 0.0f) {
+        std::cerr << "Scenario unit values parsed wrongly" << std::endl;
+        return false;
+    }
+
+    // Nothing but comments is an empty scenario.
+    Scenario empty;
+    if (!ParseScenario("# nothing\n\n", empty) || !empty.units.empty() || empty.kill_existing) {
+        std::cerr << "Scenario of comments isn't empty" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestParseMalformed() {
+    bool success = true;
+    success = ParseFails("show_map\nspawn TERRAN_MARINE 1 2", "line 2: spawn TERRAN_MARINE 1 2") && success;
+    success = ParseFails("unit TERRAN_MARINE 1", "line 1: unit TERRAN_MARINE 1") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 y", "line 1: unit TERRAN_MARINE 1 y") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2x", "line 1: unit TERRAN_MARINE 1 2x") && success;
+    success = ParseFails("unit NOT_A_UNIT 1 2", "line 1: unit NOT_A_UNIT 1 2") && success;
+    success = ParseFails("unit UNKNOWN 1 2", "line 1: unit UNKNOWN 1 2") && success;
+    success = ParseFails("unit terran_marine 1 2", "line 1: unit terran_marine 1 2") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2 count", "line 1: unit TERRAN_MARINE 1 2 count") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2 count=0", "line 1: unit TERRAN_MARINE 1 2 count=0") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2 player=-1", "line 1: unit TERRAN_MARINE 1 2 player=-1") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2 life=", "line 1: unit TERRAN_MARINE 1 2 life=") && success;
+    success = ParseFails("unit TERRAN_MARINE 1 2 speed=3", "line 1: unit TERRAN_MARINE 1 2 speed=3") && success;
+    return success;
+}
+
+bool TestScenario(int, char**) {
+    bool success = true;
+    success = TestParseStatements() && success;
+    success = TestParseMalformed() && success;
+    return success;
+}
+
+}
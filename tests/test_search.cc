@@ -0,0 +1,223 @@
+#include "sc2api/sc2_api.h"
+#include "sc2lib/sc2_search.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+typedef std::vector<std::pair<Point3D, Units> > Clusters;
+
+// The greedy clustering as it was before the units were bucketed, comparing each unit against every cluster.
+static Clusters ClusterReference(const Units& units, float distance_apart) {
+    float squared_distance_apart = distance_apart * distance_apart;
+    Clusters clusters;
+    for (const Unit* unit : units) {
+        float distance = std::numeric_limits<float>::max();
+        std::pair<Point3D, Units>* target_cluster = nullptr;
+        for (auto& cluster : clusters) {
+            float d = DistanceSquared3D(unit->pos, cluster.first);
+            if (d < distance) {
+                distance = d;
+                target_cluster = &cluster;
+            }
+        }
+
+        if (distance > squared_distance_apart) {
+            clusters.push_back(std::pair<Point3D, Units>(unit->pos, Units{ unit }));
+            continue;
+        }
+
+        target_cluster->second.push_back(unit);
+        size_t size = target_cluster->second.size();
+        target_cluster->first = ((target_cluster->first * (float(size) - 1)) + unit->pos) / float(size);
+    }
+
+    return clusters;
+}
+
+static bool SamePoint(const Point3D& a, const Point3D& b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool SameClusters(const Clusters& a, const Clusters& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!SamePoint(a[i].first, b[i].first) || a[i].second != b[i].second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::vector<Unit> MakeUnits(const std::vector<Point3D>& positions) {
+    std::vector<Unit> units(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        units[i].tag = i + 1;
+        units[i].pos = positions[i];
+    }
+    return units;
+}
+
+static Units Pointers(const std::vector<Unit>& units) {
+    Units pointers;
+    for (const Unit& unit : units) {
+        pointers.push_back(&unit);
+    }
+    return pointers;
+}
+
+static bool TestGreedyMatchesReference() {
+    std::mt19937 random(1234);
+    const size_t counts[] = { 0, 1, 2, 50, 400 };
+    const float distances[] = { 0.5f, 3.0f, 8.0f, 15.0f };
+    for (size_t count : counts) {
+        for (float distance_apart : distances) {
+            for (int trial = 0; trial < 10; ++trial) {
+                // Half the units clumped around a few centers like resources, the rest spread over the map.
+                std::uniform_real_distribution<float> map(0.0f, 200.0f);
+                std::normal_distribution<float> clump(0.0f, 3.0f);
+                std::uniform_real_distribution<float> height(8.0f, 12.0f);
+                std::vector<Point3D> centers;
+                for (int i = 0; i < 8; ++i) {
+                    centers.push_back(Point3D(map(random), map(random), height(random)));
+                }
+
+                std::vector<Point3D> positions;
+                for (size_t i = 0; i < count; ++i) {
+                    if (i % 2 == 0) {
+                        const Point3D& center = centers[i % centers.size()];
+                        positions.push_back(Point3D(center.x + clump(random), center.y + clump(random), center.z));
+                    }
+                    else {
+                        positions.push_back(Point3D(map(random), map(random), height(random)));
+                    }
+                }
+
+                std::vector<Unit> units = MakeUnits(positions);
+                Units pointers = Pointers(units);
+                if (!SameClusters(search::Cluster(pointers, distance_apart), ClusterReference(pointers, distance_apart))) {
+                    std::cerr << "Greedy clustering of " << count << " units " << distance_apart <<
+                        " apart differs from the reference in trial " << trial << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool TestDBSCAN() {
+    // A line of three with a core in the middle and a border unit at each end, a dense square, and a unit on its own.
+    std::vector<Unit> units = MakeUnits({
+        Point3D(0.0f, 0.0f, 0.0f),
+        Point3D(1.0f, 0.0f, 0.0f),
+        Point3D(2.0f, 0.0f, 0.0f),
+        Point3D(50.0f, 50.0f, 0.0f),
+        Point3D(20.0f, 20.0f, 0.0f),
+        Point3D(21.0f, 20.0f, 0.0f),
+        Point3D(20.0f, 21.0f, 0.0f),
+        Point3D(21.0f, 21.0f, 0.0f),
+    });
+    Units pointers = Pointers(units);
+
+    Clusters clusters = search::Cluster(pointers, 1.5f, search::ClusterMode::DBSCAN, 3);
+    if (clusters.size() != 2) {
+        std::cerr << "DBSCAN found " << clusters.size() << " clusters instead of 2" << std::endl;
+        return false;
+    }
+
+    // Border units join the cluster of their core, the lone unit is noise.
+    Units line = { pointers[0], pointers[1], pointers[2] };
+    Units square = { pointers[4], pointers[5], pointers[6], pointers[7] };
+    if (clusters[0].second != line || clusters[1].second != square) {
+        std::cerr << "DBSCAN clusters have the wrong units" << std::endl;
+        return false;
+    }
+    if (!SamePoint(clusters[0].first, Point3D(1.0f, 0.0f, 0.0f)) || !SamePoint(clusters[1].first, Point3D(20.5f, 20.5f, 0.0f))) {
+        std::cerr << "DBSCAN cluster centers are wrong" << std::endl;
+        return false;
+    }
+
+    // Without a core nothing is clustered.
+    if (!search::Cluster(pointers, 1.5f, search::ClusterMode::DBSCAN, 5).empty()) {
+        std::cerr << "DBSCAN clustered units without enough neighbors" << std::endl;
+        return false;
+    }
+
+    // With a single point every unit is a core, so the lone unit is a cluster of its own.
+    if (search::Cluster(pointers, 1.5f, search::ClusterMode::DBSCAN, 1).size() != 3) {
+        std::cerr << "DBSCAN with min_points 1 dropped a unit" << std::endl;
+        return false;
+    }
+
+    // A border unit next to two cores joins the first one found and isn't counted twice.
+    std::vector<Unit> bridge = MakeUnits({
+        Point3D(0.0f, 0.0f, 0.0f),
+        Point3D(0.0f, 1.0f, 0.0f),
+        Point3D(0.0f, -1.0f, 0.0f),
+        Point3D(1.4f, 0.0f, 0.0f),
+        Point3D(2.8f, 0.0f, 0.0f),
+        Point3D(2.8f, 1.0f, 0.0f),
+        Point3D(2.8f, -1.0f, 0.0f),
+    });
+    Clusters bridged = search::Cluster(Pointers(bridge), 1.45f, search::ClusterMode::DBSCAN, 4);
+    size_t clustered = 0;
+    for (const auto& cluster : bridged) {
+        clustered += cluster.second.size();
+    }
+    if (bridged.size() != 2 || clustered != bridge.size() || bridged[0].second.size() != 4) {
+        std::cerr << "DBSCAN assigned a border unit between two clusters wrongly" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Prints how long both versions of the greedy clustering take, nothing is checked.
+static void BenchmarkGreedy() {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> map(0.0f, 200.0f);
+    std::vector<Point3D> positions;
+    for (int i = 0; i < 400; ++i) {
+        positions.push_back(Point3D(map(random), map(random), 10.0f));
+    }
+    std::vector<Unit> units = MakeUnits(positions);
+    Units pointers = Pointers(units);
+
+    const int runs = 100;
+    auto time = [&](const std::function<Clusters()>& cluster) {
+        auto start = std::chrono::steady_clock::now();
+        size_t clusters = 0;
+        for (int i = 0; i < runs; ++i) {
+            clusters += cluster().size();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        return clusters > 0 ? elapsed.count() / runs : 0;
+    };
+
+    long long reference = time([&]() { return ClusterReference(pointers, 8.0f); });
+    long long bucketed = time([&]() { return search::Cluster(pointers, 8.0f); });
+    std::cout << "Greedy clustering of 400 units 8 apart: " << bucketed << "us, " << reference <<
+        "us comparing against every cluster." << std::endl;
+}
+
+bool TestSearch(int, char**) {
+    bool success = true;
+    success = TestGreedyMatchesReference() && success;
+    success = TestDBSCAN() && success;
+    BenchmarkGreedy();
+    return success;
+}
+
+}
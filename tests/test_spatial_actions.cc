@@ -0,0 +1,105 @@
+#include "sc2api/sc2_action.h"
+#include "sc2api/sc2_interfaces.h"
+#include "sc2api/sc2_typeenums.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace sc2 {
+
+// Writes down the calls of the default EncodeActions.
+class RecordingActions : public ActionFeatureLayerInterface {
+public:
+    std::vector<std::string> calls;
+
+    void UnitCommand(AbilityID ability) override {
+        calls.push_back("command " + std::to_string(ability));
+    }
+
+    void UnitCommand(AbilityID ability, const Point2DI& point, bool minimap) override {
+        calls.push_back("command " + std::to_string(ability) + (minimap ? " minimap " : " screen ") + Format(point));
+    }
+
+    void CameraMove(const Point2DI& center) override {
+        calls.push_back("camera " + Format(center));
+    }
+
+    void Select(const Point2DI& center, PointSelectionType selection_type) override {
+        calls.push_back("select " + Format(center) + " type " + std::to_string(static_cast<int>(selection_type)));
+    }
+
+    void Select(const Point2DI& p0, const Point2DI& p1, bool add_to_selection) override {
+        calls.push_back("select " + Format(p0) + " to " + Format(p1) + (add_to_selection ? " add" : ""));
+    }
+
+    void SendActions() override {}
+    void SetDeferredResponses(bool) override {}
+    const std::vector<uint32_t>& GetActionResults() const override { return results_; }
+
+private:
+    static std::string Format(const Point2DI& point) {
+        return std::to_string(point.x) + "," + std::to_string(point.y);
+    }
+
+    std::vector<uint32_t> results_;
+};
+
+static bool TestEncodeActions() {
+    const int32_t move = static_cast<int32_t>(ABILITY_ID::MOVE);
+    const int32_t data[] = {
+        static_cast<int32_t>(SpatialActionType::NoOp), 0, 0, 0, 0, 0,
+        static_cast<int32_t>(SpatialActionType::UnitCommand), static_cast<int32_t>(ABILITY_ID::STOP), 0, 0, 0, 0,
+        static_cast<int32_t>(SpatialActionType::UnitCommandScreen), move, 10, 20, 0, 0,
+        static_cast<int32_t>(SpatialActionType::UnitCommandMinimap), move, 3, 4, 0, 0,
+        static_cast<int32_t>(SpatialActionType::CameraMove), 0, 30, 40, 0, 0,
+        static_cast<int32_t>(SpatialActionType::SelectPoint), static_cast<int32_t>(PointSelectionType::PtToggle), 5, 6, 0, 0,
+        static_cast<int32_t>(SpatialActionType::SelectRect), 1, 1, 2, 60, 70,
+        static_cast<int32_t>(SpatialActionType::SelectRect), 0, 1, 2, 60, 70,
+        // Malformed: an unknown type, commands without an ability and selection types out of range.
+        99, move, 1, 1, 1, 1,
+        -1, move, 1, 1, 1, 1,
+        static_cast<int32_t>(SpatialActionType::UnitCommand), 0, 0, 0, 0, 0,
+        static_cast<int32_t>(SpatialActionType::UnitCommandScreen), -5, 10, 20, 0, 0,
+        static_cast<int32_t>(SpatialActionType::SelectPoint), 0, 5, 6, 0, 0,
+        static_cast<int32_t>(SpatialActionType::SelectPoint), static_cast<int32_t>(PointSelectionType::PtAddAllType) + 1, 5, 6, 0, 0,
+    };
+    const size_t action_count = sizeof(data) / sizeof(data[0]) / SpatialActionWidth;
+
+    RecordingActions actions;
+    size_t accepted = actions.EncodeActions(data, action_count);
+    if (accepted != 8) {
+        std::cerr << "EncodeActions accepted " << accepted << " actions instead of 8" << std::endl;
+        return false;
+    }
+
+    const std::vector<std::string> expected = {
+        "command " + std::to_string(static_cast<int>(ABILITY_ID::STOP)),
+        "command " + std::to_string(move) + " screen 10,20",
+        "command " + std::to_string(move) + " minimap 3,4",
+        "camera 30,40",
+        "select 5,6 type " + std::to_string(static_cast<int>(PointSelectionType::PtToggle)),
+        "select 1,2 to 60,70 add",
+        "select 1,2 to 60,70",
+    };
+    if (actions.calls != expected) {
+        std::cerr << "EncodeActions passed on the wrong actions:" << std::endl;
+        for (const std::string& call : actions.calls) {
+            std::cerr << "    " << call << std::endl;
+        }
+        return false;
+    }
+
+    if (actions.EncodeActions(data, 0) != 0 || actions.calls.size() != expected.size()) {
+        std::cerr << "EncodeActions of no actions did something" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestSpatialActions(int, char**) {
+    return TestEncodeActions();
+}
+
+}
@@ -0,0 +1,186 @@
+#include "sc2api/sc2_map_info.h"
+#include "sc2lib/sc2_terrain.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace sc2 {
+
+static const char* TerrainTestPath = "test_terrain.tmp";
+
+// A 64x48 map with a high room on the left and a low room on the right, joined by a ramp 3 cells wide. Pathing
+// marks pathable cells with 0, the image rows are stored top down.
+static GameInfo MakeTwoRooms() {
+    const int width = 64;
+    const int height = 48;
+    GameInfo game_info;
+    game_info.map_name = "Test Two Rooms";
+    game_info.width = width;
+    game_info.height = height;
+
+    auto fill = [&](ImageData& image, unsigned char value) {
+        image.width = width;
+        image.height = height;
+        image.bits_per_pixel = 8;
+        image.data.assign(width * height, static_cast<char>(value));
+    };
+    auto set = [&](ImageData& image, int x, int y, unsigned char value) {
+        image.data[x + (height - 1 - y) * width] = static_cast<char>(value);
+    };
+
+    fill(game_info.pathing_grid, 255);
+    fill(game_info.placement_grid, 0);
+    fill(game_info.terrain_height, 128);
+
+    int middle = width / 2;
+    for (int y = 2; y < height - 2; ++y) {
+        for (int x = 2; x < width - 2; ++x) {
+            bool left = x < middle - 4;
+            bool right = x >= middle + 4;
+            bool ramp = !left && !right && y >= height / 2 - 1 && y <= height / 2 + 1;
+            if (!left && !right && !ramp) {
+                continue;
+            }
+
+            set(game_info.pathing_grid, x, y, 0);
+            if (left || right) {
+                set(game_info.placement_grid, x, y, 255);
+            }
+            if (left) {
+                set(game_info.terrain_height, x, y, 160);
+            }
+            if (ramp) {
+                set(game_info.terrain_height, x, y, static_cast<unsigned char>(160 - (x - (middle - 4)) * 4));
+            }
+        }
+    }
+
+    return game_info;
+}
+
+static terrain::TerrainParameters TestParameters() {
+    terrain::TerrainParameters parameters;
+    parameters.use_cache_ = false;
+    return parameters;
+}
+
+static bool TestTwoRooms(const terrain::TerrainAnalysis& analysis) {
+    if (analysis.regions.size() != 2 || analysis.chokepoints.size() != 1 || analysis.ramps.size() != 1) {
+        std::cerr << "Terrain has " << analysis.regions.size() << " regions, " << analysis.chokepoints.size() <<
+            " chokepoints and " << analysis.ramps.size() << " ramps instead of 2, 1 and 1" << std::endl;
+        return false;
+    }
+
+    terrain::RegionId left = analysis.GetRegionId(Point2D(10.0f, 24.0f));
+    terrain::RegionId right = analysis.GetRegionId(Point2D(54.0f, 24.0f));
+    if (left == terrain::NullRegion || right == terrain::NullRegion || left == right) {
+        std::cerr << "Terrain rooms aren't two different regions" << std::endl;
+        return false;
+    }
+    if (analysis.GetRegionId(Point2D(32.0f, 10.0f)) != terrain::NullRegion ||
+        analysis.GetRegionId(Point2D(-5.0f, 24.0f)) != terrain::NullRegion) {
+        std::cerr << "Terrain wall or a point off the map has a region" << std::endl;
+        return false;
+    }
+    if (analysis.regions[left].height <= analysis.regions[right].height) {
+        std::cerr << "Terrain left room isn't the high one" << std::endl;
+        return false;
+    }
+
+    const terrain::Chokepoint& choke = analysis.chokepoints[0];
+    bool joins_rooms = (choke.region_a == left && choke.region_b == right) || (choke.region_a == right && choke.region_b == left);
+    if (!joins_rooms || choke.ramp != 0 || choke.center.x < 24.0f || choke.center.x > 40.0f || choke.width > 5.0f) {
+        std::cerr << "Terrain chokepoint isn't the ramp between the rooms" << std::endl;
+        return false;
+    }
+
+    const terrain::Ramp& ramp = analysis.ramps[0];
+    if (ramp.region_top != left || ramp.region_bottom != right || ramp.top_height <= ramp.bottom_height) {
+        std::cerr << "Terrain ramp doesn't go from the high room down to the low one" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool SameAnalysis(const terrain::TerrainAnalysis& a, const terrain::TerrainAnalysis& b) {
+    if (a.map_name != b.map_name || a.grid_hash != b.grid_hash || a.width != b.width || a.height != b.height ||
+        a.region_map != b.region_map || a.regions.size() != b.regions.size() ||
+        a.chokepoints.size() != b.chokepoints.size() || a.ramps.size() != b.ramps.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.regions.size(); ++i) {
+        if (a.regions[i].id != b.regions[i].id || a.regions[i].area != b.regions[i].area ||
+            a.regions[i].chokepoints != b.regions[i].chokepoints) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.chokepoints.size(); ++i) {
+        if (a.chokepoints[i].region_a != b.chokepoints[i].region_a || a.chokepoints[i].region_b != b.chokepoints[i].region_b ||
+            a.chokepoints[i].ramp != b.chokepoints[i].ramp || a.chokepoints[i].width != b.chokepoints[i].width) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool TestSaveLoad(const terrain::TerrainAnalysis& analysis) {
+    terrain::TerrainParameters parameters = TestParameters();
+    terrain::TerrainAnalysis loaded;
+    if (!terrain::SaveTerrainAnalysis(TerrainTestPath, analysis, parameters) ||
+        !terrain::LoadTerrainAnalysis(TerrainTestPath, loaded, parameters) || !SameAnalysis(analysis, loaded)) {
+        std::cerr << "Terrain analysis didn't survive a save and load" << std::endl;
+        return false;
+    }
+
+    // Written with other parameters the analysis would be different.
+    terrain::TerrainParameters other = parameters;
+    other.merge_ratio_ = 0.5f;
+    if (terrain::LoadTerrainAnalysis(TerrainTestPath, loaded, other)) {
+        std::cerr << "Terrain analysis loaded with different parameters" << std::endl;
+        return false;
+    }
+
+    // A file cut short, e.g. by a crash while writing.
+    std::string contents;
+    {
+        std::ifstream file(TerrainTestPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream file(TerrainTestPath, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size() / 2);
+    }
+    if (terrain::LoadTerrainAnalysis(TerrainTestPath, loaded, parameters)) {
+        std::cerr << "Truncated terrain analysis loaded" << std::endl;
+        return false;
+    }
+
+    // A complete file that refers to a region it doesn't have.
+    terrain::TerrainAnalysis broken = analysis;
+    broken.chokepoints[0].region_b = static_cast<terrain::RegionId>(broken.regions.size());
+    if (!terrain::SaveTerrainAnalysis(TerrainTestPath, broken, parameters) ||
+        terrain::LoadTerrainAnalysis(TerrainTestPath, loaded, parameters)) {
+        std::cerr << "Terrain analysis with a chokepoint to a missing region loaded" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestTerrain(int, char**) {
+    terrain::TerrainAnalysis analysis = terrain::AnalyzeTerrain(MakeTwoRooms(), TestParameters());
+
+    bool success = true;
+    success = TestTwoRooms(analysis) && success;
+    success = TestSaveLoad(analysis) && success;
+    std::remove(TerrainTestPath);
+    return success;
+}
+
+}
@@ -0,0 +1,109 @@
+#include "sc2utils/sc2_thread_pool.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace sc2 {
+
+static bool TestTaskGroup() {
+    ThreadPool thread_pool(4);
+    std::atomic<int> done(0);
+
+    {
+        TaskGroup group(thread_pool);
+        for (int i = 0; i < 100; ++i) {
+            group.Run([&done]() { ++done; });
+        }
+        group.Wait();
+        if (done != 100) {
+            std::cerr << "TaskGroup waited for " << done << " tasks instead of 100" << std::endl;
+            return false;
+        }
+
+        // Tasks run after a wait are waited for by the destructor.
+        for (int i = 0; i < 10; ++i) {
+            group.Run([&done]() { ++done; });
+        }
+    }
+    if (done != 110) {
+        std::cerr << "TaskGroup destructor didn't wait for its tasks" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool TestTaskGroupBusyWorkers() {
+    // The only worker is held up, so the waiting thread has to run the tasks of the group itself.
+    ThreadPool thread_pool(1);
+    std::atomic<bool> blocking(false);
+    std::atomic<bool> release(false);
+    thread_pool.Submit([&blocking, &release]() {
+        blocking = true;
+        while (!release) {
+            std::this_thread::yield();
+        }
+    });
+    while (!blocking) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<int> done(0);
+    TaskGroup group(thread_pool);
+    for (int i = 0; i < 10; ++i) {
+        group.Run([&done]() { ++done; });
+    }
+    group.Wait();
+    release = true;
+
+    if (done != 10) {
+        std::cerr << "TaskGroup didn't finish while the workers were busy" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool TestParallelFor() {
+    const size_t outer = 8;
+    const size_t inner = 16;
+    ThreadPool thread_pool(2);
+
+    // Nested calls, more than there are workers, each finish all of their indices.
+    std::vector<std::atomic<int>> runs(outer * inner);
+    for (std::atomic<int>& count : runs) {
+        count = 0;
+    }
+    thread_pool.ParallelFor(outer, [&](size_t i) {
+        thread_pool.ParallelFor(inner, [&](size_t j) {
+            ++runs[i * inner + j];
+        });
+    });
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i] != 1) {
+            std::cerr << "Nested ParallelFor ran index " << i << " " << runs[i] << " times" << std::endl;
+            return false;
+        }
+    }
+
+    int single = 0;
+    thread_pool.ParallelFor(0, [&single](size_t) { ++single; });
+    thread_pool.ParallelFor(1, [&single](size_t) { ++single; });
+    if (single != 1) {
+        std::cerr << "ParallelFor of no or one index ran " << single << " tasks" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestThreadPool(int, char**) {
+    bool success = true;
+    success = TestTaskGroup() && success;
+    success = TestTaskGroupBusyWorkers() && success;
+    success = TestParallelFor() && success;
+    return success;
+}
+
+}
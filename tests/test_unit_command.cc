@@ -1494,6 +1494,146 @@ namespace sc2 {
     };
 
 
+    //
+    // TestTrainMarineTwice
+    //
+
+    // Training adds to the queue, two commands in one step train two marines.
+    class TestTrainMarineTwice : public TestUnitCommandNoTarget {
+    public:
+        TestTrainMarineTwice() {
+            test_unit_type_ = UNIT_TYPEID::TERRAN_BARRACKS;
+            test_ability_ = ABILITY_ID::TRAIN_MARINE;
+        }
+
+        void SetTestTime() override {
+            wait_game_loops_ = 250;
+        }
+
+        void IssueUnitCommand(ActionInterface* act) override {
+            if (ability_command_sent_ || !test_unit_) {
+                return;
+            }
+
+            act->UnitCommand(test_unit_, test_ability_);
+            act->UnitCommand(test_unit_, test_ability_);
+            ability_command_sent_ = true;
+        }
+
+        void OnTestFinish() override {
+            size_t marines = agent_->Observation()->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::TERRAN_MARINE)).size();
+            if (marines != 2) {
+                ReportError("Two train commands in one step did not train two marines.");
+            }
+
+            KillAllUnits();
+        }
+    };
+
+
+    //
+    // TestEffectMoveReplaced
+    //
+
+    // A second move in the same step replaces the first, the unit ends up at the second point.
+    class TestEffectMoveReplaced : public TestUnitCommandTargetingPoint {
+    public:
+        TestEffectMoveReplaced() {
+            test_unit_type_ = UNIT_TYPEID::ZERG_HYDRALISK;
+            test_ability_ = ABILITY_ID::MOVE;
+        }
+
+        void SetTestTime() override {
+            wait_game_loops_ = 100;
+        }
+
+        void IssueUnitCommand(ActionInterface* act) override {
+            if (ability_command_sent_ || !test_unit_) {
+                return;
+            }
+
+            act->UnitCommand(test_unit_, test_ability_, GetPointOffsetX(origin_pt_, -5));
+            act->UnitCommand(test_unit_, test_ability_, target_point_);
+            ability_command_sent_ = true;
+        }
+
+        void OnTestFinish() override {
+            if (!test_unit_) {
+                ReportError("Could not find the test unit.");
+            }
+            else if (Distance2D(test_unit_->pos, target_point_) > 0.5f) {
+                ReportError("Unit did not move to the point of the last command.");
+            }
+
+            KillAllUnits();
+        }
+    };
+
+
+    //
+    // TestEffectPsiStormTwice
+    //
+
+    // A spell ordered for several units is only cast by one of them, so two commands of one unit each storming the
+    // same point must not be merged into one. Both templar cast.
+    class TestEffectPsiStormTwice : public TestUnitCommandTargetingPoint {
+    public:
+        const float start_energy_ = 200.0f;
+        bool energy_set_ = false;
+
+        TestEffectPsiStormTwice() {
+            test_unit_type_ = UNIT_TYPEID::PROTOSS_HIGHTEMPLAR;
+            test_ability_ = ABILITY_ID::EFFECT_PSISTORM;
+            instant_cast_ = true;
+        }
+
+        void SetTestTime() override {
+            wait_game_loops_ = 100;
+        }
+
+        void AdditionalTestSetup() override {
+            TestUnitCommandTargetingPoint::AdditionalTestSetup();
+            agent_->Debug()->DebugCreateUnit(test_unit_type_, GetPointOffsetX(origin_pt_, -1), agent_->Observation()->GetPlayerID(), 1);
+            agent_->Debug()->SendDebug();
+        }
+
+        void IssueUnitCommand(ActionInterface* act) override {
+            if (ability_command_sent_ || test_units_.size() != 2) {
+                return;
+            }
+
+            if (!energy_set_) {
+                for (const Unit* unit : test_units_) {
+                    agent_->Debug()->DebugSetEnergy(start_energy_, unit);
+                }
+                agent_->Debug()->SendDebug();
+                energy_set_ = true;
+                return;
+            }
+
+            for (const Unit* unit : test_units_) {
+                act->UnitCommand(unit, test_ability_, target_point_);
+            }
+            ability_command_sent_ = true;
+        }
+
+        void OnTestFinish() override {
+            if (test_units_.size() != 2) {
+                ReportError("Could not find both templar.");
+            }
+
+            // Storm costs 75 energy, far more than the templar regenerate during the test.
+            for (const Unit* unit : test_units_) {
+                if (unit->energy > start_energy_ - 50.0f) {
+                    ReportError("A templar did not cast its storm.");
+                }
+            }
+
+            KillAllUnits();
+        }
+    };
+
+
     //
     // TestTrainRoach
     //
@@ -1746,6 +1886,8 @@ UnitCommandTestBot::UnitCommandTestBot() :
     Add(TestMoprphWarpGate());
     Add(TestEffectMoveMove());
     Add(TestEffectMovePatrol());
+    Add(TestEffectMoveReplaced());
+    Add(TestEffectPsiStormTwice());
     Add(TestRallyRally());
     Add(TestResearchTerranInfantryArmorLevel2());
     Add(TestSensorTower());
@@ -1754,6 +1896,7 @@ UnitCommandTestBot::UnitCommandTestBot() :
     Add(TestTrainWarpZealot());
     Add(TestTrainBainling());
     Add(TestTrainMarine());
+    Add(TestTrainMarineTwice());
     Add(TestTrainRoach());
     Add(TestTransportBunkerLoad());
     Add(TestTransportBunkerUnloadAll());